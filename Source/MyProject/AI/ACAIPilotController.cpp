@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ACAIPilotController.h"
+
+#include "AIPilotSubsystem.h"
+#include "Engine/World.h"
+#include "MyProject/Aircraft/AAircraftBase.h"
+#include "MyProject/Aircraft/AircraftSpatialSubsystem.h"
+#include "MyProject/Aircraft/TerrainHeightfieldSubsystem.h"
+
+AACAIPilotController::AACAIPilotController()
+{
+	// Scheduled by UAIPilotSubsystem and the flight step, never ticks on its own
+	PrimaryActorTick.bCanEverTick = false;
+	bWantsPlayerState = false;
+}
+
+void AACAIPilotController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	PilotSubsystem = GetWorld()->GetSubsystem<UAIPilotSubsystem>();
+	Terrain = GetWorld()->GetSubsystem<UTerrainHeightfieldSubsystem>();
+	if (PilotSubsystem)
+	{
+		PilotSubsystem->RegisterPilot(this);
+	}
+}
+
+void AACAIPilotController::OnUnPossess()
+{
+	if (PilotSubsystem)
+	{
+		PilotSubsystem->UnregisterPilot(this);
+	}
+
+	Super::OnUnPossess();
+}
+
+bool AACAIPilotController::HasLineOfSight(const AAAircraftBase* Self, const AAAircraftBase* Other) const
+{
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(AIPilotSight), false, Self);
+	Params.AddIgnoredActor(Other);
+	return !GetWorld()->LineTraceTestByChannel(Self->GetActorLocation(), Other->GetActorLocation(), ECC_Visibility, Params);
+}
+
+void AACAIPilotController::Think()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AIPilotThink);
+
+	const AAAircraftBase* Self = Cast<AAAircraftBase>(GetPawn());
+	const UAircraftSpatialSubsystem* Spatial = GetWorld()->GetSubsystem<UAircraftSpatialSubsystem>();
+	if (!Self || !Spatial) return;
+
+	const FVector Location = Self->GetActorLocation();
+	const FVector Forward = Self->GetActorForwardVector();
+	const double CosThreatCone = FMath::Cos(FMath::DegreesToRadians(ThreatConeDegrees));
+
+	// One extra candidate, the nearest aircraft is usually ourselves
+	TArray<AAAircraftBase*> Candidates;
+	Spatial->QueryNearest(Location, MaxSightChecks + 1, Candidates, DetectionRange);
+
+	Target = nullptr;
+	Threat = nullptr;
+	for (AAAircraftBase* Other : Candidates)
+	{
+		if (Other == Self || !HasLineOfSight(Self, Other)) continue;
+
+		const FVector OtherToSelf = Location - Other->GetActorLocation();
+		const FVector OtherToSelfDir = OtherToSelf.GetSafeNormal();
+		const bool bBehindUs = FVector::DotProduct(Forward, OtherToSelfDir) > 0.0;
+		const bool bAimedAtUs = FVector::DotProduct(Other->GetActorForwardVector(), OtherToSelfDir) >= CosThreatCone;
+
+		if (!Threat.IsValid() && bBehindUs && bAimedAtUs && OtherToSelf.SizeSquared() <= FMath::Square(EvadeRange))
+		{
+			Threat = Other;
+		}
+		if (!Target.IsValid())
+		{
+			Target = Other;
+		}
+		if (Target.IsValid() && Threat.IsValid()) break;
+	}
+
+	Mode = Threat.IsValid() ? EAIPilotMode::Evade : Target.IsValid() ? EAIPilotMode::Pursue : EAIPilotMode::Patrol;
+}
+
+FVector AACAIPilotController::GetDesiredDirection(const FFlightPilotState& State)
+{
+	const FVector Forward = State.Rotation.GetForwardVector();
+
+	switch (Mode)
+	{
+	case EAIPilotMode::Pursue:
+		if (const AAAircraftBase* Other = Target.Get())
+		{
+			// Lead the target by the time it takes us to close the distance at our current speed
+			const FVector TargetLocation = Other->GetActorLocation();
+			const double TimeToTarget = FVector::Dist(TargetLocation, State.Location) / FMath::Max(State.Velocity.Size(), 1000.0);
+			return TargetLocation + Other->GetVelocity() * FMath::Min(TimeToTarget, 3.0) - State.Location;
+		}
+		break;
+
+	case EAIPilotMode::Evade:
+		if (const AAAircraftBase* Other = Threat.Get())
+		{
+			// Break turn: away from the threat and hard across its line of fire
+			const FVector Away = (State.Location - Other->GetActorLocation()).GetSafeNormal();
+			return Away + State.Rotation.GetRightVector() + FVector::UpVector * 0.3;
+		}
+		break;
+
+	case EAIPilotMode::Patrol:
+		break;
+	}
+
+	if (PatrolWaypoints.IsEmpty())
+	{
+		// Nothing to do: hold a level heading
+		return FVector(Forward.X, Forward.Y, 0.0);
+	}
+
+	WaypointIndex %= PatrolWaypoints.Num();
+	if (FVector::DistSquared(PatrolWaypoints[WaypointIndex], State.Location) <= FMath::Square(WaypointAcceptRadius))
+	{
+		WaypointIndex = (WaypointIndex + 1) % PatrolWaypoints.Num();
+	}
+	return PatrolWaypoints[WaypointIndex] - State.Location;
+}
+
+void AACAIPilotController::UpdateControls(const FFlightPilotState& State, float StepDeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AIPilotControl);
+
+	AAAircraftBase* Self = Cast<AAAircraftBase>(GetPawn());
+	if (!Self) return;
+
+	FVector Direction = GetDesiredDirection(State).GetSafeNormal();
+
+	// Radar altitude here and where we are heading, so rising ground is seen before we reach it
+	double Altitude = State.Location.Z;
+	if (Terrain && !Terrain->GetHeightfield().IsEmpty())
+	{
+		const FVector Ahead = State.Location + State.Velocity * TerrainLookAheadSeconds;
+		Altitude = FMath::Min(Terrain->GetRadarAltitude(State.Location), State.Location.Z - Terrain->GetHeightfield().GetHeight(Ahead.X, Ahead.Y));
+	}
+	if (Altitude < MinAltitude)
+	{
+		Direction = (Direction.GetSafeNormal2D() + FVector::UpVector).GetSafeNormal();
+	}
+
+	SteerTowards(Self, State, Direction, Mode == EAIPilotMode::Patrol ? 0.7f : 1.f);
+}
+
+void AACAIPilotController::SteerTowards(AAAircraftBase* Self, const FFlightPilotState& State, const FVector& Direction, float Thrust) const
+{
+	const FVector Forward = State.Rotation.GetForwardVector();
+	if (Direction.IsNearlyZero())
+	{
+		Self->SetAerialInputs(Thrust, FVector2D::ZeroVector, 0.f);
+		return;
+	}
+
+	// World angular velocity that turns the nose onto Direction, proportional to the remaining angle
+	const FVector Axis = FVector::CrossProduct(Forward, Direction);
+	const double SinAngle = Axis.Size();
+	const double Angle = FMath::Atan2(SinAngle, FVector::DotProduct(Forward, Direction));
+	const FVector TurnRate = SinAngle > UE_KINDA_SMALL_NUMBER ? Axis / SinAngle * (FMath::RadiansToDegrees(Angle) * SteeringGain) : FVector::ZeroVector;
+
+	const FVector Rates = Self->GetControlRates();
+	auto ToInput = [](double Rate, double MaxRate) { return MaxRate > UE_KINDA_SMALL_NUMBER ? static_cast<float>(FMath::Clamp(Rate / MaxRate, -1.0, 1.0)) : 0.f; };
+
+	const FVector2D Steering(ToInput(TurnRate.Y, Rates.Y), ToInput(TurnRate.X, Rates.X));
+	Self->SetAerialInputs(Thrust, Steering, ToInput(TurnRate.Z, Rates.Z));
+}
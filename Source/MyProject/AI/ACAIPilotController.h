@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+#include "MyProject/Aircraft/FlightStep.h"
+#include "ACAIPilotController.generated.h"
+
+class AAAircraftBase;
+class UAIPilotSubsystem;
+class UTerrainHeightfieldSubsystem;
+
+UENUM(BlueprintType)
+enum class EAIPilotMode : uint8
+{
+	Patrol  UMETA(DisplayName="Patrol"),
+	Pursue  UMETA(DisplayName="Pursue"),
+	Evade   UMETA(DisplayName="Evade"),
+};
+
+/**
+ * Server-side bot pilot. Split in two halves with very different costs:
+ *  - Think (target selection, line of sight, mode) is scheduled by UAIPilotSubsystem under a per-frame budget.
+ *  - UpdateControls turns the last decision into stick inputs and runs before every flight step.
+ */
+UCLASS()
+class MYPROJECT_API AACAIPilotController : public AController
+{
+	GENERATED_BODY()
+
+public:
+	AACAIPilotController();
+
+	void Think();
+	void UpdateControls(const FFlightPilotState& State, float StepDeltaTime);
+
+	EAIPilotMode GetMode() const { return Mode; }
+
+	/** World time the subsystem should run Think again */
+	double NextThinkTime = 0.0;
+
+	// PATROL
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Patrol")
+	TArray<FVector> PatrolWaypoints;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Patrol")
+	float WaypointAcceptRadius = 20000.f;
+	/** Height above the terrain (absolute Z on maps without a heightfield) the pilot climbs back to */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Patrol")
+	float MinAltitude = 30000.f;
+	/** Terrain is also checked where the current velocity takes us this many seconds ahead */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Patrol")
+	float TerrainLookAheadSeconds = 3.f;
+
+	// COMBAT
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Combat")
+	float DetectionRange = 500000.f;
+	/** Enemies closer than this, behind us and pointing at us, make the pilot break off and evade */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Combat")
+	float EvadeRange = 150000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Combat")
+	float ThreatConeDegrees = 20.f;
+	/** Line-of-sight traces one Think may spend on candidates, closest first */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Combat")
+	int32 MaxSightChecks = 3;
+
+	// CONTROL
+	/** Turn rate (deg/s) asked for per degree of heading error */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="AI|Control")
+	float SteeringGain = 2.f;
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+
+private:
+	bool HasLineOfSight(const AAAircraftBase* Self, const AAAircraftBase* Other) const;
+	FVector GetDesiredDirection(const FFlightPilotState& State);
+	void SteerTowards(AAAircraftBase* Self, const FFlightPilotState& State, const FVector& Direction, float Thrust) const;
+
+	EAIPilotMode Mode = EAIPilotMode::Patrol;
+	TWeakObjectPtr<AAAircraftBase> Target;
+	TWeakObjectPtr<AAAircraftBase> Threat;
+	int32 WaypointIndex = 0;
+
+	UPROPERTY()
+	TObjectPtr<UAIPilotSubsystem> PilotSubsystem;
+	UPROPERTY()
+	TObjectPtr<UTerrainHeightfieldSubsystem> Terrain;
+};
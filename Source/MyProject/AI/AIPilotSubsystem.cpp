@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AIPilotSubsystem.h"
+
+#include "ACAIPilotController.h"
+#include "Engine/World.h"
+#include "MyProject/Aircraft/AEnemyAircraft.h"
+
+DEFINE_STAT(STAT_AIPilotThink);
+DEFINE_STAT(STAT_AIPilotControl);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Thinks"), STAT_AIPilotThinks, STATGROUP_AIPilot);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pilots"), STAT_AIPilotPilots, STATGROUP_AIPilot);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overdue Pilots"), STAT_AIPilotOverdue, STATGROUP_AIPilot);
+
+static TAutoConsoleVariable<float> CVarAIThinkBudgetMs(
+	TEXT("ac.AI.ThinkBudgetMs"),
+	0.5f,
+	TEXT("Game-thread milliseconds per frame bot pilots may spend on target selection and line of sight."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAIThinkInterval(
+	TEXT("ac.AI.ThinkInterval"),
+	0.25f,
+	TEXT("Seconds between two decisions of the same bot pilot when the budget allows."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdAISpawnBots(
+	TEXT("ac.AI.SpawnBots"),
+	TEXT("ac.AI.SpawnBots <Count>: server only, spawns Count AAEnemyAircraft spread around the world origin. Watch 'stat AIPilot'."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || World->GetNetMode() == NM_Client) return;
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 200;
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 i = 0; i < Count; ++i)
+		{
+			const FVector Location(FMath::FRandRange(-1000000.0, 1000000.0), FMath::FRandRange(-1000000.0, 1000000.0), FMath::FRandRange(100000.0, 300000.0));
+			World->SpawnActor<AAEnemyAircraft>(Location, FRotator(0.0, FMath::FRandRange(0.0, 360.0), 0.0), SpawnParams);
+		}
+	}));
+
+bool UAIPilotSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAIPilotSubsystem::Deinitialize()
+{
+	Pilots.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId UAIPilotSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAIPilotSubsystem, STATGROUP_Tickables);
+}
+
+void UAIPilotSubsystem::RegisterPilot(AACAIPilotController* Pilot)
+{
+	if (Pilot)
+	{
+		Pilots.AddUnique(Pilot);
+	}
+}
+
+void UAIPilotSubsystem::UnregisterPilot(AACAIPilotController* Pilot)
+{
+	const int32 Index = Pilots.Find(Pilot);
+	if (Index == INDEX_NONE) return;
+
+	Pilots.RemoveAtSwap(Index, EAllowShrinking::No);
+	if (NextPilot > Index)
+	{
+		--NextPilot;
+	}
+}
+
+void UAIPilotSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_AIPilotPilots, Pilots.Num());
+	LastThinkMilliseconds = 0.0;
+	if (Pilots.IsEmpty()) return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double Interval = CVarAIThinkInterval.GetValueOnGameThread();
+	const double BudgetSeconds = CVarAIThinkBudgetMs.GetValueOnGameThread() * 0.001;
+	const double StartTime = FPlatformTime::Seconds();
+
+	int32 NumThinks = 0;
+	for (int32 Visited = 0; Visited < Pilots.Num(); ++Visited)
+	{
+		// At least one think per frame so a tiny budget still makes progress
+		if (NumThinks > 0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds) break;
+
+		NextPilot = NextPilot % Pilots.Num();
+		AACAIPilotController* Pilot = Pilots[NextPilot++];
+		if (Pilot->NextThinkTime > Now) continue;
+
+		Pilot->Think();
+		Pilot->NextThinkTime = Now + Interval;
+		++NumThinks;
+	}
+	LastThinkMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+#if STATS
+	// Pilots whose decision is older than twice the interval: the budget is too small for the bot count
+	int32 NumOverdue = 0;
+	for (const AACAIPilotController* Pilot : Pilots)
+	{
+		NumOverdue += Pilot->NextThinkTime + Interval < Now;
+	}
+
+	SET_DWORD_STAT(STAT_AIPilotThinks, NumThinks);
+	SET_DWORD_STAT(STAT_AIPilotOverdue, NumOverdue);
+#endif
+}
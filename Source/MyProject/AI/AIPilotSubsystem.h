@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AIPilotSubsystem.generated.h"
+
+class AACAIPilotController;
+
+DECLARE_STATS_GROUP(TEXT("AIPilot"), STATGROUP_AIPilot, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Think"), STAT_AIPilotThink, STATGROUP_AIPilot, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Control"), STAT_AIPilotControl, STATGROUP_AIPilot, MYPROJECT_API);
+
+/**
+ * Schedules the expensive half of every bot pilot. Pilots think round-robin, each at most every
+ * ac.AI.ThinkInterval seconds, and the frame stops handing out thinks once ac.AI.ThinkBudgetMs is spent;
+ * the rest pick up where it left off next frame. Decisions get older under load, the frame does not get longer.
+ */
+UCLASS()
+class MYPROJECT_API UAIPilotSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterPilot(AACAIPilotController* Pilot);
+	void UnregisterPilot(AACAIPilotController* Pilot);
+
+	int32 GetNumPilots() const { return Pilots.Num(); }
+	/** Game-thread time the last Tick spent thinking */
+	double GetLastThinkMilliseconds() const { return LastThinkMilliseconds; }
+
+private:
+	UPROPERTY()
+	TArray<TObjectPtr<AACAIPilotController>> Pilots;
+
+	/** Round-robin cursor into Pilots */
+	int32 NextPilot = 0;
+	double LastThinkMilliseconds = 0.0;
+};
@@ -3,8 +3,19 @@
 
 #include "AAircraftBase.h"
 
-#include "MovieSceneTracksComponentTypes.h"
-#include "Misc/LowLevelTestAdapter.h"
+#include "AirflowFieldSubsystem.h"
+#include "FlightRelevancySubsystem.h"
+#include "FlightRecorder.h"
+#include "FlightReplaySubsystem.h"
+#include "MyProject/Arsenal/LagCompensationSubsystem.h"
+#include "FlightSimSubsystem.h"
+#include "FlightStats.h"
+
+static TAutoConsoleVariable<float> CVarNetPlausibilityMargin(
+    TEXT("ac.Net.PlausibilityMargin"),
+    2.f,
+    TEXT("Multiplier on the airframe's speed and g limits before the server clamps a remotely driven aircraft."),
+    ECVF_Default);
 
 // Sets default values
 AAAircraftBase::AAAircraftBase()
@@ -24,190 +35,248 @@ AAAircraftBase::AAAircraftBase()
 
 void AAAircraftBase::CalculateAerialPhysics(float DeltaTime, FVector& OutLinearAcceleration, FVector& OutAngularVelocity)
 {
-    OutLinearAcceleration = FVector::ZeroVector;
-    OutAngularVelocity    = FVector::ZeroVector;
+    FLIGHT_SCOPE(Flight, CalculateAerialPhysics);
 
-    switch (FlightType)
+    // The model itself lives in FFlightDynamics, this only feeds it the actor's state
+    FFlightBodyState State = MoveComp->GetBodyState();
+    const FFlightModel Model = GetFlightModel();
+    const FFlightControls Controls = GetFlightControls();
+
+    StepEnvironment = Airflow
+        ? Airflow->SampleEnvironment(EnvAirflow, State.Location, StepFieldTime, LastTurbulence)
+        : FFlightEnvironment::Make(EnvAirflow, LastTurbulence);
+
+    DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+    {
+        using TPolicy = decltype(Policy);
+        OutLinearAcceleration = FFlightDynamics::CalculateLinearAcceleration<TPolicy>(Model, State, Controls, StepEnvironment, bStepStalled, StepForces);
+        OutAngularVelocity    = FFlightDynamics::UpdateControlAngularVelocity<TPolicy>(Model, Controls, bStepStalled, DeltaTime, State,
+            StepForces.StallTorque);
+    });
+
+    MoveComp->SetControlAngularVelocity(State.ControlAngularVelocity);
+}
+
+void AAAircraftBase::PostLoad()
+{
+    Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+    // Only configs set on this object need an airframe of their own, the archetype migrated the ones it inherits
+    const AAAircraftBase* Archetype = Cast<AAAircraftBase>(GetArchetype());
+    if (!Archetype || Airframe != Archetype->Airframe)
     {
-        case EFlightType::Aircraft:
+        return;
+    }
+    const bool bOverridden = FlightType_DEPRECATED != Archetype->FlightType_DEPRECATED
+        || !FAircraftConfig::StaticStruct()->CompareScriptStruct(&AircraftConfig_DEPRECATED, &Archetype->AircraftConfig_DEPRECATED, PPF_None)
+        || !FDroneConfig::StaticStruct()->CompareScriptStruct(&DroneConfig_DEPRECATED, &Archetype->DroneConfig_DEPRECATED, PPF_None);
+    if (!bOverridden)
+    {
+        return;
+    }
+
+    // Saved with this object, Public so level instances of a Blueprint can share it
+    UAirframeAsset* Migrated = NewObject<UAirframeAsset>(this, MakeUniqueObjectName(this, UAirframeAsset::StaticClass(), TEXT("MigratedAirframe")),
+        RF_Public | RF_Transactional);
+    Migrated->FlightType = FlightType_DEPRECATED;
+    Migrated->Aircraft = AircraftConfig_DEPRECATED;
+    Migrated->Drone = DroneConfig_DEPRECATED;
+    Airframe = Migrated;
+    UE_LOG(LogTemp, Warning, TEXT("[Airframe] %s: moved inline flight configs into %s, assign a shared airframe asset from /Game/Main/Aircraft"),
+        *GetPathName(), *Migrated->GetName());
+#endif
+}
+
+// Called when the game starts or when spawned
+void AAAircraftBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+    // Owning clients predict through the field too
+    Airflow = GetWorld()->GetSubsystem<UAirflowFieldSubsystem>();
+    if (HasAuthority())
+    {
+        MoveComp->SetFieldEpoch(Airflow ? Airflow->GetFieldTime() : GetWorld()->GetTimeSeconds());
+    }
+    StepFieldTime = MoveComp->GetFrameFieldTime(0);
+   
+    // Only the server batches: the owning client predicts its single aircraft through Tick
+    if (HasAuthority() && UFlightSimSubsystem::IsBatchedSimulationEnabled())
+    {
+        if (UFlightSimSubsystem* FlightSim = GetWorld()->GetSubsystem<UFlightSimSubsystem>())
         {
-            const auto& Cfg = AircraftConfig;
-
-            FVector Forward = GetActorForwardVector();
-            FVector Up      = GetActorUpVector();
-            FVector Vel     = MoveComp->LastLinearVelocity;
-            FVector VelDir  = Vel.GetSafeNormal();
-
-            // --- Gravity ---
-            FVector Gravity = FVector(0, 0, -980.f * Cfg.GravityScale) * Cfg.Mass;
-
-            // --- Angle of Attack ---
-            float AOA = 0.f;
-            if (!VelDir.IsNearlyZero())
-            {
-                AOA = FMath::Acos(FVector::DotProduct(Forward, VelDir));
-                if (FVector::DotProduct(Vel, Up) < 0) AOA *= -1.f;
-            }
-
-            // --- Lift ---
-            FVector LiftDir = (Up - FVector::DotProduct(Up, VelDir) * VelDir).GetSafeNormal();
-            FVector Lift    = 0.5f * Vel.SizeSquared() * Cfg.LiftCoefficient * LiftDir;
-
-            // --- Drag ---
-            FVector Drag = -0.5f * Vel.SizeSquared() * Cfg.DragCoefficient * VelDir;
-
-            // --- Thrust ---
-            FVector Thrust = Forward * (CurrentThrust * Cfg.ThrustPower);
-
-            // --- Stall correction torque ---
-            FVector StallTorque = FVector::ZeroVector;
-            if (FMath::Abs(FMath::RadiansToDegrees(AOA)) >= Cfg.StallAngleDegrees)
-            {
-                FQuat TargetQuat = VelDir.ToOrientationQuat();
-                FQuat DeltaQuat  = TargetQuat * GetActorQuat().Inverse();
-
-                FVector Axis; float Angle;
-                DeltaQuat.ToAxisAndAngle(Axis, Angle);
-                StallTorque = Axis * Angle * (Cfg.StabilityTorque / Cfg.Mass);
-            }
-
-            // --- Environment ---
-            FVector Wind       = EnvAirflow.WindDirection * EnvAirflow.WindForce;
-            FVector Updraft    = EnvAirflow.UpdraftForce * Up;
-            FVector Turbulence = EnvAirflow.TurbulenceStrength * LastTurbulence;
-
-            // --- Total Forces ---
-            FVector TotalForce = Gravity + Lift + Drag + Thrust + Wind + Updraft + Turbulence;
-            OutLinearAcceleration = TotalForce / FMath::Max(Cfg.Mass, 1.f);
-
-            // --- Angular motion from player + stall ---
-            static FVector SmoothedAngularVelocity = FVector::ZeroVector;
-
-            FVector DesiredAngularVelocity = FVector::ZeroVector;
-
-                if (!FMath::IsNearlyZero(SteeringInput.Y))
-                {
-                    DesiredAngularVelocity.X = SteeringInput.Y * Cfg.PitchRate; // Pitch
-                }
-
-                if (!FMath::IsNearlyZero(SteeringInput.X))
-                {
-                    DesiredAngularVelocity.Y = SteeringInput.X * Cfg.RollRate;  // Roll
-                }
-
-                if (!FMath::IsNearlyZero(YawInput))
-                {
-                    DesiredAngularVelocity.Z = YawInput * Cfg.YawRate;          // Yaw
-                }
-
-                // Smooth damping (blend player input with stall torque)
-                float DampingFactor = 4.f; // tweak: higher = faster stop
-                SmoothedAngularVelocity = FMath::VInterpTo(
-                    SmoothedAngularVelocity,
-                    DesiredAngularVelocity + StallTorque,
-                    DeltaTime,
-                    DampingFactor
-                );
-
-                if (SmoothedAngularVelocity.SizeSquared() < KINDA_SMALL_NUMBER)
-                {
-                    SmoothedAngularVelocity = FVector::ZeroVector;
-                }
-
-                OutAngularVelocity = SmoothedAngularVelocity;
-
-                break;
+            // The subsystem integrates us together with every other aircraft, no need for our own tick
+            FlightSim->RegisterAircraft(this);
+            SetActorTickEnabled(false);
         }
+    }
 
-    case EFlightType::Drone:
-            {
-                const auto& Cfg = DroneConfig;
+    if (HasAuthority())
+    {
+        if (UFlightRelevancySubsystem* Relevancy = GetWorld()->GetSubsystem<UFlightRelevancySubsystem>())
+        {
+            Relevancy->RegisterAircraft(this);
+        }
+        if (ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+        {
+            LagComp->RegisterAircraft(this);
+        }
+        Replay = GetWorld()->GetSubsystem<UFlightReplaySubsystem>();
+    }
 
-                FVector Forward = GetActorForwardVector();
-                FVector Up      = GetActorUpVector();
-                FVector Vel     = MoveComp->LastLinearVelocity;
+}
 
-                // --- Thrust ---
-                FVector ForwardAccel = Forward * (CurrentThrust * Cfg.Acceleration);
+void AAAircraftBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UFlightSimSubsystem* FlightSim = GetWorld()->GetSubsystem<UFlightSimSubsystem>())
+    {
+        FlightSim->UnregisterAircraft(this);
+    }
+    if (UFlightRelevancySubsystem* Relevancy = GetWorld()->GetSubsystem<UFlightRelevancySubsystem>())
+    {
+        Relevancy->UnregisterAircraft(this);
+    }
+    if (ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+    {
+        LagComp->UnregisterAircraft(this);
+    }
 
-                // --- Drag / natural slowdown ---
-                float LinearDamping = Cfg.DragCoefficient; // e.g., 4~8, tweak for snappy stop
-                FVector DampedDrag = -Vel * LinearDamping;
+    Super::EndPlay(EndPlayReason);
+}
 
-                // --- Environment ---
-                FVector Wind       = EnvAirflow.WindDirection * EnvAirflow.WindForce;
-                FVector Updraft    = EnvAirflow.UpdraftForce * Up;
-                FVector Turbulence = EnvAirflow.TurbulenceStrength * LastTurbulence;
+float AAAircraftBase::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+    UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+    const float BasePriority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+    return BasePriority * UFlightRelevancySubsystem::GetPriorityScale(GetActorLocation(), ViewPos, ViewDir);
+}
 
-                // --- Total linear acceleration ---
-                OutLinearAcceleration = (ForwardAccel + DampedDrag + Wind + Updraft + Turbulence) / FMath::Max(Cfg.Mass, 1.f);
+FVector AAAircraftBase::GetVelocity() const
+{
+    return MoveComp ? MoveComp->GetBodyState().LinearVelocity : FVector::ZeroVector;
+}
 
-                // --- Angular motion ---
-                static FVector SmoothedAngularVelocity = FVector::ZeroVector;
+void AAAircraftBase::PredictFlightStep(float StepDeltaTime)
+{
+    SamplePilotInput();
+    // Predict with the quantized input the server will see
+    const FFlightInputFrame Frame = MakeInputFrame(MoveComp->ConsumeInputSequence());
+    ApplyInputFrame(Frame);
+    SimulateFlightStep(StepDeltaTime);
+    MoveComp->RecordPredictedMove(Frame);
+}
 
-                FVector DesiredAngularVelocity = FVector::ZeroVector;
+void AAAircraftBase::Server_SendInputs_Implementation(const FFlightInputPacket& Packet)
+{
+    FLIGHT_SCOPE(FlightNet, ServerSendInputs);
+    FlightStats::CountInputRpc();
 
-                if (!FMath::IsNearlyZero(SteeringInput.Y))
-                    DesiredAngularVelocity.X = SteeringInput.Y * Cfg.MaxPitchAngle; // Pitch
-                if (!FMath::IsNearlyZero(SteeringInput.X))
-                    DesiredAngularVelocity.Y = SteeringInput.X * Cfg.MaxRollAngle;  // Roll
-                if (!FMath::IsNearlyZero(YawInput))
-                    DesiredAngularVelocity.Z = YawInput * Cfg.YawRate;              // Yaw
+    // Floods are dropped here, before any frame touches game state
+    if (!MoveComp->IsDrivenByRemoteInputs() || !MoveComp->AdmitInputPacket()) return;
 
-                // Smooth damping for angular velocity
-                float AngularDampingFactor = 8.f; // tweak for snappy rotation stop
-                SmoothedAngularVelocity = FMath::VInterpTo(
-                    SmoothedAngularVelocity,
-                    DesiredAngularVelocity,
-                    DeltaTime,
-                    AngularDampingFactor
-                );
+    const float StepSeconds = UFPVMovementComponent::GetNetStepSeconds();
+    const bool bRecording = Replay && Replay->IsRecording();
+    for (const FFlightInputFrame& Frame : Packet.Frames)
+    {
+        // Redundant copies of frames that were already simulated
+        if (Frame.Sequence <= MoveComp->GetLastProcessedInput()) continue;
 
-                // Snap very small rotation to zero
-                if (SmoothedAngularVelocity.SizeSquared() < KINDA_SMALL_NUMBER)
-                    SmoothedAngularVelocity = FVector::ZeroVector;
+        // Frames beyond real time stay unacknowledged, the client gets corrected back
+        if (!MoveComp->AdmitInputFrame(StepSeconds)) break;
 
-                OutAngularVelocity = SmoothedAngularVelocity;
+        const FFlightBodyState PreviousBody = bRecording ? MoveComp->GetBodyState() : FFlightBodyState();
+        const FVector PreviousVelocity = MoveComp->GetBodyState().LinearVelocity;
+        ApplyInputFrame(Frame);
+        SimulateFlightStep(StepSeconds);
+        MoveComp->EnforcePlausibleMotion(PreviousVelocity, StepSeconds, GetMaxPlausibleSpeed(), GetMaxPlausibleAcceleration());
+        MoveComp->AcknowledgeInput(Frame.Sequence);
 
-                break;
-            }
+        if (bRecording)
+        {
+            Replay->RecordStep(this, PreviousBody, Frame);
+        }
     }
+    MoveComp->CommitMove();
 }
 
-// Called when the game starts or when spawned
-void AAAircraftBase::BeginPlay()
+void AAAircraftBase::SimulateFlightStep(float StepDeltaTime)
 {
-	Super::BeginPlay();
-   
-    if (IsLocallyControlled()) // only the owning client sends its inputs
+    FVector LinearAccel;
+    FVector AngularVel;
+
+    // Always compute physics based on inputs/environment
+    CalculateAerialPhysics(StepDeltaTime, LinearAccel, AngularVel);
+
+    // Owning client + server both call ApplyPhysicsStep
+    MoveComp->ApplyPhysicsStep(StepDeltaTime, LinearAccel, AngularVel);
+
+    // Forces as CalculateAerialPhysics summed them. Steps replayed after a correction are tagged, their sequence was recorded before
+    if (FFlightRecorder* Recorder = MoveComp->GetRecorder().Get())
     {
-        FTimerHandle InputSendTimer;
-        GetWorldTimerManager().SetTimer(
-            InputSendTimer,
-            this,
-            &AAAircraftBase::SendInputsToServer, // wrapper function
-            0.1f,  // every 100ms (10Hz)
-            true
-        );
+        Recorder->RecordStep(GetWorld()->GetTimeSeconds(), InputSequence, GetFlightControls(), StepForces, bStepStalled, MoveComp->GetBodyState(),
+            MoveComp->IsReplayingMoves() ? EFlightRecordType::ReplayedStep : EFlightRecordType::Step);
+    }
+    StepFieldTime += StepDeltaTime;
+}
 
+FFlightModel AAAircraftBase::GetFlightModel() const
+{
+    return FFlightModel(GetAirframe());
+}
+
+FFlightControls AAAircraftBase::GetFlightControls() const
+{
+    return { CurrentThrust, SteeringInput, YawInput };
+}
+
+FFlightInputFrame AAAircraftBase::MakeInputFrame(uint32 Sequence) const
+{
+    return FFlightInputFrame::Make(Sequence, CurrentThrust, SteeringInput, YawInput);
+}
+
+void AAAircraftBase::ApplyInputFrame(const FFlightInputFrame& Frame)
+{
+    const FFlightControls Controls = Frame.GetControls();
+    InputSequence = Frame.Sequence;
+    // Live input (sequence 0) keeps the clock where the steps left it
+    if (Frame.Sequence != 0)
+    {
+        StepFieldTime = MoveComp->GetFrameFieldTime(Frame.Sequence);
     }
+    CurrentThrust = Controls.Thrust;
+    SteeringInput = Controls.Steering;
+    YawInput      = Controls.Yaw;
+}
 
+FVector AAAircraftBase::GetControlRates() const
+{
+    // Mirrors the input mapping in CalculateAerialPhysics: SteeringInput.Y -> X, SteeringInput.X -> Y, YawInput -> Z
+    const FFlightModel Model = GetFlightModel();
+    return DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+    {
+        using TPolicy = decltype(Policy);
+        return TPolicy::GetControlRates(TPolicy::GetConfig(Model));
+    });
 }
 
-void AAAircraftBase::SendInputsToServer()
+float AAAircraftBase::GetMaxPlausibleSpeed() const
 {
-    // WRAPPER FUNCTION IS NEEDED CUZ OTHERWISE ONLY ON FIRST TIME CURRENT VALUE WOULD BE SENT, ON EACH ITTERATION WE WANT
-    // THE CURRENT VALUES ON THE OWNING CLIENT TO BE RUNNING
-    Server_SendInputs(CurrentThrust, SteeringInput, YawInput);
+    const float Margin = CVarNetPlausibilityMargin.GetValueOnGameThread();
+    const FFlightModel Model = GetFlightModel();
+    return DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+    {
+        using TPolicy = decltype(Policy);
+        return TPolicy::GetMaxSpeed(TPolicy::GetConfig(Model));
+    }) * Margin;
 }
 
-void AAAircraftBase::Server_SendInputs_Implementation(float OwningClientThrust, FVector2D OwningClientSteering, float OwningClientYaw)
+float AAAircraftBase::GetMaxPlausibleAcceleration() const
 {
-    // Sanity Checking LOGIC for thrust can be applied here / but we would also have abilities
-    // so keeping sanity check off for an while.
-    CurrentThrust = OwningClientThrust;
-    SteeringInput = OwningClientSteering;
-    YawInput = OwningClientYaw;
+    // MaxG is the structural limit of the airframe; gravity alone can add one more g
+    const float Margin = CVarNetPlausibilityMargin.GetValueOnGameThread();
+    const float MaxG = GetAirframe().GetBaseConfig().MaxG;
+    return (MaxG + 1.f) * 980.f * Margin;
 }
 
 
@@ -217,16 +286,44 @@ void AAAircraftBase::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
     check(MoveComp)
     
-    if ((HasAuthority() || IsLocallyControlled()))
+    // Batched aircraft are stepped by UFlightSimSubsystem, remote players' aircraft by their input frames
+    if (FlightSimIndex != INDEX_NONE || MoveComp->IsDrivenByRemoteInputs()) return;
+
+    if (HasAuthority())
     {
-        FVector LinearAccel;
-        FVector AngularVel;
-
-        // Always compute physics based on inputs/environment
-        CalculateAerialPhysics(DeltaTime, LinearAccel, AngularVel);
-              
-        // Owning client + server both call ApplyPhysicsStep
-        MoveComp->ApplyPhysicsStep(DeltaTime, LinearAccel, AngularVel);
+        const float StepSeconds = UFlightSimSubsystem::GetFixedStepSeconds();
+        const int32 NumSteps = FlightClock.Advance(DeltaTime, StepSeconds, UFlightSimSubsystem::GetMaxSubsteps());
+        const float StepDeltaTime = StepSeconds > 0.f ? StepSeconds : DeltaTime;
+
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            // The pawn only moves once the frame's steps are done, the body state is the current one
+            const FFlightBodyState& Body = MoveComp->GetBodyState();
+            SamplePilotInput();
+            PreFlightStep({ Body.Location, Body.Rotation, Body.LinearVelocity }, StepDeltaTime);
+            SimulateFlightStep(StepDeltaTime);
+        }
+        MoveComp->CommitMove();
+        ReportInputToMotion();
+    }
+    else if (IsLocallyControlled())
+    {
+        // Predict locally on the same fixed step the server replays our frames with
+        const float StepSeconds = UFPVMovementComponent::GetNetStepSeconds();
+        const int32 NumSteps = FlightClock.Advance(DeltaTime, StepSeconds, UFlightSimSubsystem::GetMaxSubsteps());
+
+        for (int32 Step = 0; Step < NumSteps; ++Step)
+        {
+            PredictFlightStep(StepSeconds);
+        }
+        MoveComp->CommitMove();
+        ReportInputToMotion();
+
+        FFlightInputPacket Packet;
+        if (MoveComp->BuildInputPacket(DeltaTime, Packet))
+        {
+            Server_SendInputs(Packet);
+        }
     }
 
 }
@@ -237,6 +334,9 @@ void AAAircraftBase::ConstructPlaneMesh()
     PlaneMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("PlaneMesh"));
     PlaneMesh->SetupAttachment(RootComponent);
     PlaneMesh->SetWorldScale3D(FVector(1.f));
+    // Nothing listens for aircraft overlaps (hits are traced), so moves can skip UpdateOverlaps.
+    // Blueprints that need them turn GenerateOverlapEvents back on for the mesh
+    PlaneMesh->SetGenerateOverlapEvents(false);
     if (PlaneMeshAsset)
     {
         PlaneMesh->SetStaticMesh(PlaneMeshAsset);
@@ -267,50 +367,57 @@ void AAAircraftBase::PostEditChangeProperty(FPropertyChangedEvent& PropertyChang
 void AAAircraftBase::PossessedBy(AController* NewController)
 {
     Super::PossessedBy(NewController);
-
-    if (AACPlayerController* PC = Cast<AACPlayerController>(GetController()))
-    {
-        // Bind once per possession
-        PC->OnSteerInput.AddDynamic(this, &AAAircraftBase::HandleSteerInput);
-        PC->OnYawInput.AddDynamic(this, &AAAircraftBase::HandleYawInput);
-        PC->OnThrustInput.AddDynamic(this, &AAAircraftBase::HandleThrustInput);
-        PRINTSCREEN("BINDING SUCCESSFULL FOR STEER YAW THRUST SERVER")
-
-    }
-
-    
+    UpdatePilot();
 }
 
 void AAAircraftBase::OnRep_Controller()
 {
     Super::OnRep_Controller();
-    if (!IsLocallyControlled()) {return;}
-    if (AACPlayerController* PC = Cast<AACPlayerController>(GetController()))
-    {
-        // Client side binding when Controller gets replicated
-        PC->OnSteerInput.AddDynamic(this, &AAAircraftBase::HandleSteerInput);
-        PC->OnYawInput.AddDynamic(this, &AAAircraftBase::HandleYawInput);
-        PC->OnThrustInput.AddDynamic(this, &AAAircraftBase::HandleThrustInput);
-        PRINTSCREEN("BINDING SUCCESSFULL FOR STEER YAW THRUST CLIENT")
-
-    }
+    UpdatePilot();
 }
 
+void AAAircraftBase::UnPossessed()
+{
+    Super::UnPossessed();
+    Pilot = nullptr;
+}
 
+void AAAircraftBase::UpdatePilot()
+{
+    // The controller ticks before its pawn (AController::AddPawnTickDependency), so the sample is this frame's
+    AACPlayerController* PC = Cast<AACPlayerController>(GetController());
+    Pilot = PC && PC->IsLocalController() ? PC : nullptr;
+    LastPilotInputSerial = 0;
+    PendingPilotInputTime = 0.0;
+}
 
-void AAAircraftBase::UnPossessed()
+void AAAircraftBase::SamplePilotInput()
 {
-    UE_LOG(LogTemp, Log, TEXT("UnPossessed() called"));
+    if (!Pilot) return;
+
+    const FPilotInputSample& Sample = Pilot->GetPilotInput();
+    if (Sample.Serial == LastPilotInputSerial) return;
+    LastPilotInputSerial = Sample.Serial;
 
-    if (AACPlayerController* PC = Cast<AACPlayerController>(GetController()))
+    SetAerialInputs(Sample.Thrust, Sample.Steering, Sample.Yaw);
+    FLIGHT_COUNT(Flight, PilotInputUpdates, 1);
+    if (PendingPilotInputTime == 0.0)
     {
-        // Unbind to prevent dangling references
-        PC->OnSteerInput.RemoveDynamic(this, &AAAircraftBase::HandleSteerInput);
-        PC->OnYawInput.RemoveDynamic(this, &AAAircraftBase::HandleYawInput);
-        PC->OnThrustInput.RemoveDynamic(this, &AAAircraftBase::HandleThrustInput);
+        PendingPilotInputTime = Sample.Timestamp;
     }
+}
 
-    Super::UnPossessed();
+void AAAircraftBase::ReportInputToMotion()
+{
+#if FLIGHT_PROFILING
+    if (PendingPilotInputTime == 0.0) return;
+
+    // From Enhanced Input delivering a changed value to the pawn moving with it. Rendering and display come on top
+    const float LatencyMs = static_cast<float>((FPlatformTime::Seconds() - PendingPilotInputTime) * 1000.0);
+    SET_FLOAT_STAT(STAT_FlightInputLatency, LatencyMs);
+    CSV_CUSTOM_STAT(Flight, InputLatencyMs, LatencyMs, ECsvCustomStatOp::Max);
+#endif
+    PendingPilotInputTime = 0.0;
 }
 
 // Called to bind functionality to input
@@ -330,23 +437,5 @@ void AAAircraftBase::SetAerialInputs(float Thrust, const FVector2D& InSteeringIn
     YawInput        = InYawInput;
 }
 
-void AAAircraftBase::HandleSteerInput(const FVector2D InSteeringInput)
-{
-    PRINTSCREEN("Steering Input Handle CALLED by the controller");
-    SteeringInput   = InSteeringInput;
-}
-
-void AAAircraftBase::HandleYawInput(float InYawInput)
-{
-    PRINTSCREEN("YAW Input Handle CALLED by the controller");
-    YawInput        = InYawInput;
-}
-
-void AAAircraftBase::HandleThrustInput(float InThrustInput)
-{
-    PRINTSCREEN("THRUST Input Handle CALLED by the controller");
-
-    CurrentThrust   = FMath::Clamp(InThrustInput, 0.f, 1.f);
-}
 
 
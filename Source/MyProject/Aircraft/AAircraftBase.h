@@ -5,57 +5,123 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
 #include "MyProject/GCore/Config.h"
+#include "MyProject/GCore/Config/AirframeAsset.h"
 #include "FPVMovementComponent.h"
+#include "FlightDynamics.h"
 #include "MyProject/Player/ACPlayerController.h"
 #include "AAircraftBase.generated.h"
 
+class UFlightSimSubsystem;
+class UFlightReplaySubsystem;
+class UAirflowFieldSubsystem;
+
 UCLASS()
 class MYPROJECT_API AAAircraftBase : public APawn
 {
 	GENERATED_BODY()
+	friend class UFlightSimSubsystem;
+	friend class UFlightReplaySubsystem;
 
 public:
 	// Sets default values for this pawn's properties
 	AAAircraftBase();
 
 	// SETUP MOVEMENTS
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight")
-	EFlightType FlightType = EFlightType::Aircraft;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight")
-	FAircraftConfig AircraftConfig;
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight")
-	FDroneConfig DroneConfig;
+	// Shared flight definition of this airframe type, aircraft without one fly the default configs
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Flight")
+	TObjectPtr<UAirframeAsset> Airframe;
+	const UAirframeAsset& GetAirframe() const { return Airframe ? *Airframe : UAirframeAsset::GetFallback(); }
 protected:
+#if WITH_EDITORONLY_DATA
+	// Inline configs of aircraft saved before airframe assets, PostLoad moves them into Airframe
+	UPROPERTY(meta=(DeprecatedProperty, DeprecationMessage="Assign an Airframe asset instead"))
+	EFlightType FlightType_DEPRECATED = EFlightType::Aircraft;
+	UPROPERTY(meta=(DeprecatedProperty, DeprecationMessage="Assign an Airframe asset instead"))
+	FAircraftConfig AircraftConfig_DEPRECATED;
+	UPROPERTY(meta=(DeprecatedProperty, DeprecationMessage="Assign an Airframe asset instead"))
+	FDroneConfig DroneConfig_DEPRECATED;
+#endif
+	virtual void PostLoad() override;
+
 	float CurrentThrust = 0.f;
 	FVector2D SteeringInput = FVector2D::ZeroVector;
 	float YawInput = 0.f;
+	// Sequence of the last input frame applied, 0 for inputs that did not come from one (AI, live stick)
+	uint32 InputSequence = 0;
+	// Turbulence noise sampled for the last step, scaled by EnvAirflow.TurbulenceStrength
 	FVector LastTurbulence = FVector::ZeroVector;
+	// Airflow of this aircraft only, the map-wide field is added on top
 	FEnvAirflow EnvAirflow;
+	// Environment the last flight step was simulated with
+	FFlightEnvironment StepEnvironment;
+	// Forces by source and the stall of the last flight step, as the model summed them, for the recorder
+	FFlightForces StepForces;
+	bool bStepStalled = false;
+	// Airflow field time the next step samples turbulence at. Input frames set it from their sequence
+	// (UFPVMovementComponent::GetFrameFieldTime), steps this machine drives itself advance it by their length
+	double StepFieldTime = 0.0;
+	UPROPERTY()
+	TObjectPtr<UAirflowFieldSubsystem> Airflow;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight")
 	UFPVMovementComponent* MoveComp;
+
+	// Slot in UFlightSimSubsystem, INDEX_NONE while this aircraft ticks itself
+	int32 FlightSimIndex = INDEX_NONE;
+	// Fixed-rate clock for the per-actor path (the subsystem keeps its own for batched aircraft)
+	FFlightFixedClock FlightClock;
+	// Server: gets every input frame of remote players while a match is being recorded
+	UPROPERTY()
+	TObjectPtr<UFlightReplaySubsystem> Replay;
+	// Pilot on this machine, null for AI and for remote players (their input arrives as frames)
+	UPROPERTY()
+	TObjectPtr<AACPlayerController> Pilot;
+	// Serial of the last pilot sample copied into the inputs
+	uint32 LastPilotInputSerial = 0;
+	// Timestamp of the oldest pilot change a step has flown with but the pawn does not show yet, 0 when none
+	double PendingPilotInputTime = 0.0;
+	void UpdatePilot();
+	// Copies the pilot's latest sample into the flight inputs, called right before every step it would affect
+	void SamplePilotInput();
+	// Called right after the pawn is moved: publishes Input Latency once a step flown with new input is shown
+	void ReportInputToMotion();
 	
 
-	// We send input at custom rate with timer function on begin play
+	// Owning client records one numbered frame per predicted step and sends them in coalesced packets,
+	// the server simulates exactly one step per new frame
 	UFUNCTION(Server, Unreliable)
-	void Server_SendInputs(float OwningClientThrust, FVector2D OwningClientSteering, float OwningClientYaw);
-	void SendInputsToServer();
+	void Server_SendInputs(const FFlightInputPacket& Packet);
+	void PredictFlightStep(float StepDeltaTime);
 	virtual void OnRep_Controller() override; 
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget,
+		UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+	// Movement bypasses the root component, so report the simulated velocity (inherited by fired rounds)
+	virtual FVector GetVelocity() const override;
 
 
 public:
 	virtual void CalculateAerialPhysics(float DeltaTime, FVector& OutLinearAcceleration, FVector& OutAngularVelocity);
 	virtual void SetAerialInputs(float Thrust, const FVector2D& SteeringInput, float YawInput);
-	UFUNCTION()
-	virtual void HandleSteerInput(const FVector2D SteeringInput);
-	UFUNCTION()
-	virtual void HandleYawInput(float YawInput);
-	UFUNCTION()
-	virtual void HandleThrustInput(float Thrust);
+	// One force + integration step from the current inputs, also used to replay predicted moves
+	void SimulateFlightStep(float StepDeltaTime);
+	// Views of the actor's config and inputs for FFlightDynamics
+	FFlightModel GetFlightModel() const;
+	FFlightControls GetFlightControls() const;
+	FFlightEnvironment GetFlightEnvironment() const { return StepEnvironment; }
+	FFlightInputFrame MakeInputFrame(uint32 Sequence) const;
+	void ApplyInputFrame(const FFlightInputFrame& Frame);
+	// Called on the server before every flight step of an aircraft it simulates, so a pilot can steer at the physics rate
+	virtual void PreFlightStep(const FFlightPilotState& State, float StepDeltaTime) {}
+	// World angular velocity (deg/s) the X, Y and Z control axes reach at full input
+	FVector GetControlRates() const;
+	// Upper bounds the server holds remotely driven aircraft to, derived from the active flight config
+	float GetMaxPlausibleSpeed() const;
+	float GetMaxPlausibleAcceleration() const;
 	
 	
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -3,3 +3,18 @@
 
 #include "AEnemyAircraft.h"
 
+#include "MyProject/AI/ACAIPilotController.h"
+
+AAEnemyAircraft::AAEnemyAircraft()
+{
+	AIControllerClass = AACAIPilotController::StaticClass();
+	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
+}
+
+void AAEnemyAircraft::PreFlightStep(const FFlightPilotState& State, float StepDeltaTime)
+{
+	if (AACAIPilotController* Pilot = Cast<AACAIPilotController>(GetController()))
+	{
+		Pilot->UpdateControls(State, StepDeltaTime);
+	}
+}
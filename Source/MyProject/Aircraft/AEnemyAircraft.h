@@ -7,11 +7,16 @@
 #include "AEnemyAircraft.generated.h"
 
 /**
- * 
+ * Bot aircraft, flown by an AACAIPilotController on the server
  */
 UCLASS()
 class MYPROJECT_API AAEnemyAircraft : public AAAircraftBase
 {
 	GENERATED_BODY()
+
+public:
+	AAEnemyAircraft();
+
+	virtual void PreFlightStep(const FFlightPilotState& State, float StepDeltaTime) override;
 	
 };
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AircraftSpatialGrid.h"
+
+FAircraftSpatialGrid::FAircraftSpatialGrid(double InCellSize)
+	: CellSize(FMath::Max(InCellSize, 100.0))
+{
+}
+
+FIntPoint FAircraftSpatialGrid::CellOf(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+int32 FAircraftSpatialGrid::Add(const FVector& Location)
+{
+	const int32 Id = Entries.Add(FEntry{ Location, CellOf(Location), INDEX_NONE });
+	LinkToCell(Id);
+	return Id;
+}
+
+void FAircraftSpatialGrid::Remove(int32 Id)
+{
+	UnlinkFromCell(Id);
+	Entries.RemoveAt(Id);
+}
+
+void FAircraftSpatialGrid::Update(int32 Id, const FVector& Location)
+{
+	FEntry& Entry = Entries[Id];
+	Entry.Location = Location;
+
+	const FIntPoint NewCell = CellOf(Location);
+	if (NewCell == Entry.Cell) return;
+
+	UnlinkFromCell(Id);
+	Entries[Id].Cell = NewCell;
+	LinkToCell(Id);
+}
+
+void FAircraftSpatialGrid::LinkToCell(int32 Id)
+{
+	FEntry& Entry = Entries[Id];
+	FCell& Cell = Cells.FindOrAdd(Entry.Cell);
+	Entry.Slot = Cell.Add(Id);
+}
+
+void FAircraftSpatialGrid::UnlinkFromCell(int32 Id)
+{
+	const FEntry& Entry = Entries[Id];
+	FCell* Cell = Cells.Find(Entry.Cell);
+	check(Cell && (*Cell)[Entry.Slot] == Id);
+
+	// The last id in the cell takes over the freed slot
+	const int32 MovedId = Cell->Last();
+	(*Cell)[Entry.Slot] = MovedId;
+	Entries[MovedId].Slot = Entry.Slot;
+	Cell->Pop(EAllowShrinking::No);
+
+	if (Cell->IsEmpty())
+	{
+		Cells.Remove(Entry.Cell);
+	}
+}
+
+void FAircraftSpatialGrid::QueryRadius(const FVector& Center, double Radius, TArray<int32>& OutIds) const
+{
+	OutIds.Reset();
+
+	const double RadiusSq = FMath::Square(Radius);
+	ForEachInCells(CellOf(Center - FVector(Radius)), CellOf(Center + FVector(Radius)), [&](int32 Id)
+	{
+		if (FVector::DistSquared(Entries[Id].Location, Center) <= RadiusSq)
+		{
+			OutIds.Add(Id);
+		}
+	});
+}
+
+void FAircraftSpatialGrid::QueryCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Range, TArray<int32>& OutIds) const
+{
+	OutIds.Reset();
+
+	const double RangeSq = FMath::Square(Range);
+	const double CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(HalfAngleDegrees, 0.0, 180.0)));
+
+	// Same cos test as the relevancy view cone, squared to stay free of sqrt
+	ForEachInCells(CellOf(Origin - FVector(Range)), CellOf(Origin + FVector(Range)), [&](int32 Id)
+	{
+		const FVector ToPoint = Entries[Id].Location - Origin;
+		const double DistSq = ToPoint.SizeSquared();
+		if (DistSq > RangeSq) return;
+
+		const double Dot = FVector::DotProduct(ToPoint, Direction);
+		const double Bound = DistSq * CosHalfAngle * FMath::Abs(CosHalfAngle);
+		if (Dot * FMath::Abs(Dot) >= Bound)
+		{
+			OutIds.Add(Id);
+		}
+	});
+}
+
+void FAircraftSpatialGrid::QueryNearest(const FVector& Origin, int32 Count, double MaxRadius, TArray<int32>& OutIds) const
+{
+	OutIds.Reset();
+	if (Count <= 0 || Entries.Num() == 0) return;
+
+	struct FCandidate
+	{
+		double DistSq;
+		int32 Id;
+		bool operator<(const FCandidate& Other) const { return DistSq < Other.DistSq; }
+	};
+	TArray<FCandidate, TInlineAllocator<32>> Candidates;
+
+	const double MaxRadiusSq = FMath::Square(MaxRadius);
+	const FIntPoint Center = CellOf(Origin);
+	const int32 MaxRing = FMath::Min(FMath::CeilToInt32(MaxRadius / CellSize) + 1, 1 << 16);
+	int32 NumSeen = 0;
+
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+	{
+		// Visit only the border of the square of cells Ring away from the center
+		for (int32 Y = -Ring; Y <= Ring; ++Y)
+		{
+			const bool bEdgeRow = FMath::Abs(Y) == Ring;
+			for (int32 X = -Ring; X <= Ring; X += bEdgeRow ? 1 : 2 * FMath::Max(Ring, 1))
+			{
+				const FCell* Cell = Cells.Find(Center + FIntPoint(X, Y));
+				if (!Cell) continue;
+
+				NumSeen += Cell->Num();
+				for (const int32 Id : *Cell)
+				{
+					const double DistSq = FVector::DistSquared(Entries[Id].Location, Origin);
+					if (DistSq <= MaxRadiusSq)
+					{
+						Candidates.Add({ DistSq, Id });
+					}
+				}
+			}
+		}
+
+		// Every point within Ring cells of horizontal distance has been seen, enough of them means we are done
+		const double CoveredSq = FMath::Square(Ring * CellSize);
+		int32 NumCovered = 0;
+		for (const FCandidate& Candidate : Candidates)
+		{
+			NumCovered += Candidate.DistSq <= CoveredSq;
+		}
+		if (NumCovered >= Count || NumSeen == Entries.Num()) break;
+	}
+
+	Candidates.Sort();
+	for (int32 i = 0; i < FMath::Min(Count, Candidates.Num()); ++i)
+	{
+		OutIds.Add(Candidates[i].Id);
+	}
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Uniform XY grid of points identified by stable ids. Aircraft spread out far more horizontally than
+ * vertically, so cells are columns and altitude only enters the exact distance tests.
+ * Update only touches the cell lists when a point crosses into another cell: O(1) add, remove and move.
+ */
+struct MYPROJECT_API FAircraftSpatialGrid
+{
+	explicit FAircraftSpatialGrid(double InCellSize = 50000.0);
+
+	int32 Add(const FVector& Location);
+	void Remove(int32 Id);
+	void Update(int32 Id, const FVector& Location);
+
+	int32 Num() const { return Entries.Num(); }
+	double GetCellSize() const { return CellSize; }
+	const FVector& GetLocation(int32 Id) const { return Entries[Id].Location; }
+
+	/** Ids within Radius of Center, unordered */
+	void QueryRadius(const FVector& Center, double Radius, TArray<int32>& OutIds) const;
+	/** Ids within Range of Origin and HalfAngleDegrees of Direction (normalized), unordered */
+	void QueryCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Range, TArray<int32>& OutIds) const;
+	/** Up to Count ids closest to Origin and within MaxRadius, closest first */
+	void QueryNearest(const FVector& Origin, int32 Count, double MaxRadius, TArray<int32>& OutIds) const;
+
+private:
+	struct FEntry
+	{
+		FVector Location;
+		FIntPoint Cell;
+		/** Index inside the cell's list, so removal is a swap instead of a search */
+		int32 Slot;
+	};
+
+	using FCell = TArray<int32, TInlineAllocator<4>>;
+
+	FIntPoint CellOf(const FVector& Location) const;
+	void LinkToCell(int32 Id);
+	void UnlinkFromCell(int32 Id);
+
+	template <typename FunctorType>
+	void ForEachInCells(const FIntPoint& Min, const FIntPoint& Max, FunctorType&& Functor) const
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+		{
+			for (int32 X = Min.X; X <= Max.X; ++X)
+			{
+				if (const FCell* Cell = Cells.Find(FIntPoint(X, Y)))
+				{
+					for (const int32 Id : *Cell)
+					{
+						Functor(Id);
+					}
+				}
+			}
+		}
+	}
+
+	TSparseArray<FEntry> Entries;
+	TMap<FIntPoint, FCell> Cells;
+	double CellSize;
+};
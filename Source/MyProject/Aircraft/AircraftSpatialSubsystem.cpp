@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AircraftSpatialSubsystem.h"
+
+#include "AAircraftBase.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<float> CVarSpatialCellSize(
+	TEXT("ac.Spatial.CellSize"),
+	50000.f,
+	TEXT("Size (cm) of the grid cells aircraft proximity queries are answered from. Read when the world starts."),
+	ECVF_Default);
+
+bool UAircraftSpatialSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAircraftSpatialSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Grid = FAircraftSpatialGrid(CVarSpatialCellSize.GetValueOnGameThread());
+}
+
+void UAircraftSpatialSubsystem::Deinitialize()
+{
+	Grid = FAircraftSpatialGrid(CVarSpatialCellSize.GetValueOnGameThread());
+	Aircraft.Reset();
+
+	Super::Deinitialize();
+}
+
+int32 UAircraftSpatialSubsystem::RegisterAircraft(AAAircraftBase* InAircraft)
+{
+	check(InAircraft);
+	const int32 Handle = Grid.Add(InAircraft->GetActorLocation());
+	if (Aircraft.Num() <= Handle)
+	{
+		Aircraft.SetNum(Handle + 1);
+	}
+	Aircraft[Handle] = InAircraft;
+	return Handle;
+}
+
+void UAircraftSpatialSubsystem::UnregisterAircraft(int32 Handle)
+{
+	Grid.Remove(Handle);
+	Aircraft[Handle] = nullptr;
+}
+
+void UAircraftSpatialSubsystem::ResolveIds(TArray<AAAircraftBase*>& OutAircraft) const
+{
+	OutAircraft.Reset(ScratchIds.Num());
+	for (const int32 Id : ScratchIds)
+	{
+		OutAircraft.Add(Aircraft[Id]);
+	}
+}
+
+void UAircraftSpatialSubsystem::QueryRadius(const FVector& Center, double Radius, TArray<AAAircraftBase*>& OutAircraft) const
+{
+	Grid.QueryRadius(Center, Radius, ScratchIds);
+	ResolveIds(OutAircraft);
+}
+
+void UAircraftSpatialSubsystem::QueryCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Range, TArray<AAAircraftBase*>& OutAircraft) const
+{
+	Grid.QueryCone(Origin, Direction.GetSafeNormal(), HalfAngleDegrees, Range, ScratchIds);
+	ResolveIds(OutAircraft);
+}
+
+void UAircraftSpatialSubsystem::QueryNearest(const FVector& Origin, int32 Count, TArray<AAAircraftBase*>& OutAircraft, double MaxRadius) const
+{
+	Grid.QueryNearest(Origin, Count, MaxRadius, ScratchIds);
+	ResolveIds(OutAircraft);
+}
+
+bool UAircraftSpatialSubsystem::IsAnyAircraftWithin(const FVector& Center, double Radius) const
+{
+	Grid.QueryRadius(Center, Radius, ScratchIds);
+	return !ScratchIds.IsEmpty();
+}
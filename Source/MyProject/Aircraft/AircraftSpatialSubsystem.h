@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AircraftSpatialGrid.h"
+#include "AircraftSpatialSubsystem.generated.h"
+
+class AAAircraftBase;
+
+/**
+ * "Who is near me" for every aircraft in the world, on server and clients alike. Each aircraft's movement
+ * component keeps its entry current after every step, so queries never walk the actor list.
+ */
+UCLASS()
+class MYPROJECT_API UAircraftSpatialSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Returns the handle the aircraft passes to UpdateAircraft / UnregisterAircraft */
+	int32 RegisterAircraft(AAAircraftBase* InAircraft);
+	void UnregisterAircraft(int32 Handle);
+	void UpdateAircraft(int32 Handle, const FVector& Location) { Grid.Update(Handle, Location); }
+
+	void QueryRadius(const FVector& Center, double Radius, TArray<AAAircraftBase*>& OutAircraft) const;
+	void QueryCone(const FVector& Origin, const FVector& Direction, double HalfAngleDegrees, double Range, TArray<AAAircraftBase*>& OutAircraft) const;
+	/** Closest first */
+	void QueryNearest(const FVector& Origin, int32 Count, TArray<AAAircraftBase*>& OutAircraft, double MaxRadius = UE_DOUBLE_BIG_NUMBER) const;
+	bool IsAnyAircraftWithin(const FVector& Center, double Radius) const;
+
+private:
+	void ResolveIds(TArray<AAAircraftBase*>& OutAircraft) const;
+
+	FAircraftSpatialGrid Grid;
+
+	/** Indexed by grid id */
+	UPROPERTY()
+	TArray<TObjectPtr<AAAircraftBase>> Aircraft;
+
+	mutable TArray<int32> ScratchIds;
+};
@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AirflowField.h"
+
+// Keeps a badly sized config from allocating the whole machine
+static constexpr int32 MaxCells = 4 * 1024 * 1024;
+
+// Full strength up to three quarters of the top, then linear down to nothing
+static double FadeBelow(double Altitude, double TopAltitude)
+{
+	const double Top = FMath::Max(TopAltitude, 1.0);
+	return FMath::Clamp((Top - Altitude) / (0.25 * Top), 0.0, 1.0);
+}
+
+static FAirflowSample LerpSample(const FAirflowSample& A, const FAirflowSample& B, float Alpha)
+{
+	FAirflowSample Result;
+	Result.Wind       = A.Wind + (B.Wind - A.Wind) * Alpha;
+	Result.Updraft    = A.Updraft + (B.Updraft - A.Updraft) * Alpha;
+	Result.Turbulence = A.Turbulence + (B.Turbulence - A.Turbulence) * Alpha;
+	return Result;
+}
+
+void FAirflowField::Reset()
+{
+	Cells.Reset();
+	Dims = FIntVector::ZeroValue;
+}
+
+void FAirflowField::Build(const FAirflowFieldConfig& Config)
+{
+	Reset();
+	if (!Config.Bounds.IsValid) return;
+
+	const FVector CellSize(FMath::Max(Config.CellSize, 100.f), FMath::Max(Config.CellSize, 100.f), FMath::Max(Config.CellHeight, 100.f));
+	const FVector Size = Config.Bounds.GetSize();
+
+	// Nodes sit on the cell corners, at least two per axis so every lookup has a cell to blend in
+	Dims = FIntVector(
+		FMath::Max(2, FMath::CeilToInt32(Size.X / CellSize.X) + 1),
+		FMath::Max(2, FMath::CeilToInt32(Size.Y / CellSize.Y) + 1),
+		FMath::Max(2, FMath::CeilToInt32(Size.Z / CellSize.Z) + 1));
+
+	if (int64(Dims.X) * Dims.Y * Dims.Z > MaxCells)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[Airflow] %dx%dx%d cells is too many, increase CellSize/CellHeight. Field disabled."), Dims.X, Dims.Y, Dims.Z);
+		Dims = FIntVector::ZeroValue;
+		return;
+	}
+
+	Origin = Config.Bounds.Min;
+	InvCellSize = FVector(1.0 / CellSize.X, 1.0 / CellSize.Y, 1.0 / CellSize.Z);
+	InvTurbulenceScale = 1.0 / FMath::Max(Config.TurbulenceScale, 1.f);
+	TurbulenceDrift = Config.TurbulenceDrift;
+
+	Cells.SetNumUninitialized(Dims.X * Dims.Y * Dims.Z);
+	for (int32 Z = 0; Z < Dims.Z; ++Z)
+	{
+		for (int32 Y = 0; Y < Dims.Y; ++Y)
+		{
+			for (int32 X = 0; X < Dims.X; ++X)
+			{
+				Cells[GetCellIndex(X, Y, Z)] = Evaluate(Config, Origin + FVector(X, Y, Z) * CellSize);
+			}
+		}
+	}
+}
+
+FAirflowSample FAirflowField::Evaluate(const FAirflowFieldConfig& Config, const FVector& Location)
+{
+	FAirflowSample Result;
+	Result.Wind = FVector3f(Config.BaseWind);
+	Result.Turbulence = Config.BaseTurbulence;
+
+	const FVector2D Point(Location);
+	double Lift = 0.0;
+
+	for (const FAirflowThermal& Thermal : Config.Thermals)
+	{
+		const double DistSq = FVector2D::DistSquared(Point, FVector2D(Thermal.Center));
+		const double Falloff = FMath::Exp(-DistSq / FMath::Square(FMath::Max<double>(Thermal.Radius, 1.0)));
+		Lift += Thermal.Strength * Falloff * FadeBelow(Location.Z, Thermal.TopAltitude);
+	}
+
+	// Slope lift needs wind blowing onto the ridge, along it there is none
+	const FVector2D WindDir = FVector2D(Config.BaseWind).GetSafeNormal();
+	for (const FAirflowRidge& Ridge : Config.Ridges)
+	{
+		const FVector2D Start(Ridge.Start);
+		const FVector2D End(Ridge.End);
+		const FVector2D Along = (End - Start).GetSafeNormal();
+		const double Across = FMath::Abs(FVector2D::DotProduct(WindDir, FVector2D(-Along.Y, Along.X)));
+
+		const double DistSq = FVector2D::DistSquared(Point, FMath::ClosestPointOnSegment2D(Point, Start, End));
+		const double Falloff = FMath::Exp(-DistSq / FMath::Square(FMath::Max<double>(Ridge.Width, 1.0)));
+		Lift += Ridge.Strength * Across * Falloff * FadeBelow(Location.Z, Ridge.TopAltitude);
+	}
+
+	Result.Updraft = static_cast<float>(Lift);
+	Result.Turbulence += static_cast<float>(Lift * Config.LiftTurbulenceRatio);
+	return Result;
+}
+
+FAirflowSample FAirflowField::Sample(const FVector& Location) const
+{
+	if (Cells.IsEmpty()) return FAirflowSample();
+
+	const FVector Local = (Location - Origin) * InvCellSize;
+	const double FX = FMath::Clamp(Local.X, 0.0, double(Dims.X - 1));
+	const double FY = FMath::Clamp(Local.Y, 0.0, double(Dims.Y - 1));
+	const double FZ = FMath::Clamp(Local.Z, 0.0, double(Dims.Z - 1));
+
+	// The far border uses the last cell with an alpha of 1
+	const int32 X = FMath::Min(static_cast<int32>(FX), Dims.X - 2);
+	const int32 Y = FMath::Min(static_cast<int32>(FY), Dims.Y - 2);
+	const int32 Z = FMath::Min(static_cast<int32>(FZ), Dims.Z - 2);
+	const float AX = static_cast<float>(FX - X);
+	const float AY = static_cast<float>(FY - Y);
+	const float AZ = static_cast<float>(FZ - Z);
+
+	const int32 Base = GetCellIndex(X, Y, Z);
+	const int32 StepY = Dims.X;
+	const int32 StepZ = Dims.X * Dims.Y;
+	const FAirflowSample* C = Cells.GetData() + Base;
+
+	const FAirflowSample Bottom = LerpSample(LerpSample(C[0], C[1], AX), LerpSample(C[StepY], C[StepY + 1], AX), AY);
+	const FAirflowSample Top    = LerpSample(LerpSample(C[StepZ], C[StepZ + 1], AX), LerpSample(C[StepZ + StepY], C[StepZ + StepY + 1], AX), AY);
+	return LerpSample(Bottom, Top, AZ);
+}
+
+FVector FAirflowField::SampleTurbulence(const FVector& Location, double Time) const
+{
+	// Offsets decorrelate the three axes, the drift moves the eddies through space instead of pulsing them in place
+	const FVector Point = (Location + FVector(TurbulenceDrift * Time, TurbulenceDrift * 0.6 * Time, 0.0)) * InvTurbulenceScale;
+	return FVector(
+		FMath::PerlinNoise3D(Point),
+		FMath::PerlinNoise3D(Point + FVector(31.7, 0.0, 0.0)),
+		FMath::PerlinNoise3D(Point + FVector(0.0, 57.3, 0.0)));
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MyProject/GCore/Config/EnvConfigs.h"
+
+/** Airflow at one point, force units like FEnvAirflow */
+struct FAirflowSample
+{
+	FVector3f Wind = FVector3f::ZeroVector;
+	float Updraft = 0.f;
+	/** Strength the turbulence noise is scaled by */
+	float Turbulence = 0.f;
+};
+
+/**
+ * Airflow over the map baked into a coarse 3D grid. Thermals, ridge lift and base wind are evaluated once per
+ * cell in Build, a lookup is then eight cell reads and a trilinear blend. Turbulence comes from scrolling
+ * Perlin noise so neighbouring aircraft, and one aircraft over consecutive steps, feel the same gusts.
+ * Read-only after Build, safe to sample from any thread.
+ */
+class MYPROJECT_API FAirflowField
+{
+public:
+	void Build(const FAirflowFieldConfig& Config);
+	void Reset();
+	bool IsEmpty() const { return Cells.IsEmpty(); }
+
+	/** Trilinear lookup, clamped to the border cells outside the bounds */
+	FAirflowSample Sample(const FVector& Location) const;
+
+	/** Coherent noise vector, each component in [-1, 1], drifting with Time */
+	FVector SampleTurbulence(const FVector& Location, double Time) const;
+
+	/** The analytic field the grid is baked from */
+	static FAirflowSample Evaluate(const FAirflowFieldConfig& Config, const FVector& Location);
+
+private:
+	int32 GetCellIndex(int32 X, int32 Y, int32 Z) const { return (Z * Dims.Y + Y) * Dims.X + X; }
+
+	FVector Origin = FVector::ZeroVector;
+	FVector InvCellSize = FVector::OneVector;
+	FIntVector Dims = FIntVector::ZeroValue;
+	TArray<FAirflowSample> Cells;
+
+	double InvTurbulenceScale = 0.0;
+	double TurbulenceDrift = 0.0;
+};
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AirflowFieldSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+
+bool UAirflowFieldSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAirflowFieldSubsystem::Deinitialize()
+{
+	Field.Reset();
+
+	Super::Deinitialize();
+}
+
+void UAirflowFieldSubsystem::SetConfig(const FAirflowFieldConfig& InConfig)
+{
+	Field.Build(InConfig);
+}
+
+double UAirflowFieldSubsystem::GetFieldTime() const
+{
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+FFlightEnvironment UAirflowFieldSubsystem::SampleEnvironment(const FEnvAirflow& LocalAirflow, const FVector& Location, double Time, FVector& OutTurbulence) const
+{
+	if (Field.IsEmpty())
+	{
+		OutTurbulence = FVector::ZeroVector;
+		return FFlightEnvironment::Make(LocalAirflow, OutTurbulence);
+	}
+
+	const FAirflowSample Sample = Field.Sample(Location);
+	OutTurbulence = Field.SampleTurbulence(Location, Time);
+
+	FFlightEnvironment Environment = FFlightEnvironment::Make(LocalAirflow, OutTurbulence);
+	Environment.Wind       += FVector(Sample.Wind);
+	Environment.Updraft    += Sample.Updraft;
+	Environment.Turbulence += OutTurbulence * Sample.Turbulence;
+	return Environment;
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AirflowField.h"
+#include "FlightDynamics.h"
+#include "AirflowFieldSubsystem.generated.h"
+
+/**
+ * Owns the map's FAirflowField and turns samples of it into the FFlightEnvironment a flight step uses.
+ * The game state builds it from its config on the server and on every client, so predicted and
+ * authoritative steps feel the same air. Sampling is read-only and may run on the flight workers.
+ */
+UCLASS()
+class MYPROJECT_API UAirflowFieldSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	void SetConfig(const FAirflowFieldConfig& InConfig);
+	const FAirflowField& GetField() const { return Field; }
+
+	/**
+	 * Clock the turbulence drifts with, the replicated server time. Flight steps do not sample at it directly:
+	 * aircraft take it once as their field epoch and count steps from there, so a step's gusts depend on its frame only.
+	 */
+	double GetFieldTime() const;
+
+	/**
+	 * The aircraft's own airflow plus the field at Location. OutTurbulence receives the raw noise vector,
+	 * which FEnvAirflow::TurbulenceStrength scales.
+	 */
+	FFlightEnvironment SampleEnvironment(const FEnvAirflow& LocalAirflow, const FVector& Location, double Time, FVector& OutTurbulence) const;
+
+private:
+	FAirflowField Field;
+};
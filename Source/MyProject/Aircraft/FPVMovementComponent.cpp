@@ -3,22 +3,409 @@
 
 #include "FPVMovementComponent.h"
 
+#include "AAircraftBase.h"
+#include "AircraftSpatialSubsystem.h"
+#include "FlightRecorder.h"
+#include "FlightSimSubsystem.h"
+#include "FlightStats.h"
+#include "TerrainHeightfieldSubsystem.h"
+#include "GameFramework/GameStateBase.h"
 #include "Net/UnrealNetwork.h"
+#include "UObject/CoreNet.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapshot Underruns"), STAT_FlightSnapshotUnderruns, STATGROUP_FlightNet);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Snapshot Extrapolations Capped"), STAT_FlightSnapshotCapped, STATGROUP_FlightNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input RPCs Throttled"), STAT_FlightInputRpcsThrottled, STATGROUP_FlightNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Input Frames Rejected"), STAT_FlightInputFramesRejected, STATGROUP_FlightNet);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Implausible Steps Clamped"), STAT_FlightImplausibleSteps, STATGROUP_FlightNet);
+
+static TAutoConsoleVariable<bool> CVarFlightSweepMoves(
+	TEXT("ac.Flight.SweepMoves"),
+	false,
+	TEXT("Sweep the aircraft's collision when its pawn is moved to a new flight state and stop at blocking hits. Aircraft batched by UFlightSimSubsystem only collide with the terrain heightfield."),
+	ECVF_Default);
+
+// Quantization must match on server and clients, so these are only read from config
+static TAutoConsoleVariable<float> CVarNetPositionQuantum(
+	TEXT("ac.Net.PositionQuantum"),
+	1.f,
+	TEXT("Grid size (cm) FServerState locations are quantized to on the wire."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarNetLinearVelocityQuantum(
+	TEXT("ac.Net.LinearVelocityQuantum"),
+	1.f,
+	TEXT("Step (cm/s) FServerState linear velocities are quantized to on the wire."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarNetAngularVelocityQuantum(
+	TEXT("ac.Net.AngularVelocityQuantum"),
+	0.01f,
+	TEXT("Step (deg/s) FServerState angular velocities are quantized to on the wire."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<int32> CVarNetStateFullInterval(
+	TEXT("ac.Net.StateFullInterval"),
+	8,
+	TEXT("Every Nth distinct FServerState is sent whole, the others leave out fields unchanged since the previous state."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNetSnapshotBufferDepth(
+	TEXT("ac.Net.SnapshotBufferDepth"),
+	32,
+	TEXT("Snapshots of ServerState kept per simulated proxy."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetInterpolationDelay(
+	TEXT("ac.Net.InterpolationDelay"),
+	0.1f,
+	TEXT("Seconds behind the server clock simulated proxies are rendered at."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetMaxExtrapolation(
+	TEXT("ac.Net.MaxExtrapolation"),
+	0.25f,
+	TEXT("Seconds a simulated proxy keeps flying on its last velocity when snapshots are late."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetInputSendHz(
+	TEXT("ac.Net.InputSendHz"),
+	60.f,
+	TEXT("Maximum rate the owning client sends input packets at while its input is changing."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetInputIdleSendHz(
+	TEXT("ac.Net.InputIdleSendHz"),
+	20.f,
+	TEXT("Rate the owning client sends input packets at while its input is not changing."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNetInputRedundancy(
+	TEXT("ac.Net.InputRedundancy"),
+	16,
+	TEXT("Already-sent input frames repeated in every packet so losses recover without retransmission."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetInputRpcBudget(
+	TEXT("ac.Net.InputRpcBudget"),
+	90.f,
+	TEXT("Input RPCs per second a connection may send before packets are dropped unread."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetInputFrameSlack(
+	TEXT("ac.Net.InputFrameSlack"),
+	0.5f,
+	TEXT("Seconds of input frames a client may run ahead of real time (covers jitter bursts)."),
+	ECVF_Default);
+
+namespace FlightNetQuantize
+{
+	// Bits per non-largest quaternion component, the largest one is rebuilt from the unit length
+	constexpr int32 QuatComponentBits = 12;
+
+	enum EStateFlags : uint8
+	{
+		SendLocation        = 1 << 0,
+		SendRotation        = 1 << 1,
+		SendLinearVelocity  = 1 << 2,
+		SendAngularVelocity = 1 << 3,
+		HasInputAck         = 1 << 4,
+		NumFlagBits         = 5,
+	};
+
+	static uint32 ZigZag(int32 Value)    { return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31); }
+	static int32 UnZigZag(uint32 Value)  { return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1); }
+
+	static FIntVector QuantizeVector(const FVector& Vector, double Quantum)
+	{
+		FIntVector Steps;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Steps[Axis] = static_cast<int32>(FMath::Clamp(FMath::RoundToDouble(Vector[Axis] / Quantum), double(MIN_int32), double(MAX_int32)));
+		}
+		return Steps;
+	}
+
+	static FVector DequantizeVector(const FIntVector& Steps, double Quantum)
+	{
+		return FVector(Steps.X * Quantum, Steps.Y * Quantum, Steps.Z * Quantum);
+	}
+
+	static void SerializeVector(FArchive& Ar, FIntVector& Steps)
+	{
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			// Variable length: small values (slow aircraft, near the origin) cost fewer bytes
+			uint32 Packed = Ar.IsSaving() ? ZigZag(Steps[Axis]) : 0;
+			Ar.SerializeIntPacked(Packed);
+			if (Ar.IsLoading())
+			{
+				Steps[Axis] = UnZigZag(Packed);
+			}
+		}
+	}
+
+	static uint64 QuantizeRotation(const FRotator& Rotation)
+	{
+		constexpr uint32 MaxValue = (1u << QuatComponentBits) - 1;
+		constexpr double Range = UE_INV_SQRT_2;
+
+		FQuat Quat = Rotation.Quaternion();
+		Quat.Normalize();
+		const double Components[4] = { Quat.X, Quat.Y, Quat.Z, Quat.W };
+
+		uint32 LargestIndex = 0;
+		for (uint32 i = 1; i < 4; ++i)
+		{
+			if (FMath::Abs(Components[i]) > FMath::Abs(Components[LargestIndex])) LargestIndex = i;
+		}
+
+		// q and -q are the same rotation, so flip until the dropped component is positive
+		const double Sign = Components[LargestIndex] < 0.0 ? -1.0 : 1.0;
+		uint64 Packed = LargestIndex;
+		for (uint32 i = 0, Out = 0; i < 4; ++i)
+		{
+			if (i == LargestIndex) continue;
+			const double Normalized = (Components[i] * Sign + Range) / (2.0 * Range);
+			const uint64 Value = static_cast<uint64>(FMath::Clamp(FMath::RoundToInt(Normalized * MaxValue), 0, int32(MaxValue)));
+			Packed |= Value << (2 + QuatComponentBits * Out++);
+		}
+		return Packed;
+	}
+
+	static FRotator DequantizeRotation(uint64 Packed)
+	{
+		constexpr uint32 MaxValue = (1u << QuatComponentBits) - 1;
+		constexpr double Range = UE_INV_SQRT_2;
+
+		const uint32 LargestIndex = static_cast<uint32>(Packed & 3);
+		double Components[4];
+		double SumSquares = 0.0;
+		for (uint32 i = 0, In = 0; i < 4; ++i)
+		{
+			if (i == LargestIndex) continue;
+			const uint32 Value = static_cast<uint32>(Packed >> (2 + QuatComponentBits * In++)) & MaxValue;
+			Components[i] = (double(Value) / MaxValue) * (2.0 * Range) - Range;
+			SumSquares += Components[i] * Components[i];
+		}
+		Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.0, 1.0 - SumSquares));
+
+		FQuat Quat(Components[0], Components[1], Components[2], Components[3]);
+		Quat.Normalize();
+		return Quat.Rotator();
+	}
+
+	static void SerializeRotation(FArchive& Ar, uint64& Packed)
+	{
+		constexpr uint32 MaxValue = (1u << QuatComponentBits) - 1;
+
+		uint32 LargestIndex = static_cast<uint32>(Packed & 3);
+		Ar.SerializeInt(LargestIndex, 4);
+		uint64 Loaded = LargestIndex;
+		for (uint32 i = 0; i < 3; ++i)
+		{
+			uint32 Value = static_cast<uint32>(Packed >> (2 + QuatComponentBits * i)) & MaxValue;
+			Ar.SerializeInt(Value, MaxValue + 1);
+			Loaded |= uint64(Value & MaxValue) << (2 + QuatComponentBits * i);
+		}
+		if (Ar.IsLoading())
+		{
+			Packed = Loaded;
+		}
+	}
+}
+
+bool FServerState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace FlightNetQuantize;
+
+	const double PositionQuantum = FMath::Max(CVarNetPositionQuantum.GetValueOnAnyThread(), UE_KINDA_SMALL_NUMBER);
+	const double LinearQuantum   = FMath::Max(CVarNetLinearVelocityQuantum.GetValueOnAnyThread(), UE_KINDA_SMALL_NUMBER);
+	const double AngularQuantum  = FMath::Max(CVarNetAngularVelocityQuantum.GetValueOnAnyThread(), UE_KINDA_SMALL_NUMBER);
+
+	FServerStateWireFields Wire;
+	uint8 Flags = 0;
+	if (Ar.IsSaving())
+	{
+		Wire.Location        = QuantizeVector(Location, PositionQuantum);
+		Wire.Rotation        = QuantizeRotation(Rotation);
+		Wire.LinearVelocity  = QuantizeVector(LinearVelocity, LinearQuantum);
+		Wire.AngularVelocity = QuantizeVector(AngularVelocity, AngularQuantum);
+		Wire.bValid = true;
+
+		// Only a new state moves the baseline on, so every write of one state is the same bits
+		if (!WireLast.bValid || Wire.Location != WireLast.Location || Wire.Rotation != WireLast.Rotation
+			|| Wire.LinearVelocity != WireLast.LinearVelocity || Wire.AngularVelocity != WireLast.AngularVelocity)
+		{
+			WireBaseline = WireLast;
+			WireLast = Wire;
+			++NumWireStates;
+		}
+
+		// A reader that missed states (loss, joined late) is whole again at the next full state
+		const int32 FullInterval = FMath::Max(1, CVarNetStateFullInterval.GetValueOnAnyThread());
+		const bool bFull = !WireBaseline.bValid || NumWireStates % FullInterval == 0;
+		if (bFull || Wire.Location != WireBaseline.Location)                 Flags |= SendLocation;
+		if (bFull || Wire.Rotation != WireBaseline.Rotation)                 Flags |= SendRotation;
+		if (bFull || Wire.LinearVelocity != WireBaseline.LinearVelocity)     Flags |= SendLinearVelocity;
+		if (bFull || Wire.AngularVelocity != WireBaseline.AngularVelocity)   Flags |= SendAngularVelocity;
+		if (LastProcessedInput != 0)                                         Flags |= HasInputAck;
+	}
+	else
+	{
+		Wire = WireBaseline;
+	}
+	Ar.SerializeBits(&Flags, NumFlagBits);
+
+	if (Flags & SendLocation)          SerializeVector(Ar, Wire.Location);
+	if (Flags & SendRotation)          SerializeRotation(Ar, Wire.Rotation);
+	if (Flags & SendLinearVelocity)    SerializeVector(Ar, Wire.LinearVelocity);
+	if (Flags & SendAngularVelocity)   SerializeVector(Ar, Wire.AngularVelocity);
+
+	if (Flags & HasInputAck)           Ar.SerializeIntPacked(LastProcessedInput);
+	else if (Ar.IsLoading())           LastProcessedInput = 0;
+
+	// Millisecond timestamps are plenty for interpolation
+	uint32 TimeMs = Ar.IsSaving() ? static_cast<uint32>(FMath::Max(0.0, ServerTime) * 1000.0 + 0.5) : 0;
+	Ar.SerializeIntPacked(TimeMs);
+
+	if (Ar.IsLoading() && !Ar.IsError())
+	{
+		ServerTime = TimeMs / 1000.0;
+
+		// Without a baseline a partial state has nothing to fill the gaps from, keep what we had until a full one
+		constexpr uint8 AllFields = SendLocation | SendRotation | SendLinearVelocity | SendAngularVelocity;
+		if (WireBaseline.bValid || (Flags & AllFields) == AllFields)
+		{
+			Location        = DequantizeVector(Wire.Location, PositionQuantum);
+			Rotation        = DequantizeRotation(Wire.Rotation);
+			LinearVelocity  = DequantizeVector(Wire.LinearVelocity, LinearQuantum);
+			AngularVelocity = DequantizeVector(Wire.AngularVelocity, AngularQuantum);
+			Wire.bValid = true;
+			WireBaseline = Wire;
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+FFlightInputFrame FFlightInputFrame::Make(uint32 InSequence, float InThrust, const FVector2D& InSteering, float InYaw)
+{
+	FFlightInputFrame Frame;
+	Frame.Sequence  = InSequence;
+	Frame.Thrust    = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(InThrust, 0.f, 1.f) * 255.f));
+	Frame.SteeringX = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(InSteering.X, -1.f, 1.f) * 127.f));
+	Frame.SteeringY = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(InSteering.Y, -1.f, 1.f) * 127.f));
+	Frame.Yaw       = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(InYaw, -1.f, 1.f) * 127.f));
+	return Frame;
+}
+
+FFlightControls FFlightInputFrame::GetControls() const
+{
+	const FVector2D Steering = GetSteering();
+	return { FMath::Clamp(GetThrust(), 0.f, 1.f), FVector2D(FMath::Clamp(Steering.X, -1.f, 1.f), FMath::Clamp(Steering.Y, -1.f, 1.f)), FMath::Clamp(GetYaw(), -1.f, 1.f) };
+}
+
+bool FFlightInputPacket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// Caps what a single packet can make the server allocate and simulate
+	constexpr uint32 MaxFrames = 256;
+
+	uint32 FirstSequence = Frames.Num() > 0 ? Frames[0].Sequence : 0;
+	Ar.SerializeIntPacked(FirstSequence);
+
+	if (Ar.IsSaving())
+	{
+		// Count runs first so the reader knows how many follow
+		uint32 NumRuns = 0;
+		for (int32 i = 0; i < Frames.Num(); ++i)
+		{
+			NumRuns += (i == 0 || !Frames[i].HasSameInput(Frames[i - 1])) ? 1 : 0;
+		}
+		Ar.SerializeIntPacked(NumRuns);
+
+		for (int32 RunStart = 0; RunStart < Frames.Num();)
+		{
+			int32 RunEnd = RunStart + 1;
+			while (RunEnd < Frames.Num() && Frames[RunEnd].HasSameInput(Frames[RunStart])) ++RunEnd;
+
+			FFlightInputFrame& Frame = Frames[RunStart];
+			uint32 Repeat = RunEnd - RunStart - 1;
+			Ar << Frame.Thrust << Frame.SteeringX << Frame.SteeringY << Frame.Yaw;
+			Ar.SerializeIntPacked(Repeat);
+
+			RunStart = RunEnd;
+		}
+	}
+	else
+	{
+		uint32 NumRuns = 0;
+		Ar.SerializeIntPacked(NumRuns);
+		if (NumRuns > MaxFrames)
+		{
+			Ar.SetError();
+		}
+
+		Frames.Reset();
+		for (uint32 Run = 0; Run < NumRuns && !Ar.IsError(); ++Run)
+		{
+			FFlightInputFrame Frame;
+			uint32 Repeat = 0;
+			Ar << Frame.Thrust << Frame.SteeringX << Frame.SteeringY << Frame.Yaw;
+			Ar.SerializeIntPacked(Repeat);
+
+			if (Repeat >= MaxFrames || Frames.Num() + Repeat + 1 > MaxFrames)
+			{
+				Ar.SetError();
+				break;
+			}
+
+			for (uint32 i = 0; i <= Repeat; ++i)
+			{
+				Frame.Sequence = FirstSequence + Frames.Num();
+				Frames.Add(Frame);
+			}
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
 
 UFPVMovementComponent::UFPVMovementComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 	SetIsReplicatedByDefault(true);
-	LastLinearVelocity = FVector::ZeroVector;
 }
 
 void UFPVMovementComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	DOREPLIFETIME(UFPVMovementComponent, ServerState);
+	DOREPLIFETIME_CONDITION(UFPVMovementComponent, FieldEpoch, COND_InitialOnly);
 
 }
 
+void UFPVMovementComponent::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+#if FLIGHT_PROFILING
+	// Wire size of each new state, through the same serializer replication uses
+	if (ServerState.ServerTime != LastMeasuredStateTime)
+	{
+		LastMeasuredStateTime = ServerState.ServerTime;
+
+		FServerState State = ServerState;
+		FNetBitWriter Writer(nullptr, 512);
+		bool bSuccess = false;
+		State.NetSerialize(Writer, nullptr, bSuccess);
+		FlightStats::CountReplicatedState(static_cast<int32>(Writer.GetNumBytes()));
+	}
+#endif
+}
+
 
 
 void UFPVMovementComponent::BeginPlay()
@@ -26,12 +413,41 @@ void UFPVMovementComponent::BeginPlay()
 	Super::BeginPlay();
 	if (PawnOwner)
 	{
-		SimulatedLocation = PawnOwner->GetActorLocation();
-		SimulatedRotation = PawnOwner->GetActorRotation();
+		Body.Location = PawnOwner->GetActorLocation();
+		Body.Rotation = PawnOwner->GetActorQuat();
 		ServerState.Location = GetActorLocation();
-		LastLinearVelocity = PawnOwner->GetActorForwardVector()*100;
+		Body.LinearVelocity = PawnOwner->GetActorForwardVector()*100;
 		ServerState.LinearVelocity = ServerState.Rotation.RotateVector(FVector(0, 0, 0));
 		ServerState.AngularVelocity = ServerState.Rotation.RotateVector(FVector(0, 0, 0));
+
+		Spatial = GetWorld()->GetSubsystem<UAircraftSpatialSubsystem>();
+		Terrain = GetWorld()->GetSubsystem<UTerrainHeightfieldSubsystem>();
+		Recorder = FFlightRecorder::MakeForAircraft();
+		SweepComponent = PawnOwner->FindComponentByClass<UPrimitiveComponent>();
+		AAAircraftBase* Aircraft = Cast<AAAircraftBase>(PawnOwner);
+		if (Spatial && Aircraft)
+		{
+			SpatialHandle = Spatial->RegisterAircraft(Aircraft);
+		}
+	}
+}
+
+void UFPVMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Spatial && SpatialHandle != INDEX_NONE)
+	{
+		Spatial->UnregisterAircraft(SpatialHandle);
+		SpatialHandle = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFPVMovementComponent::SyncSpatialEntry()
+{
+	if (Spatial && SpatialHandle != INDEX_NONE)
+	{
+		Spatial->UpdateAircraft(SpatialHandle, PawnOwner->GetActorLocation());
 	}
 }
 
@@ -42,139 +458,449 @@ void UFPVMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 	if (!PawnOwner) return;
 
 	// SERVER & OWNING CLIENT ARE ALREADY BEING called to be MOVED!!
-	// Simulated proxies smooth to ServerState
+	// Simulated proxies replay ServerState a fixed delay behind the server clock
 	if (!PawnOwner->IsLocallyControlled() && !PawnOwner->HasAuthority())
 	{
-		FVector Goal = ServerState.Location;
-		FRotator GoalRot = ServerState.Rotation;
-
-		float Dist = FVector::Dist(SimulatedLocation, Goal);
-		if (Dist > TeleportThreshold)
+		FVector Location;
+		FQuat Rotation;
+		if (SampleSnapshots(GetProxyRenderTime(GetWorld()), Location, Rotation))
 		{
-			SimulatedLocation = Goal;
-			SimulatedRotation = GoalRot;
+			Body.Location = Location;
+			Body.Rotation = Rotation;
+			PawnOwner->SetActorLocationAndRotation(Location, Rotation);
+			SyncSpatialEntry();
 		}
-		else
+	}
+}
+
+// ONLY FOR SERVER & IT'S MULTICASTING!!
+void UFPVMovementComponent::OnRep_ServerState()
+{
+	FLIGHT_SCOPE(FlightNet, OnRepServerState);
+	if (!PawnOwner) return;
+
+	RecordState(EFlightRecordType::ServerState);
+
+	if (PawnOwner->IsLocallyControlled())
+	{
+		ReconcileWithServer();
+		return;
+	}
+
+	// On simulated proxies, queue the new state
+	PushSnapshot(ServerState);
+}
+
+void UFPVMovementComponent::PushSnapshot(const FServerState& State)
+{
+	const int32 Depth = FMath::Max(2, CVarNetSnapshotBufferDepth.GetValueOnGameThread());
+	if (Snapshots.Num() != Depth)
+	{
+		Snapshots.SetNum(Depth);
+		SnapshotStart = NumSnapshots = 0;
+	}
+
+	if (NumSnapshots > 0)
+	{
+		const FFlightSnapshot& Newest = Snapshots[(SnapshotStart + NumSnapshots - 1) % Depth];
+		if (State.ServerTime <= Newest.Time) return;
+
+		// Respawn or teleport: interpolating across the jump would streak the aircraft over the map
+		if (FVector::Dist(Newest.Location, State.Location) > TeleportThreshold + Newest.LinearVelocity.Size() * (State.ServerTime - Newest.Time))
 		{
-			SimulatedLocation = FMath::VInterpTo(SimulatedLocation, Goal, DeltaTime, 10.f);
-			SimulatedRotation = FMath::RInterpTo(SimulatedRotation, GoalRot, DeltaTime, 10.f);
+			SnapshotStart = NumSnapshots = 0;
 		}
+	}
 
-		PawnOwner->SetActorLocation(SimulatedLocation);
-		PawnOwner->SetActorRotation(SimulatedRotation);
+	if (NumSnapshots == Depth)
+	{
+		SnapshotStart = (SnapshotStart + 1) % Depth;
+		--NumSnapshots;
 	}
 
-	if (PawnOwner->IsLocallyControlled())
+	FFlightSnapshot& Snapshot = Snapshots[(SnapshotStart + NumSnapshots) % Depth];
+	Snapshot.Time = State.ServerTime;
+	Snapshot.Location = State.Location;
+	Snapshot.Rotation = State.Rotation.Quaternion();
+	Snapshot.LinearVelocity = State.LinearVelocity;
+	++NumSnapshots;
+}
+
+bool UFPVMovementComponent::SampleSnapshots(double RenderTime, FVector& OutLocation, FQuat& OutRotation)
+{
+	if (NumSnapshots == 0) return false;
+
+	const int32 Depth = Snapshots.Num();
+	auto At = [this, Depth](int32 i) -> const FFlightSnapshot& { return Snapshots[(SnapshotStart + i) % Depth]; };
+
+	// Older than anything buffered: hold the oldest snapshot
+	if (RenderTime <= At(0).Time)
 	{
-		Server_SyncTrasnform(PawnOwner->GetActorLocation(), PawnOwner->GetActorRotation(), DeltaTime);
+		OutLocation = At(0).Location;
+		OutRotation = At(0).Rotation;
+		return true;
 	}
+
+	// Bracketed: Hermite curve through both snapshots, tangents from the replicated velocities
+	for (int32 i = NumSnapshots - 1; i > 0; --i)
+	{
+		const FFlightSnapshot& From = At(i - 1);
+		const FFlightSnapshot& To = At(i);
+		if (RenderTime < From.Time) continue;
+		// Past the newest pair: Alpha would exceed 1 and the Hermite curve runs away, extrapolate below instead
+		if (RenderTime > To.Time) break;
+
+		const double Span = To.Time - From.Time;
+		const float Alpha = static_cast<float>((RenderTime - From.Time) / Span);
+		OutLocation = FMath::CubicInterp(From.Location, From.LinearVelocity * Span, To.Location, To.LinearVelocity * Span, Alpha);
+		OutRotation = FQuat::Slerp(From.Rotation, To.Rotation, Alpha);
+
+		// Everything before From is no longer needed
+		SnapshotStart = (SnapshotStart + i - 1) % Depth;
+		NumSnapshots -= i - 1;
+		return true;
+	}
+
+	// Newer than anything buffered: the next snapshot is late, extrapolate for a bounded time
+	const FFlightSnapshot& Newest = At(NumSnapshots - 1);
+	const double MaxExtrapolation = CVarNetMaxExtrapolation.GetValueOnGameThread();
+	const double Ahead = RenderTime - Newest.Time;
+	INC_DWORD_STAT(STAT_FlightSnapshotUnderruns);
+	if (Ahead > MaxExtrapolation)
+	{
+		INC_DWORD_STAT(STAT_FlightSnapshotCapped);
+	}
+
+	OutLocation = Newest.Location + Newest.LinearVelocity * FMath::Min(Ahead, MaxExtrapolation);
+	OutRotation = Newest.Rotation;
+	return true;
 }
 
-// ONLY FOR SERVER & IT'S MULTICASTING!!
-void UFPVMovementComponent::OnRep_ServerState()
+float UFPVMovementComponent::GetNetStepSeconds()
 {
-	// On simulated proxies, update target
-	if (!PawnOwner || PawnOwner->IsLocallyControlled()) return;
+	// Prediction needs a fixed step even when ac.Flight.FixedStepHz is 0
+	const float FixedStep = UFlightSimSubsystem::GetFixedStepSeconds();
+	return FixedStep > 0.f ? FixedStep : 1.f / 60.f;
+}
 
-	SimulatedLocation = PawnOwner->GetActorLocation(); // start point for interp
-	SimulatedRotation = PawnOwner->GetActorRotation();
+double UFPVMovementComponent::GetProxyRenderTime(const UWorld* World)
+{
+	const AGameStateBase* GameState = World->GetGameState();
+	const double ServerNow = GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+	return ServerNow - CVarNetInterpolationDelay.GetValueOnGameThread();
 }
 
-void UFPVMovementComponent::Server_SyncTrasnform_Implementation(FVector OwningClientLocation,
-	FRotator OwningClientRotation, float DeltaTime)
+bool UFPVMovementComponent::IsDrivenByRemoteInputs() const
 {
-	const FVector ServerLoc = PawnOwner->GetActorLocation();
-	const FRotator ServerRot = PawnOwner->GetActorRotation();
+	return PawnOwner && PawnOwner->HasAuthority() && PawnOwner->IsPlayerControlled() && !PawnOwner->IsLocallyControlled();
+}
 
-	if (!ServerLoc.Equals(OwningClientLocation, 5.f))
+void UFPVMovementComponent::RecordPredictedMove(const FFlightInputFrame& Input)
+{
+	if (PredictionHistory.Num() != PredictionHistorySize)
 	{
-		PawnOwner->SetActorLocation(FMath::VInterpTo(ServerLoc, OwningClientLocation, DeltaTime, 10.f));
+		PredictionHistory.SetNum(FMath::Max(PredictionHistorySize, 1));
 	}
 
-	if (!ServerRot.Equals(OwningClientRotation, 1.f))
+	FPredictedMove& Move = PredictionHistory[Input.Sequence % PredictionHistory.Num()];
+	Move.Input = Input;
+	Move.Body = Body;
+}
+
+bool UFPVMovementComponent::BuildInputPacket(float DeltaTime, FFlightInputPacket& OutPacket)
+{
+	TimeSinceInputSend += DeltaTime;
+
+	const uint32 Latest = NextInputSequence - 1;
+	if (PredictionHistory.IsEmpty() || Latest == 0 || Latest == LastSentInput.Sequence) return false;
+
+	// Input changes go out promptly, a held stick only needs the occasional packet to keep the server stepping
+	const FFlightInputFrame& LatestInput = PredictionHistory[Latest % PredictionHistory.Num()].Input;
+	const bool bInputChanged = !LatestInput.HasSameInput(LastSentInput);
+	const float SendHz = bInputChanged ? CVarNetInputSendHz.GetValueOnGameThread() : CVarNetInputIdleSendHz.GetValueOnGameThread();
+	if (SendHz <= 0.f || TimeSinceInputSend < 1.f / SendHz) return false;
+
+	// Everything not sent yet, plus up to Redundancy frames that were sent but not acknowledged
+	const uint32 Redundancy = static_cast<uint32>(FMath::Max(0, CVarNetInputRedundancy.GetValueOnGameThread()));
+	const uint32 Unsent = LastSentInput.Sequence + 1;
+	uint32 First = Unsent > Redundancy ? Unsent - Redundancy : 1;
+	First = FMath::Max3(First, GetLastProcessedInput() + 1, Latest + 1 - FMath::Min<uint32>(Latest, PredictionHistory.Num()));
+
+	OutPacket.Frames.Reset();
+	for (uint32 Sequence = First; Sequence <= Latest; ++Sequence)
 	{
-		PawnOwner->SetActorRotation(FMath::RInterpTo(ServerRot, OwningClientRotation, DeltaTime, 10.f));
+		const FPredictedMove& Move = PredictionHistory[Sequence % PredictionHistory.Num()];
+		if (Move.Input.Sequence != Sequence)
+		{
+			// Frames in a packet must be consecutive: restart after a hole in the history
+			OutPacket.Frames.Reset();
+			continue;
+		}
+		OutPacket.Frames.Add(Move.Input);
 	}
 
+	LastSentInput = LatestInput;
+	TimeSinceInputSend = 0.f;
+	return OutPacket.Frames.Num() > 0;
 }
 
-// ONLY PAWN OWNER & SERVER DO THE PHYSICS CALCULATION
-void UFPVMovementComponent::ApplyPhysicsStep(float DeltaTime, const FVector& InLinearAcel, const FVector& InAngularVel)
+bool UFPVMovementComponent::AdmitInputPacket()
 {
-	if (!PawnOwner) return;
-	
-	// Integrate locally
-
-	// --- Integrate acceleration into velocity ---
-	LastLinearVelocity += InLinearAcel * DeltaTime;
+	const float Budget = CVarNetInputRpcBudget.GetValueOnGameThread();
+	if (InputRpcBudget.TryConsume(GetWorld()->GetRealTimeSeconds(), Budget, FMath::Max(1.f, Budget * 0.5f)))
+	{
+		return true;
+	}
 
-	// --- Integrate velocity into position ---
-	SimulatedLocation += LastLinearVelocity * DeltaTime;
-	
-	// --- Smooth angular velocity (damped) ---
-	float DampingFactor = 10.f; // higher = faster stop
-	LastAngularVelocity = FMath::VInterpTo(LastAngularVelocity, InAngularVel, DeltaTime, DampingFactor);
+	++NumThrottledRpcs;
+	INC_DWORD_STAT(STAT_FlightInputRpcsThrottled);
+	return false;
+}
 
-	// Snap to zero if nearly zero
-	if (LastAngularVelocity.SizeSquared() < KINDA_SMALL_NUMBER)
+bool UFPVMovementComponent::AdmitInputFrame(float StepSeconds)
+{
+	// One frame per step of real time, with a little slack for packets that arrive bunched up
+	const double Rate = 1.0 / StepSeconds;
+	const double Capacity = FMath::Max(1.0, CVarNetInputFrameSlack.GetValueOnGameThread() * Rate);
+	if (InputFrameBudget.TryConsume(GetWorld()->GetRealTimeSeconds(), Rate, Capacity))
 	{
-		LastAngularVelocity = FVector::ZeroVector;
+		return true;
 	}
 
-	// --- Quaternion rotation integration ---
-	// Convert angular velocity (deg/sec) → quaternion delta
-	FVector AngularVelocityRad = FMath::DegreesToRadians(LastAngularVelocity) * DeltaTime;
+	++NumRejectedFrames;
+	INC_DWORD_STAT(STAT_FlightInputFramesRejected);
+	return false;
+}
+
+void UFPVMovementComponent::EnforcePlausibleMotion(const FVector& PreviousVelocity, float StepSeconds, float MaxSpeed, float MaxAcceleration)
+{
+	// Judge the integration alone: the ground stopping the aircraft is a legitimate velocity change
+	const FVector DeltaVelocity = IntegratedVelocity - PreviousVelocity;
+	const double MaxDeltaVelocity = MaxAcceleration * StepSeconds;
 
-	// Axis-angle: rotation around angular velocity vector
-	float Angle = AngularVelocityRad.Size();
-	if (Angle > KINDA_SMALL_NUMBER)
+	FVector Velocity = IntegratedVelocity;
+	if (DeltaVelocity.SizeSquared() > FMath::Square(MaxDeltaVelocity))
 	{
-		FVector Axis = AngularVelocityRad / Angle; // normalize
-		FQuat DeltaQuat(Axis, Angle);
+		Velocity = PreviousVelocity + DeltaVelocity.GetClampedToMaxSize(MaxDeltaVelocity);
+	}
+	Velocity = Velocity.GetClampedToMaxSize(MaxSpeed);
 
-		// Apply delta quaternion to current rotation
-		FQuat CurrentQuat = PawnOwner->GetActorQuat();
-		FQuat NewQuat = DeltaQuat * CurrentQuat;
-		NewQuat.Normalize();
+	if (Velocity != IntegratedVelocity)
+	{
+		++NumImplausibleSteps;
+		INC_DWORD_STAT(STAT_FlightImplausibleSteps);
+
+		// Redo the position part of the step with the clamped velocity, then the ground contact on top of it
+		Body.Location = IntegratedLocation + (Velocity - IntegratedVelocity) * StepSeconds;
+		Body.LinearVelocity = Velocity;
+		bGroundContact = Terrain && Terrain->ResolveGroundContact(Body);
+		bClamped = true;
+		bMovePending = true;
+		ServerState.Location = Body.Location;
+		ServerState.LinearVelocity = Body.LinearVelocity;
+		RecordState(EFlightRecordType::Clamped);
+	}
+}
 
-		SimulatedRotation = NewQuat.Rotator();
-		PawnOwner->SetActorRotation(NewQuat);
+FFlightBodyState UFPVMovementComponent::GetIntegratedBodyState() const
+{
+	// Ground contact and clamps only ever touch location and velocity
+	FFlightBodyState Integrated = Body;
+	Integrated.Location = IntegratedLocation;
+	Integrated.LinearVelocity = IntegratedVelocity;
+	return Integrated;
+}
+
+void UFPVMovementComponent::RecordState(EFlightRecordType Type, const FVector& Error)
+{
+	if (!Recorder) return;
+
+	FFlightRecord Record;
+	Record.Time = GetWorld()->GetTimeSeconds();
+	Record.Type = Type;
+	Record.Sequence = ServerState.LastProcessedInput;
+	if (Type == EFlightRecordType::Clamped)
+	{
+		Record.SetBody(Body);
 	}
 	else
 	{
-		// No angular movement
-		SimulatedRotation = PawnOwner->GetActorRotation();
+		Record.Location = ServerState.Location;
+		Record.Rotation = FQuat4f(ServerState.Rotation.Quaternion());
+		Record.LinearVelocity = FVector3f(ServerState.LinearVelocity);
+		Record.AngularVelocity = FVector3f(ServerState.AngularVelocity);
+	}
+	Record.Error = FVector3f(Error);
+	Recorder->Write(Record);
+}
+
+void UFPVMovementComponent::ReconcileWithServer()
+{
+	AAAircraftBase* Aircraft = Cast<AAAircraftBase>(PawnOwner);
+	const uint32 Ack = ServerState.LastProcessedInput;
+	if (!Aircraft || PredictionHistory.IsEmpty() || Ack == 0) return;
+
+	const FPredictedMove& Acked = PredictionHistory[Ack % PredictionHistory.Num()];
+	const bool bHaveAcked = Acked.Input.Sequence == Ack;
+	if (bHaveAcked
+		&& Acked.Body.Location.Equals(ServerState.Location, ReconcileTolerance)
+		&& Acked.Body.LinearVelocity.Equals(ServerState.LinearVelocity, ReconcileTolerance))
+	{
+		return; // prediction held
+	}
+
+	// Rewind to the authoritative state and replay every input the server has not simulated yet.
+	// If the acked move already fell out of the history the replay simply starts from what is left.
+	++NumCorrections;
+	INC_DWORD_STAT(STAT_FlightCorrections);
+	CSV_CUSTOM_STAT(FlightNet, Corrections, 1, ECsvCustomStatOp::Accumulate);
+	RecordState(EFlightRecordType::Correction, bHaveAcked ? Acked.Body.Location - ServerState.Location : FVector::ZeroVector);
+	// The server does not replicate its control smoothing, ours after the acked move is the closest match
+	ResetToState(ServerState, bHaveAcked ? Acked.Body.ControlAngularVelocity : Body.ControlAngularVelocity);
+
+	const FFlightInputFrame LiveInput = Aircraft->MakeInputFrame(0);
+	const float StepSeconds = GetNetStepSeconds();
+
+	bReplayingMoves = true;
+	for (uint32 Sequence = Ack + 1; Sequence < NextInputSequence; ++Sequence)
+	{
+		const FPredictedMove& Move = PredictionHistory[Sequence % PredictionHistory.Num()];
+		if (Move.Input.Sequence != Sequence) continue;
+
+		Aircraft->ApplyInputFrame(Move.Input);
+		Aircraft->SimulateFlightStep(StepSeconds);
+		RecordPredictedMove(Move.Input);
 	}
+	bReplayingMoves = false;
 
+	Aircraft->ApplyInputFrame(LiveInput);
+	CommitMove();
+}
+
+void UFPVMovementComponent::ResetToState(const FServerState& State, const FVector& InControlAngularVelocity)
+{
+	Body.Location = State.Location;
+	Body.Rotation = State.Rotation.Quaternion();
+	Body.LinearVelocity = State.LinearVelocity;
+	Body.AngularVelocity = State.AngularVelocity;
+	Body.ControlAngularVelocity = InControlAngularVelocity;
+	bMovePending = true;
+	bMoveIsCorrection = true;
+}
+
+// ONLY PAWN OWNER & SERVER DO THE PHYSICS CALCULATION
+void UFPVMovementComponent::ApplyPhysicsStep(float DeltaTime, const FVector& InLinearAccel, const FVector& InAngularVel)
+{
+	FLIGHT_SCOPE(Flight, ApplyPhysicsStep);
+	FLIGHT_COUNT(Flight, Steps, 1);
+	if (!PawnOwner) return;
 	
+	// Integrate locally
+	FFlightDynamics::Integrate(UFlightSimSubsystem::GetIntegrator(), DeltaTime, InLinearAccel, InAngularVel, Body);
+	IntegratedLocation = Body.Location;
+	IntegratedVelocity = Body.LinearVelocity;
+	bGroundContact = Terrain && Terrain->ResolveGroundContact(Body);
+	bClamped = false;
 
-	PawnOwner->SetActorLocation(SimulatedLocation);
-	PawnOwner->SetActorRotation(SimulatedRotation);
+	bMovePending = true;
 
-	LastAngularVelocity = LastAngularVelocity;
-	LastLinearVelocity = LastLinearVelocity;
 	// If server, replicate authoritative state
 	if (PawnOwner->HasAuthority())
 	{
-		ServerState.Location = SimulatedLocation;
-		ServerState.Rotation = SimulatedRotation;
-		ServerState.LinearVelocity = LastLinearVelocity;
-		ServerState.AngularVelocity = LastAngularVelocity;
+		ServerState.Location = Body.Location;
+		ServerState.Rotation = Body.Rotation.Rotator();
+		ServerState.LinearVelocity = Body.LinearVelocity;
+		ServerState.AngularVelocity = Body.AngularVelocity;
+		ServerState.ServerTime = GetWorld()->GetTimeSeconds();
 	}
+}
 
-	// --- Debug logging once per second ---
-	static float TimeAccumulator = 0.f;
-	TimeAccumulator += DeltaTime;
+void UFPVMovementComponent::CommitMove()
+{
+	if (!bMovePending || !PawnOwner) return;
+	bMovePending = false;
+	// The server already resolved its own collisions, sweeping from the mispredicted pawn would fight it
+	const bool bCorrection = bMoveIsCorrection;
+	bMoveIsCorrection = false;
+
+	FLIGHT_SCOPE(Flight, CommitMove);
+	if (!bCorrection && CVarFlightSweepMoves.GetValueOnGameThread())
+	{
+		SweepBody();
+	}
+	PawnOwner->SetActorLocationAndRotation(Body.Location, Body.Rotation);
+	SyncSpatialEntry();
+}
 
-	if (TimeAccumulator >= 10.0f)
+void UFPVMovementComponent::SweepBody()
+{
+	const FVector Delta = Body.Location - PawnOwner->GetActorLocation();
+	if (!SweepComponent || Delta.IsNearlyZero()) return;
+
+	TArray<FHitResult> Hits;
+	FComponentQueryParams Params(SCENE_QUERY_STAT(FlightSweepMove), PawnOwner);
+	FVector Start = SweepComponent->GetComponentLocation();
+	FVector Origin = PawnOwner->GetActorLocation();
+	auto SweepBlock = [&]() -> const FHitResult*
 	{
-		UE_LOG(LogTemp, Log, TEXT("[FPVMovement] LinearVel: %s | AngularVel: %s"),
-			*LastLinearVelocity.ToString(),
-			*InAngularVel.ToString());
+		GetWorld()->ComponentSweepMulti(Hits, SweepComponent, Start, Start + Delta, Body.Rotation, Params);
+		// Overlaps come first, the blocking hit (if any) is the nearest one
+		return Hits.FindByPredicate([](const FHitResult& Hit) { return Hit.bBlockingHit; });
+	};
 
-		TimeAccumulator = 0.f;
+	auto StopAt = [this](const FVector& Location, const FVector& Normal)
+	{
+		Body.Location = Location;
+		if ((Body.LinearVelocity | Normal) < 0.0)
+		{
+			Body.LinearVelocity = FVector::VectorPlaneProject(Body.LinearVelocity, Normal);
+		}
+	};
+
+	const FHitResult* Block = SweepBlock();
+	if (!Block) return;
+
+	if (Block->bStartPenetrating)
+	{
+		// A start inside geometry reports Time 0, stopping there would pin the aircraft in it for good.
+		// Push the whole move out by the penetration depth and sweep again, staying there if still stuck
+		const FVector Adjustment = Block->Normal * (Block->PenetrationDepth + 0.125);
+		Start += Adjustment;
+		Origin += Adjustment;
+		StopAt(Origin + Delta, Block->Normal);
+		Block = SweepBlock();
+	}
+	if (Block)
+	{
+		StopAt(Origin + Delta * Block->Time, Block->ImpactNormal);
 	}
 
+	if (PawnOwner->HasAuthority())
+	{
+		ServerState.Location = Body.Location;
+		ServerState.LinearVelocity = Body.LinearVelocity;
+	}
 }
 
+void UFPVMovementComponent::ApplySimulatedState(const FFlightBodyState& InBody, const FVector& RenderLocation, const FQuat& RenderRotation)
+{
+	if (!PawnOwner) return;
+
+	Body = InBody;
+	bMovePending = false;
 
+	{
+		FLIGHT_SCOPE(Flight, CommitMove);
+		PawnOwner->SetActorLocationAndRotation(RenderLocation, RenderRotation);
+		SyncSpatialEntry();
+	}
+
+	if (PawnOwner->HasAuthority())
+	{
+		ServerState.Location = Body.Location;
+		ServerState.Rotation = Body.Rotation.Rotator();
+		ServerState.LinearVelocity = Body.LinearVelocity;
+		ServerState.AngularVelocity = Body.AngularVelocity;
+		ServerState.ServerTime = GetWorld()->GetTimeSeconds();
+	}
+}
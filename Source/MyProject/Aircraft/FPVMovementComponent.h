@@ -4,8 +4,25 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PawnMovementComponent.h"
+#include "FlightDynamics.h"
 #include "FPVMovementComponent.generated.h"
 
+class UAircraftSpatialSubsystem;
+class UTerrainHeightfieldSubsystem;
+class FFlightRecorder;
+enum class EFlightRecordType : uint8;
+
+/** FServerState fields as they went over the wire, quantized */
+struct FServerStateWireFields
+{
+	FIntVector Location = FIntVector::ZeroValue;
+	// Smallest-three quaternion: largest component index, then the other three components
+	uint64 Rotation = 0;
+	FIntVector LinearVelocity = FIntVector::ZeroValue;
+	FIntVector AngularVelocity = FIntVector::ZeroValue;
+	bool bValid = false;
+};
+
 USTRUCT()
 struct FServerState
 {
@@ -22,6 +39,131 @@ struct FServerState
 
 	UPROPERTY()
 	FVector AngularVelocity;
+
+	/** Sequence of the last owning-client input frame simulated into this state */
+	UPROPERTY()
+	uint32 LastProcessedInput = 0;
+
+	/** Server world time this state was simulated at, orders snapshots on simulated proxies */
+	UPROPERTY()
+	double ServerTime = 0.0;
+
+	/**
+	 * Quantized wire format: position on a fixed grid (ac.Net.PositionQuantum), rotation as a smallest-three
+	 * quaternion, velocities quantized. A field whose quantized value is unchanged since the last state is left
+	 * out, except in the full state sent every ac.Net.StateFullInterval states.
+	 */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	// Writer: WireBaseline is the state before the last distinct one written, so writing the same state again
+	// (for another connection, or a resend) encodes the same and holds for a reader that has either of them.
+	// Reader: the last state read
+	FServerStateWireFields WireBaseline;
+	FServerStateWireFields WireLast;
+	uint32 NumWireStates = 0;
+};
+
+template<>
+struct TStructOpsTypeTraits<FServerState> : public TStructOpsTypeTraitsBase2<FServerState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** One fixed step worth of pilot input, numbered so the server can acknowledge it */
+USTRUCT()
+struct FFlightInputFrame
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint32 Sequence = 0;
+
+	// Inputs are quantized to a byte each when the frame is sampled, so the owning client predicts
+	// with exactly the values the server will replay
+	UPROPERTY()
+	uint8 Thrust = 0;
+
+	UPROPERTY()
+	int8 SteeringX = 0;
+
+	UPROPERTY()
+	int8 SteeringY = 0;
+
+	UPROPERTY()
+	int8 Yaw = 0;
+
+	static FFlightInputFrame Make(uint32 InSequence, float InThrust, const FVector2D& InSteering, float InYaw);
+
+	float GetThrust() const { return Thrust / 255.f; }
+	FVector2D GetSteering() const { return FVector2D(SteeringX / 127.f, SteeringY / 127.f); }
+	float GetYaw() const { return Yaw / 127.f; }
+	// Decoded inputs kept inside their valid range (int8 reaches -128)
+	FFlightControls GetControls() const;
+
+	bool HasSameInput(const FFlightInputFrame& Other) const
+	{
+		return Thrust == Other.Thrust && SteeringX == Other.SteeringX && SteeringY == Other.SteeringY && Yaw == Other.Yaw;
+	}
+};
+
+/**
+ * Uplink packet: a window of consecutive input frames, resent redundantly so a lost packet is covered by the
+ * next one. Runs of identical input are sent once with a repeat count, so holding a stick costs a few bytes.
+ */
+USTRUCT()
+struct FFlightInputPacket
+{
+	GENERATED_BODY()
+
+	/** Consecutive sequences, oldest first */
+	TArray<FFlightInputFrame> Frames;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FFlightInputPacket> : public TStructOpsTypeTraitsBase2<FFlightInputPacket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** Refilling allowance used to rate-limit what a client can make the server do */
+struct FFlightTokenBucket
+{
+	double Tokens = 0.0;
+	double LastRefillTime = -1.0;
+
+	bool TryConsume(double Now, double RatePerSecond, double Capacity)
+	{
+		Tokens = LastRefillTime < 0.0 ? Capacity : FMath::Min(Capacity, Tokens + (Now - LastRefillTime) * RatePerSecond);
+		LastRefillTime = Now;
+		if (Tokens < 1.0) return false;
+		Tokens -= 1.0;
+		return true;
+	}
+};
+
+/** Timestamped ServerState kept by simulated proxies for interpolation */
+struct FFlightSnapshot
+{
+	double Time = 0.0;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector LinearVelocity = FVector::ZeroVector;
+};
+
+/** Owning client's record of an input frame and the state it predicted */
+struct FPredictedMove
+{
+	FFlightInputFrame Input;
+	// Full state after the move, control smoothing included, so a rewind restores everything the next step reads
+	FFlightBodyState Body;
 };
 
 UCLASS()
@@ -30,32 +172,143 @@ class MYPROJECT_API UFPVMovementComponent : public UPawnMovementComponent
 	GENERATED_BODY()
 	UFPVMovementComponent();
 public:
-	void ApplyPhysicsStep(float DeltaTime, const FVector& InLinearVel, const FVector& InAngularVel);
+	// Integrates one step into the body state, the pawn only follows at the next CommitMove
+	void ApplyPhysicsStep(float DeltaTime, const FVector& InLinearAccel, const FVector& InAngularVel);
+	// Moves the pawn to the body state in one transform update (swept with ac.Flight.SweepMoves), so all the
+	// steps of a frame cost a single move. No-op when nothing moved since the last commit
+	void CommitMove();
+	// Current simulated state of the pawn in FFlightDynamics form
+	const FFlightBodyState& GetBodyState() const { return Body; }
+	void SetControlAngularVelocity(const FVector& InControlAngularVelocity) { Body.ControlAngularVelocity = InControlAngularVelocity; }
+	// Writes a state integrated elsewhere (UFlightSimSubsystem) back onto the pawn.
+	// The pawn is placed at the render transform, ServerState gets the simulated one.
+	void ApplySimulatedState(const FFlightBodyState& InBody, const FVector& RenderLocation, const FQuat& RenderRotation);
+
+	// Step length used for predicted/replayed moves, server and owning client must agree on it
+	static float GetNetStepSeconds();
+	void SetFieldEpoch(double InFieldEpoch) { FieldEpoch = InFieldEpoch; }
+	// Airflow field time input frame Sequence is simulated at
+	double GetFrameFieldTime(uint32 Sequence) const { return FieldEpoch + Sequence * double(GetNetStepSeconds()); }
+	// Server time simulated proxies are drawn at on this machine, i.e. what a client was looking at when it fired
+	static double GetProxyRenderTime(const UWorld* World);
+	// Server side: aircraft of remote players only move when their input frames arrive
+	bool IsDrivenByRemoteInputs() const;
+
+	// CLIENT PREDICTION
+	uint32 ConsumeInputSequence() { return NextInputSequence++; }
+	void RecordPredictedMove(const FFlightInputFrame& Input);
+	// Owning client: true when an input packet is due, filled with the unsent frames plus a redundant tail
+	bool BuildInputPacket(float DeltaTime, FFlightInputPacket& OutPacket);
+	void AcknowledgeInput(uint32 Sequence) { ServerState.LastProcessedInput = Sequence; }
+	uint32 GetLastProcessedInput() const { return ServerState.LastProcessedInput; }
+	int32 GetNumCorrections() const { return NumCorrections; }
+	// True while ReconcileWithServer re-simulates the moves the server has not acknowledged yet
+	bool IsReplayingMoves() const { return bReplayingMoves; }
+
+	// Black box of this aircraft, null while ac.Recorder.Enable is off. Shared so a dump can outlive the pawn
+	const TSharedPtr<FFlightRecorder, ESPMode::ThreadSafe>& GetRecorder() const { return Recorder; }
+
+	// SERVER VALIDATION (one owning connection per aircraft, so these budgets are per connection)
+	// Cheap gate at the top of the input RPC: false drops the whole packet
+	bool AdmitInputPacket();
+	// False once the client tries to run its aircraft faster than real time
+	bool AdmitInputFrame(float StepSeconds);
+	// Clamps the last step's integration to what the airframe can physically do, then redoes its ground contact
+	void EnforcePlausibleMotion(const FVector& PreviousVelocity, float StepSeconds, float MaxSpeed, float MaxAcceleration);
+
+	// Body exactly as the flight model integrated the last step, before ground contact and clamps moved it
+	FFlightBodyState GetIntegratedBodyState() const;
+	// What changed the body after the last step's integration
+	bool HadGroundContact() const { return bGroundContact; }
+	bool WasClamped() const { return bClamped; }
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual auto GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const -> void override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 	UPROPERTY(ReplicatedUsing=OnRep_ServerState)
 	FServerState ServerState;
 
+	// Airflow field time of input frame 0, set by the server when the aircraft spawns. Frame N is simulated at
+	// FieldEpoch + N * GetNetStepSeconds() by the predicting client, the server and replays alike
+	UPROPERTY(Replicated)
+	double FieldEpoch = 0.0;
+
 	UFUNCTION()
 	void OnRep_ServerState();
 
-	UFUNCTION(Server, Reliable)
-	void Server_SyncTrasnform(FVector OwningClientLocation, FRotator OwningClienRotation, float DeltaTime);
+	// Simulated proxies: buffer ServerState and render it a fixed delay in the past
+	void PushSnapshot(const FServerState& State);
+	bool SampleSnapshots(double RenderTime, FVector& OutLocation, FQuat& OutRotation);
 
-public:
-	FVector LastLinearVelocity;
-	FVector LastAngularVelocity;
+	// Owning client: compare the acked prediction with the server and replay unacked inputs on mismatch
+	void ReconcileWithServer();
+	void ResetToState(const FServerState& State, const FVector& InControlAngularVelocity);
+
+	// Keeps the aircraft's proximity-query entry at the pawn's current location, called after every move
+	void SyncSpatialEntry();
+	// Stops the pending move at the first blocking hit of SweepComponent and drops the velocity into the surface.
+	// A move starting inside geometry is first pushed out along the hit normal by the penetration depth
+	void SweepBody();
+
+	// Writes ServerState (or the body, for clamps) to the recorder as a non-step record
+	void RecordState(EFlightRecordType Type, const FVector& Error = FVector::ZeroVector);
 
-	
 private:
-	FVector SimulatedLocation;
-	FRotator SimulatedRotation;
+	// Everything the flight model carries from one step to the next. Owned per aircraft, nothing lives in statics
+	FFlightBodyState Body;
+	// Body after the last integration, before ground contact pushed it back out of the terrain
+	FVector IntegratedLocation = FVector::ZeroVector;
+	FVector IntegratedVelocity = FVector::ZeroVector;
+	bool bGroundContact = false;
+	bool bClamped = false;
+	// Body moved since the pawn was last placed
+	bool bMovePending = false;
+	// The pending move comes from a reset to the server's state, so the pawn is placed there unswept
+	bool bMoveIsCorrection = false;
+	// The root is a bare scene component, so sweeps use the collision of the aircraft's first primitive
+	UPROPERTY()
+	TObjectPtr<UPrimitiveComponent> SweepComponent;
 
 
 	UPROPERTY(EditAnywhere)
 	float TeleportThreshold = 1000.f;
+
+	// Location error (cm) tolerated between the acked prediction and ServerState before replaying
+	UPROPERTY(EditAnywhere, Category="Prediction")
+	float ReconcileTolerance = 10.f;
+	// Predicted moves kept for replay, indexed by Sequence % size
+	UPROPERTY(EditAnywhere, Category="Prediction")
+	int32 PredictionHistorySize = 128;
+
+	// Ring of snapshots, oldest at SnapshotStart
+	TArray<FFlightSnapshot> Snapshots;
+	int32 SnapshotStart = 0;
+	int32 NumSnapshots = 0;
+
+	FFlightTokenBucket InputRpcBudget;
+	FFlightTokenBucket InputFrameBudget;
+	int32 NumThrottledRpcs = 0;
+	int32 NumRejectedFrames = 0;
+	int32 NumImplausibleSteps = 0;
+
+	UPROPERTY()
+	TObjectPtr<UAircraftSpatialSubsystem> Spatial;
+	int32 SpatialHandle = INDEX_NONE;
+	UPROPERTY()
+	TObjectPtr<UTerrainHeightfieldSubsystem> Terrain;
+
+	TArray<FPredictedMove> PredictionHistory;
+	uint32 NextInputSequence = 1;
+	FFlightInputFrame LastSentInput;
+	float TimeSinceInputSend = 0.f;
+	int32 NumCorrections = 0;
+	bool bReplayingMoves = false;
+	// ServerTime of the last state whose wire size went into the FlightNet stats
+	double LastMeasuredStateTime = -1.0;
+
+	TSharedPtr<FFlightRecorder, ESPMode::ThreadSafe> Recorder;
 };
@@ -0,0 +1,263 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightDynamics.h"
+#include "FlightForceKernel.h"
+#include "MyProject/GCore/Config/AirframeAsset.h"
+
+FFlightModel::FFlightModel(EFlightType InFlightType, const FAircraftConfig& InAircraft, const FDroneConfig& InDrone)
+	: FlightType(InFlightType)
+	, Aircraft(InAircraft)
+	, Drone(InDrone)
+{
+	if (InFlightType == EFlightType::Aircraft && InAircraft.AeroTable && InAircraft.AeroTable->GetTable().IsValid())
+	{
+		AeroTable = &InAircraft.AeroTable->GetTable();
+	}
+}
+
+FFlightModel::FFlightModel(const UAirframeAsset& Airframe)
+	: FFlightModel(Airframe.FlightType, Airframe.Aircraft, Airframe.Drone)
+{
+}
+
+FAeroCoefficients FFlightDynamics::SampleAero(const FFlightModel& Model, const FFlightBodyState& State)
+{
+	const FVector& Vel = State.LinearVelocity;
+	const double Speed = Vel.Size();
+	if (Speed < UE_KINDA_SMALL_NUMBER) return Model.AeroTable->Sample(1.f, false, 0.f, 0.f);
+
+	const FVector VelDir = Vel / Speed;
+	return Model.AeroTable->Sample(
+		FVector::DotProduct(State.Rotation.GetForwardVector(), VelDir),
+		FVector::DotProduct(Vel, State.Rotation.GetUpVector()) > 0.0, // Air from above: nose below the flight path
+		FVector::DotProduct(VelDir, State.Rotation.GetRightVector()),
+		Speed / FAeroTable::SpeedOfSound);
+}
+
+FVector FFlightDynamics::CalculateSideForce(const FFlightBodyState& State, float SideCoefficient)
+{
+	const FVector& Vel = State.LinearVelocity;
+	const FVector VelDir = Vel.GetSafeNormal();
+	const FVector Right = State.Rotation.GetRightVector();
+	const FVector SideDir = (Right - FVector::DotProduct(Right, VelDir) * VelDir).GetSafeNormal();
+	return 0.5f * Vel.SizeSquared() * SideCoefficient * SideDir;
+}
+
+FVector FFlightDynamics::GetEnvironmentForce(const FFlightBodyState& State, const FFlightEnvironment& Environment)
+{
+	return Environment.Wind + Environment.Updraft * State.Rotation.GetUpVector() + Environment.Turbulence;
+}
+
+FVector FFlightDynamics::CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+	const FFlightEnvironment& Environment, bool& bOutStalled)
+{
+	return DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+	{
+		return CalculateLinearAcceleration<decltype(Policy)>(Model, State, Controls, Environment, bOutStalled);
+	});
+}
+
+FFlightForces FFlightDynamics::CalculateForces(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+	const FFlightEnvironment& Environment, bool& bOutStalled)
+{
+	return DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+	{
+		using TPolicy = decltype(Policy);
+		FFlightForces Forces = TPolicy::CalculateForces(Model, State, Controls, GetEnvironmentForce(State, Environment), bOutStalled);
+		Forces.StallTorque = TPolicy::CalculateStallTorque(Model, bOutStalled, State);
+		return Forces;
+	});
+}
+
+FVector FFlightDynamics::UpdateControlAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled, float DeltaTime,
+	FFlightBodyState& State)
+{
+	return DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+	{
+		return UpdateControlAngularVelocity<decltype(Policy)>(Model, Controls, bStalled, DeltaTime, State);
+	});
+}
+
+FVector FFlightDynamics::UpdateControlAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled, float DeltaTime,
+	FFlightBodyState& State, FVector& OutStallTorque)
+{
+	return DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+	{
+		return UpdateControlAngularVelocity<decltype(Policy)>(Model, Controls, bStalled, DeltaTime, State, OutStallTorque);
+	});
+}
+
+FVector FFlightDynamics::SmoothControlAngularVelocity(const FVector& Desired, float DampingFactor, float DeltaTime, FFlightBodyState& State)
+{
+	FVector& Smoothed = State.ControlAngularVelocity;
+	Smoothed = FMath::VInterpTo(Smoothed, Desired, DeltaTime, DampingFactor);
+
+	// Snap very small rotation to zero
+	if (Smoothed.SizeSquared() < KINDA_SMALL_NUMBER)
+	{
+		Smoothed = FVector::ZeroVector;
+	}
+
+	return Smoothed;
+}
+
+FFlightForces FAircraftFlightPolicy::CalculateForces(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+	const FVector& EnvironmentForce, bool& bOutStalled)
+{
+	const FAircraftConfig& Cfg = Model.Aircraft;
+	const FVector Forward = State.Rotation.GetForwardVector();
+	const FVector Up      = State.Rotation.GetUpVector();
+	const FVector& Vel    = State.LinearVelocity;
+	const FVector VelDir  = Vel.GetSafeNormal();
+	FFlightForces Forces;
+
+	// --- Gravity ---
+	Forces.Gravity = FVector(0, 0, -980.f * Cfg.GravityScale) * Cfg.Mass;
+
+	// --- Coefficients ---
+	float LiftCoefficient = Cfg.LiftCoefficient;
+	float DragCoefficient = Cfg.DragCoefficient;
+	float StallCos = FFlightForceBatch::MakeStallCos(Cfg.StallAngleDegrees);
+	if (Model.AeroTable)
+	{
+		const FAeroCoefficients Aero = FFlightDynamics::SampleAero(Model, State);
+		LiftCoefficient = Aero.Lift;
+		DragCoefficient = Aero.Drag;
+		Forces.Side = FFlightDynamics::CalculateSideForce(State, Aero.Side);
+		StallCos = Model.AeroTable->StallCos;
+	}
+
+	// --- Angle of Attack: compared through its cosine ---
+	bOutStalled = VelDir.IsNearlyZero() ? StallCos > 1.f : FVector::DotProduct(Forward, VelDir) <= StallCos;
+
+	// --- Lift ---
+	const FVector LiftDir = (Up - FVector::DotProduct(Up, VelDir) * VelDir).GetSafeNormal();
+	Forces.Lift = 0.5f * Vel.SizeSquared() * LiftCoefficient * LiftDir;
+
+	// --- Drag ---
+	Forces.Drag = -0.5f * Vel.SizeSquared() * DragCoefficient * VelDir;
+
+	// --- Thrust ---
+	Forces.Thrust = Forward * (Controls.Thrust * Cfg.ThrustPower);
+
+	Forces.Environment = EnvironmentForce;
+	return Forces;
+}
+
+FVector FAircraftFlightPolicy::CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+	const FVector& EnvironmentForce, bool& bOutStalled)
+{
+	return CalculateForces(Model, State, Controls, EnvironmentForce, bOutStalled).GetTotal() / FMath::Max(Model.Aircraft.Mass, 1.f);
+}
+
+FVector FAircraftFlightPolicy::CalculateStallTorque(const FFlightModel& Model, bool bStalled, const FFlightBodyState& State)
+{
+	// --- Pitching moment from the table, scaled by dynamic pressure ---
+	if (Model.AeroTable)
+	{
+		const FAeroTable& Table = *Model.AeroTable;
+		const float Moment = FFlightDynamics::SampleAero(Model, State).Moment;
+		const float Pressure = State.LinearVelocity.SizeSquared() / FMath::Square(Table.ReferenceSpeed);
+		const FVector PitchAxis = FVector::CrossProduct(State.Rotation.GetForwardVector(), State.Rotation.GetUpVector());
+		return PitchAxis * (Moment * Table.PitchMomentRate * Pressure);
+	}
+
+	// --- Stall correction torque: swing the nose back onto the velocity ---
+	if (bStalled)
+	{
+		const FAircraftConfig& Cfg = Model.Aircraft;
+		const FQuat TargetQuat = State.LinearVelocity.GetSafeNormal().ToOrientationQuat();
+		const FQuat DeltaQuat  = TargetQuat * State.Rotation.Inverse();
+
+		FVector Axis; float Angle;
+		DeltaQuat.ToAxisAndAngle(Axis, Angle);
+		return Axis * Angle * (Cfg.StabilityTorque / Cfg.Mass);
+	}
+
+	return FVector::ZeroVector;
+}
+
+FVector FAircraftFlightPolicy::CalculateDesiredAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled,
+	const FFlightBodyState& State, FVector& OutStallTorque)
+{
+	const FAircraftConfig& Cfg = Model.Aircraft;
+	FVector DesiredAngularVelocity = FVector::ZeroVector;
+	if (!FMath::IsNearlyZero(Controls.Steering.Y)) DesiredAngularVelocity.X = Controls.Steering.Y * Cfg.PitchRate; // Pitch
+	if (!FMath::IsNearlyZero(Controls.Steering.X)) DesiredAngularVelocity.Y = Controls.Steering.X * Cfg.RollRate;  // Roll
+	if (!FMath::IsNearlyZero(Controls.Yaw))        DesiredAngularVelocity.Z = Controls.Yaw * Cfg.YawRate;          // Yaw
+
+	OutStallTorque = CalculateStallTorque(Model, bStalled, State);
+	DesiredAngularVelocity += OutStallTorque;
+
+	return DesiredAngularVelocity;
+}
+
+FFlightForces FDroneFlightPolicy::CalculateForces(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+	const FVector& EnvironmentForce, bool& bOutStalled)
+{
+	const FDroneConfig& Cfg = Model.Drone;
+	bOutStalled = false;
+
+	FFlightForces Forces;
+	// --- Thrust ---
+	Forces.Thrust = State.Rotation.GetForwardVector() * (Controls.Thrust * Cfg.Acceleration);
+
+	// --- Drag / natural slowdown ---
+	Forces.Drag = -State.LinearVelocity * Cfg.DragCoefficient;
+
+	Forces.Environment = EnvironmentForce;
+	return Forces;
+}
+
+FVector FDroneFlightPolicy::CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+	const FVector& EnvironmentForce, bool& bOutStalled)
+{
+	return CalculateForces(Model, State, Controls, EnvironmentForce, bOutStalled).GetTotal() / FMath::Max(Model.Drone.Mass, 1.f);
+}
+
+FVector FDroneFlightPolicy::CalculateDesiredAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled,
+	const FFlightBodyState& State, FVector& OutStallTorque)
+{
+	const FDroneConfig& Cfg = Model.Drone;
+	OutStallTorque = FVector::ZeroVector;
+	FVector DesiredAngularVelocity = FVector::ZeroVector;
+	if (!FMath::IsNearlyZero(Controls.Steering.Y)) DesiredAngularVelocity.X = Controls.Steering.Y * Cfg.MaxPitchAngle; // Pitch
+	if (!FMath::IsNearlyZero(Controls.Steering.X)) DesiredAngularVelocity.Y = Controls.Steering.X * Cfg.MaxRollAngle;  // Roll
+	if (!FMath::IsNearlyZero(Controls.Yaw))        DesiredAngularVelocity.Z = Controls.Yaw * Cfg.YawRate;              // Yaw
+	return DesiredAngularVelocity;
+}
+
+void FFlightDynamics::Integrate(EFlightIntegrator Integrator, float DeltaTime, const FVector& LinearAccel, const FVector& TargetAngularVelocity,
+	FFlightBodyState& State)
+{
+	// --- Integrate acceleration into velocity, velocity into position ---
+	FFlightIntegrator::IntegrateLinear(Integrator, DeltaTime, LinearAccel, State.LinearVelocity, State.Location);
+
+	// --- Smooth angular velocity (damped) ---
+	State.AngularVelocity = FMath::VInterpTo(State.AngularVelocity, TargetAngularVelocity, DeltaTime, 10.f);
+	if (State.AngularVelocity.SizeSquared() < KINDA_SMALL_NUMBER)
+	{
+		State.AngularVelocity = FVector::ZeroVector;
+	}
+
+	// --- Quaternion rotation integration ---
+	// Convert angular velocity (deg/sec) → quaternion delta around the world-space axis
+	const FVector AngularVelocityRad = FMath::DegreesToRadians(State.AngularVelocity) * DeltaTime;
+	const float Angle = AngularVelocityRad.Size();
+	if (Angle > KINDA_SMALL_NUMBER)
+	{
+		FQuat NewQuat = FQuat(AngularVelocityRad / Angle, Angle) * State.Rotation;
+		NewQuat.Normalize();
+		State.Rotation = NewQuat;
+	}
+}
+
+void FFlightDynamics::Step(const FFlightModel& Model, const FFlightControls& Controls, const FFlightEnvironment& Environment,
+	EFlightIntegrator Integrator, float DeltaTime, FFlightBodyState& State)
+{
+	DispatchFlightPolicy(Model.FlightType, [&](auto Policy)
+	{
+		Step<decltype(Policy)>(Model, Controls, Environment, Integrator, DeltaTime, State);
+	});
+}
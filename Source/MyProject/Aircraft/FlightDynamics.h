@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FlightStep.h"
+#include "MyProject/GCore/Config/EnvConfigs.h"
+#include "MyProject/GCore/Config/FlightConfigs.h"
+#include "MyProject/GCore/Config/AeroTableAsset.h"
+
+class UAirframeAsset;
+
+/** Everything the flight model integrates for one body. Plain data, safe to copy and to step on any thread */
+struct FFlightBodyState
+{
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector LinearVelocity = FVector::ZeroVector;
+	/** World angular velocity (deg/s) the body turns at */
+	FVector AngularVelocity = FVector::ZeroVector;
+	/** Smoothed angular velocity the controls ask for, AngularVelocity is damped towards it */
+	FVector ControlAngularVelocity = FVector::ZeroVector;
+
+	/** Full precision, for rollback snapshots and replays */
+	friend FArchive& operator<<(FArchive& Ar, FFlightBodyState& State)
+	{
+		return Ar << State.Location << State.Rotation << State.LinearVelocity << State.AngularVelocity << State.ControlAngularVelocity;
+	}
+};
+
+struct FFlightControls
+{
+	float Thrust = 0.f;
+	FVector2D Steering = FVector2D::ZeroVector;
+	float Yaw = 0.f;
+};
+
+/** Environment forces acting on a body for one step */
+struct FFlightEnvironment
+{
+	FVector Wind = FVector::ZeroVector;
+	/** Applied along the body up vector */
+	float Updraft = 0.f;
+	FVector Turbulence = FVector::ZeroVector;
+
+	static FFlightEnvironment Make(const FEnvAirflow& Airflow, const FVector& TurbulenceSample)
+	{
+		return { Airflow.WindDirection * Airflow.WindForce, Airflow.UpdraftForce, Airflow.TurbulenceStrength * TurbulenceSample };
+	}
+};
+
+/** Forces (not divided by mass) acting on a body for one step, by source. Summed they are the linear acceleration times mass */
+struct FFlightForces
+{
+	FVector Gravity = FVector::ZeroVector;
+	FVector Lift = FVector::ZeroVector;
+	FVector Drag = FVector::ZeroVector;
+	FVector Side = FVector::ZeroVector;
+	FVector Thrust = FVector::ZeroVector;
+	FVector Environment = FVector::ZeroVector;
+	/** Angular velocity (deg/s) the pitching moment or stall recovery adds on top of the controls */
+	FVector StallTorque = FVector::ZeroVector;
+
+	FVector GetTotal() const { return Gravity + Lift + Drag + Side + Thrust + Environment; }
+};
+
+/** Which config a body flies with. Only references the configs, build one per step where they live */
+struct MYPROJECT_API FFlightModel
+{
+	FFlightModel(EFlightType InFlightType, const FAircraftConfig& InAircraft, const FDroneConfig& InDrone);
+	explicit FFlightModel(const UAirframeAsset& Airframe);
+
+	EFlightType FlightType;
+	const FAircraftConfig& Aircraft;
+	const FDroneConfig& Drone;
+	/** Baked from Aircraft.AeroTable, null when the aircraft flies on its constant coefficients */
+	const FAeroTable* AeroTable = nullptr;
+};
+
+/**
+ * Compile-time flight model of one flight type. FFlightDynamics picks the policy once per body and step,
+ * everything below that works on the concrete config without switching on FlightType again.
+ */
+struct MYPROJECT_API FAircraftFlightPolicy
+{
+	using FConfig = FAircraftConfig;
+	/** How fast the commanded rates follow the controls, higher = faster stop */
+	static constexpr float ControlDamping = 4.f;
+
+	static const FConfig& GetConfig(const FFlightModel& Model) { return Model.Aircraft; }
+	static FVector GetControlRates(const FConfig& Cfg) { return FVector(Cfg.PitchRate, Cfg.RollRate, Cfg.YawRate); }
+	static float GetMaxSpeed(const FConfig& Cfg) { return Cfg.CruiseSpeed; }
+
+	static FFlightForces CalculateForces(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FVector& EnvironmentForce, bool& bOutStalled);
+	static FVector CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FVector& EnvironmentForce, bool& bOutStalled);
+	static FVector CalculateStallTorque(const FFlightModel& Model, bool bStalled, const FFlightBodyState& State);
+	/** Control rates plus the stall torque, which is also handed out on its own */
+	static FVector CalculateDesiredAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled,
+		const FFlightBodyState& State, FVector& OutStallTorque);
+};
+
+struct MYPROJECT_API FDroneFlightPolicy
+{
+	using FConfig = FDroneConfig;
+	static constexpr float ControlDamping = 8.f;
+
+	static const FConfig& GetConfig(const FFlightModel& Model) { return Model.Drone; }
+	static FVector GetControlRates(const FConfig& Cfg) { return FVector(Cfg.MaxPitchAngle, Cfg.MaxRollAngle, Cfg.YawRate); }
+	static float GetMaxSpeed(const FConfig& Cfg) { return Cfg.MaxSpeed; }
+
+	/** Drones never stall, bOutStalled is always false */
+	static FFlightForces CalculateForces(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FVector& EnvironmentForce, bool& bOutStalled);
+	static FVector CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FVector& EnvironmentForce, bool& bOutStalled);
+	static FVector CalculateStallTorque(const FFlightModel& Model, bool bStalled, const FFlightBodyState& State) { return FVector::ZeroVector; }
+	static FVector CalculateDesiredAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled,
+		const FFlightBodyState& State, FVector& OutStallTorque);
+};
+
+/** Calls Func with a default constructed policy for FlightType: DispatchFlightPolicy(Type, [&](auto Policy) { using TPolicy = decltype(Policy); ... }) */
+template<typename FuncType>
+decltype(auto) DispatchFlightPolicy(EFlightType FlightType, FuncType&& Func)
+{
+	switch (FlightType)
+	{
+		case EFlightType::Drone: return Func(FDroneFlightPolicy());
+		default:                 return Func(FAircraftFlightPolicy());
+	}
+}
+
+/**
+ * Headless flight dynamics: plain state in, plain state out, no UObject or world access.
+ * AAAircraftBase, UFPVMovementComponent and UFlightSimSubsystem are thin wrappers around it, so server
+ * prediction, AI lookahead and offline tuning can step the exact model the game flies in batch.
+ */
+struct MYPROJECT_API FFlightDynamics
+{
+	/** Gravity, lift, drag, thrust and environment as an acceleration (cm/s²). bOutStalled is set past the stall angle */
+	static FVector CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FFlightEnvironment& Environment, bool& bOutStalled);
+
+	/** Every force of one step by source, with the angular term in StallTorque. Costs a step's worth of force math, for diagnostics */
+	static FFlightForces CalculateForces(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FFlightEnvironment& Environment, bool& bOutStalled);
+
+	/** Table coefficients for the current attitude and airspeed. Model.AeroTable must be set */
+	static FAeroCoefficients SampleAero(const FFlightModel& Model, const FFlightBodyState& State);
+
+	/** Side force (not divided by mass) for a side coefficient, along the right wing minus its part along the velocity */
+	static FVector CalculateSideForce(const FFlightBodyState& State, float SideCoefficient);
+
+	/** Moves State.ControlAngularVelocity towards what the controls (and stall recovery) ask for and returns it */
+	static FVector UpdateControlAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled, float DeltaTime,
+		FFlightBodyState& State);
+	/** Same, also handing out the stall torque it added, for the flight recorder */
+	static FVector UpdateControlAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled, float DeltaTime,
+		FFlightBodyState& State, FVector& OutStallTorque);
+
+	/** Same as above with the flight type resolved at compile time */
+	template<typename TPolicy>
+	static FVector CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FFlightEnvironment& Environment, bool& bOutStalled)
+	{
+		return TPolicy::CalculateLinearAcceleration(Model, State, Controls, GetEnvironmentForce(State, Environment), bOutStalled);
+	}
+
+	/** Same, also handing out the forces it summed. OutForces.StallTorque is left to UpdateControlAngularVelocity */
+	template<typename TPolicy>
+	static FVector CalculateLinearAcceleration(const FFlightModel& Model, const FFlightBodyState& State, const FFlightControls& Controls,
+		const FFlightEnvironment& Environment, bool& bOutStalled, FFlightForces& OutForces)
+	{
+		OutForces = TPolicy::CalculateForces(Model, State, Controls, GetEnvironmentForce(State, Environment), bOutStalled);
+		return OutForces.GetTotal() / FMath::Max(TPolicy::GetConfig(Model).Mass, 1.f);
+	}
+
+	template<typename TPolicy>
+	static FVector UpdateControlAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled, float DeltaTime,
+		FFlightBodyState& State)
+	{
+		FVector StallTorque;
+		return UpdateControlAngularVelocity<TPolicy>(Model, Controls, bStalled, DeltaTime, State, StallTorque);
+	}
+
+	template<typename TPolicy>
+	static FVector UpdateControlAngularVelocity(const FFlightModel& Model, const FFlightControls& Controls, bool bStalled, float DeltaTime,
+		FFlightBodyState& State, FVector& OutStallTorque)
+	{
+		return SmoothControlAngularVelocity(TPolicy::CalculateDesiredAngularVelocity(Model, Controls, bStalled, State, OutStallTorque),
+			TPolicy::ControlDamping, DeltaTime, State);
+	}
+
+	template<typename TPolicy>
+	static void Step(const FFlightModel& Model, const FFlightControls& Controls, const FFlightEnvironment& Environment,
+		EFlightIntegrator Integrator, float DeltaTime, FFlightBodyState& State)
+	{
+		bool bStalled = false;
+		const FVector LinearAccel = CalculateLinearAcceleration<TPolicy>(Model, State, Controls, Environment, bStalled);
+		const FVector AngularVel  = UpdateControlAngularVelocity<TPolicy>(Model, Controls, bStalled, DeltaTime, State);
+		Integrate(Integrator, DeltaTime, LinearAccel, AngularVel, State);
+	}
+
+	/** Wind, updraft and turbulence as a force on the body */
+	static FVector GetEnvironmentForce(const FFlightBodyState& State, const FFlightEnvironment& Environment);
+
+	/** Moves State.ControlAngularVelocity towards Desired and returns it */
+	static FVector SmoothControlAngularVelocity(const FVector& Desired, float DampingFactor, float DeltaTime, FFlightBodyState& State);
+
+	/** Integrates one step of linear acceleration and commanded angular velocity into State */
+	static void Integrate(EFlightIntegrator Integrator, float DeltaTime, const FVector& LinearAccel, const FVector& TargetAngularVelocity,
+		FFlightBodyState& State);
+
+	/** One full step: forces, controls, integration */
+	static void Step(const FFlightModel& Model, const FFlightControls& Controls, const FFlightEnvironment& Environment,
+		EFlightIntegrator Integrator, float DeltaTime, FFlightBodyState& State);
+};
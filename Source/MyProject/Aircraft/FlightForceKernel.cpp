@@ -0,0 +1,255 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightForceKernel.h"
+#include "FlightDynamics.h"
+
+static TAutoConsoleVariable<bool> CVarFlightSimd(
+	TEXT("ac.Flight.Simd"),
+	true,
+	TEXT("Use the vectorized force kernel for batched aircraft. When false the scalar kernel is used."),
+	ECVF_Default);
+
+void FFlightForceBatch::ClearLane(int32 Lane)
+{
+	ForwardX[Lane] = ForwardY[Lane] = ForwardZ[Lane] = 0.f;
+	UpX[Lane] = UpY[Lane] = UpZ[Lane] = 0.f;
+	VelX[Lane] = VelY[Lane] = VelZ[Lane] = 0.f;
+	EnvX[Lane] = EnvY[Lane] = EnvZ[Lane] = 0.f;
+	Updraft[Lane] = 0.f;
+	Gravity[Lane] = 0.f;
+	ThrustForce[Lane] = 0.f;
+	LiftK[Lane] = 0.f;
+	QuadraticDragK[Lane] = 0.f;
+	LinearDragK[Lane] = 0.f;
+	InvMass[Lane] = 1.f;
+	StallCos[Lane] = NoStall;
+	SideX[Lane] = SideY[Lane] = SideZ[Lane] = 0.f;
+}
+
+// Linear terms of FFlightDynamics::CalculateLinearAcceleration, expressed as per-lane coefficients
+void FFlightForceBatch::SetLane(int32 Lane, const FFlightModel& Model, const FFlightBodyState& Body, const FFlightControls& Controls,
+	const FFlightEnvironment& Environment)
+{
+	const FVector Forward = Body.Rotation.GetForwardVector();
+	const FVector Up      = Body.Rotation.GetUpVector();
+	const FVector& Vel    = Body.LinearVelocity;
+	FVector Env           = Environment.Wind + Environment.Turbulence;
+
+	ForwardX[Lane] = Forward.X; ForwardY[Lane] = Forward.Y; ForwardZ[Lane] = Forward.Z;
+	UpX[Lane]      = Up.X;      UpY[Lane]      = Up.Y;      UpZ[Lane]      = Up.Z;
+	VelX[Lane]     = Vel.X;     VelY[Lane]     = Vel.Y;     VelZ[Lane]     = Vel.Z;
+	EnvX[Lane]     = Env.X;     EnvY[Lane]     = Env.Y;     EnvZ[Lane]     = Env.Z;
+	Updraft[Lane]  = Environment.Updraft;
+	SideX[Lane]    = SideY[Lane] = SideZ[Lane] = 0.f;
+
+	switch (Model.FlightType)
+	{
+		case EFlightType::Aircraft:
+		{
+			const FAircraftConfig& Cfg = Model.Aircraft;
+			Gravity[Lane]        = -980.f * Cfg.GravityScale * Cfg.Mass;
+			ThrustForce[Lane]    = Controls.Thrust * Cfg.ThrustPower;
+			LiftK[Lane]          = 0.5f * Cfg.LiftCoefficient;
+			QuadraticDragK[Lane] = 0.5f * Cfg.DragCoefficient;
+			LinearDragK[Lane]    = 0.f;
+			InvMass[Lane]        = 1.f / FMath::Max(Cfg.Mass, 1.f);
+			StallCos[Lane]       = FFlightForceBatch::MakeStallCos(Cfg.StallAngleDegrees);
+
+			// Table coefficients change every step, the side force has no lane of its own and rides on the environment
+			if (Model.AeroTable)
+			{
+				const FAeroCoefficients Aero = FFlightDynamics::SampleAero(Model, Body);
+				LiftK[Lane]          = 0.5f * Aero.Lift;
+				QuadraticDragK[Lane] = 0.5f * Aero.Drag;
+				StallCos[Lane]       = Model.AeroTable->StallCos;
+				const FVector Side = FFlightDynamics::CalculateSideForce(Body, Aero.Side);
+				Env += Side;
+				EnvX[Lane]  = Env.X;  EnvY[Lane]  = Env.Y;  EnvZ[Lane]  = Env.Z;
+				SideX[Lane] = Side.X; SideY[Lane] = Side.Y; SideZ[Lane] = Side.Z;
+			}
+			break;
+		}
+		case EFlightType::Drone:
+		{
+			const FDroneConfig& Cfg = Model.Drone;
+			Gravity[Lane]        = 0.f;
+			ThrustForce[Lane]    = Controls.Thrust * Cfg.Acceleration;
+			LiftK[Lane]          = 0.f;
+			QuadraticDragK[Lane] = 0.f;
+			LinearDragK[Lane]    = Cfg.DragCoefficient;
+			InvMass[Lane]        = 1.f / FMath::Max(Cfg.Mass, 1.f);
+			StallCos[Lane]       = FFlightForceBatch::NoStall;
+			break;
+		}
+		default:
+			ClearLane(Lane);
+			break;
+	}
+}
+
+FFlightForces FFlightForceBatch::GetLaneForces(int32 Lane) const
+{
+	const FVector Side(SideX[Lane], SideY[Lane], SideZ[Lane]);
+
+	FFlightForces Forces;
+	Forces.Gravity     = FVector(0.0, 0.0, Gravity[Lane]);
+	Forces.Lift        = FVector(LiftX[Lane], LiftY[Lane], LiftZ[Lane]);
+	Forces.Drag        = FVector(DragX[Lane], DragY[Lane], DragZ[Lane]);
+	Forces.Side        = Side;
+	Forces.Thrust      = FVector(ThrustX[Lane], ThrustY[Lane], ThrustZ[Lane]);
+	Forces.Environment = FVector(EnvForceX[Lane], EnvForceY[Lane], EnvForceZ[Lane]) - Side;
+	return Forces;
+}
+
+float FFlightForceBatch::MakeStallCos(float StallAngleDegrees)
+{
+	// AoA magnitude comes from Acos, so it lives in [0, 180] and cos() is monotonic over that range
+	if (StallAngleDegrees <= 0.f) return 2.f;
+	if (StallAngleDegrees > 180.f) return NoStall;
+	return FMath::Cos(FMath::DegreesToRadians(StallAngleDegrees));
+}
+
+void FFlightForceKernel::Compute(FFlightForceBatch& Batch)
+{
+#if PLATFORM_ENABLE_VECTORINTRINSICS
+	if (CVarFlightSimd.GetValueOnAnyThread())
+	{
+		ComputeVectorized(Batch);
+		return;
+	}
+#endif
+	ComputeScalar(Batch);
+}
+
+void FFlightForceKernel::ComputeScalar(FFlightForceBatch& B)
+{
+	B.StallMask = 0;
+
+	for (int32 L = 0; L < FFlightForceBatch::Lanes; ++L)
+	{
+		const FVector3f Forward(B.ForwardX[L], B.ForwardY[L], B.ForwardZ[L]);
+		const FVector3f Up(B.UpX[L], B.UpY[L], B.UpZ[L]);
+		const FVector3f Vel(B.VelX[L], B.VelY[L], B.VelZ[L]);
+
+		const float SpeedSq = Vel.SizeSquared();
+		const bool bHasVelocity = SpeedSq > SMALL_NUMBER;
+		const FVector3f VelDir = bHasVelocity ? Vel * FMath::InvSqrt(SpeedSq) : FVector3f::ZeroVector;
+
+		// --- Stall: Abs(AoA) >= StallAngle  <=>  cos(AoA) <= cos(StallAngle) ---
+		const bool bStalled = bHasVelocity ? (Forward | VelDir) <= B.StallCos[L] : B.StallCos[L] > 1.f;
+		B.StallMask |= bStalled ? (1u << L) : 0u;
+
+		// --- Lift ---
+		const FVector3f LiftRaw = Up - (Up | VelDir) * VelDir;
+		const float LiftRawSq = LiftRaw.SizeSquared();
+		const FVector3f LiftDir = LiftRawSq > SMALL_NUMBER ? LiftRaw * FMath::InvSqrt(LiftRawSq) : FVector3f::ZeroVector;
+
+		FVector3f Force = LiftDir * (SpeedSq * B.LiftK[L]);
+		Force -= VelDir * (SpeedSq * B.QuadraticDragK[L]);
+		Force -= Vel * B.LinearDragK[L];
+		Force += Forward * B.ThrustForce[L];
+		Force += Up * B.Updraft[L];
+		Force += FVector3f(B.EnvX[L], B.EnvY[L], B.EnvZ[L] + B.Gravity[L]);
+
+		const FVector3f Accel = Force * B.InvMass[L];
+		B.AccelX[L] = Accel.X;
+		B.AccelY[L] = Accel.Y;
+		B.AccelZ[L] = Accel.Z;
+
+		if (B.bOutputForces)
+		{
+			const FVector3f Lift = LiftDir * (SpeedSq * B.LiftK[L]);
+			const FVector3f Drag = -VelDir * (SpeedSq * B.QuadraticDragK[L]) - Vel * B.LinearDragK[L];
+			const FVector3f Thrust = Forward * B.ThrustForce[L];
+			const FVector3f Env = Up * B.Updraft[L] + FVector3f(B.EnvX[L], B.EnvY[L], B.EnvZ[L]);
+			B.LiftX[L]     = Lift.X;   B.LiftY[L]     = Lift.Y;   B.LiftZ[L]     = Lift.Z;
+			B.DragX[L]     = Drag.X;   B.DragY[L]     = Drag.Y;   B.DragZ[L]     = Drag.Z;
+			B.ThrustX[L]   = Thrust.X; B.ThrustY[L]   = Thrust.Y; B.ThrustZ[L]   = Thrust.Z;
+			B.EnvForceX[L] = Env.X;    B.EnvForceY[L] = Env.Y;    B.EnvForceZ[L] = Env.Z;
+		}
+	}
+}
+
+void FFlightForceKernel::ComputeVectorized(FFlightForceBatch& B)
+{
+	static_assert(FFlightForceBatch::Lanes == 4, "Vector path is written for VectorRegister4Float");
+
+	const VectorRegister4Float Zero     = VectorZeroFloat();
+	const VectorRegister4Float One      = VectorSetFloat1(1.f);
+	const VectorRegister4Float Epsilon  = VectorSetFloat1(SMALL_NUMBER);
+
+	const VectorRegister4Float FwdX = VectorLoadAligned(B.ForwardX);
+	const VectorRegister4Float FwdY = VectorLoadAligned(B.ForwardY);
+	const VectorRegister4Float FwdZ = VectorLoadAligned(B.ForwardZ);
+	const VectorRegister4Float UpX  = VectorLoadAligned(B.UpX);
+	const VectorRegister4Float UpY  = VectorLoadAligned(B.UpY);
+	const VectorRegister4Float UpZ  = VectorLoadAligned(B.UpZ);
+	const VectorRegister4Float VelX = VectorLoadAligned(B.VelX);
+	const VectorRegister4Float VelY = VectorLoadAligned(B.VelY);
+	const VectorRegister4Float VelZ = VectorLoadAligned(B.VelZ);
+
+	// --- Velocity direction (safe normal) ---
+	const VectorRegister4Float SpeedSq = VectorMultiplyAdd(VelX, VelX, VectorMultiplyAdd(VelY, VelY, VectorMultiply(VelZ, VelZ)));
+	const VectorRegister4Float HasVelocity = VectorCompareGT(SpeedSq, Epsilon);
+	const VectorRegister4Float InvSpeed = VectorSelect(HasVelocity, VectorDivide(One, VectorSqrt(VectorMax(SpeedSq, Epsilon))), Zero);
+	const VectorRegister4Float DirX = VectorMultiply(VelX, InvSpeed);
+	const VectorRegister4Float DirY = VectorMultiply(VelY, InvSpeed);
+	const VectorRegister4Float DirZ = VectorMultiply(VelZ, InvSpeed);
+
+	// --- Stall mask from cos(AoA) ---
+	const VectorRegister4Float StallCos = VectorLoadAligned(B.StallCos);
+	const VectorRegister4Float CosAoA = VectorMultiplyAdd(FwdX, DirX, VectorMultiplyAdd(FwdY, DirY, VectorMultiply(FwdZ, DirZ)));
+	const VectorRegister4Float Stalled = VectorSelect(HasVelocity, VectorCompareLE(CosAoA, StallCos), VectorCompareGT(StallCos, One));
+	B.StallMask = static_cast<uint32>(VectorMaskBits(Stalled));
+
+	// --- Lift direction: Up with the velocity component removed ---
+	const VectorRegister4Float UpDotDir = VectorMultiplyAdd(UpX, DirX, VectorMultiplyAdd(UpY, DirY, VectorMultiply(UpZ, DirZ)));
+	const VectorRegister4Float LiftRawX = VectorSubtract(UpX, VectorMultiply(UpDotDir, DirX));
+	const VectorRegister4Float LiftRawY = VectorSubtract(UpY, VectorMultiply(UpDotDir, DirY));
+	const VectorRegister4Float LiftRawZ = VectorSubtract(UpZ, VectorMultiply(UpDotDir, DirZ));
+	const VectorRegister4Float LiftRawSq = VectorMultiplyAdd(LiftRawX, LiftRawX, VectorMultiplyAdd(LiftRawY, LiftRawY, VectorMultiply(LiftRawZ, LiftRawZ)));
+	const VectorRegister4Float InvLiftLen = VectorSelect(VectorCompareGT(LiftRawSq, Epsilon), VectorDivide(One, VectorSqrt(VectorMax(LiftRawSq, Epsilon))), Zero);
+
+	// --- Scalar magnitudes per lane ---
+	const VectorRegister4Float LiftMag      = VectorMultiply(VectorMultiply(SpeedSq, VectorLoadAligned(B.LiftK)), InvLiftLen);
+	const VectorRegister4Float QuadDragMag  = VectorNegate(VectorMultiply(SpeedSq, VectorLoadAligned(B.QuadraticDragK)));
+	const VectorRegister4Float LinDragMag   = VectorNegate(VectorLoadAligned(B.LinearDragK));
+	const VectorRegister4Float ThrustMag    = VectorLoadAligned(B.ThrustForce);
+	const VectorRegister4Float UpdraftMag   = VectorLoadAligned(B.Updraft);
+	const VectorRegister4Float InvMass      = VectorLoadAligned(B.InvMass);
+
+	auto SumAxis = [&](const VectorRegister4Float& LiftRaw, const VectorRegister4Float& Dir, const VectorRegister4Float& Vel,
+		const VectorRegister4Float& Fwd, const VectorRegister4Float& Up, const VectorRegister4Float& Env)
+	{
+		VectorRegister4Float Force = VectorMultiply(LiftRaw, LiftMag);
+		Force = VectorMultiplyAdd(Dir, QuadDragMag, Force);
+		Force = VectorMultiplyAdd(Vel, LinDragMag, Force);
+		Force = VectorMultiplyAdd(Fwd, ThrustMag, Force);
+		Force = VectorMultiplyAdd(Up, UpdraftMag, Force);
+		Force = VectorAdd(Force, Env);
+		return VectorMultiply(Force, InvMass);
+	};
+
+	const VectorRegister4Float EnvZ = VectorAdd(VectorLoadAligned(B.EnvZ), VectorLoadAligned(B.Gravity));
+	VectorStoreAligned(SumAxis(LiftRawX, DirX, VelX, FwdX, UpX, VectorLoadAligned(B.EnvX)), B.AccelX);
+	VectorStoreAligned(SumAxis(LiftRawY, DirY, VelY, FwdY, UpY, VectorLoadAligned(B.EnvY)), B.AccelY);
+	VectorStoreAligned(SumAxis(LiftRawZ, DirZ, VelZ, FwdZ, UpZ, EnvZ), B.AccelZ);
+
+	if (B.bOutputForces)
+	{
+		// The terms SumAxis folded together, one axis at a time
+		auto StoreAxis = [&](const VectorRegister4Float& LiftRaw, const VectorRegister4Float& Dir, const VectorRegister4Float& Vel,
+			const VectorRegister4Float& Fwd, const VectorRegister4Float& Up, const VectorRegister4Float& Env,
+			float* OutLift, float* OutDrag, float* OutThrust, float* OutEnv)
+		{
+			VectorStoreAligned(VectorMultiply(LiftRaw, LiftMag), OutLift);
+			VectorStoreAligned(VectorMultiplyAdd(Vel, LinDragMag, VectorMultiply(Dir, QuadDragMag)), OutDrag);
+			VectorStoreAligned(VectorMultiply(Fwd, ThrustMag), OutThrust);
+			VectorStoreAligned(VectorMultiplyAdd(Up, UpdraftMag, Env), OutEnv);
+		};
+		StoreAxis(LiftRawX, DirX, VelX, FwdX, UpX, VectorLoadAligned(B.EnvX), B.LiftX, B.DragX, B.ThrustX, B.EnvForceX);
+		StoreAxis(LiftRawY, DirY, VelY, FwdY, UpY, VectorLoadAligned(B.EnvY), B.LiftY, B.DragY, B.ThrustY, B.EnvForceY);
+		StoreAxis(LiftRawZ, DirZ, VelZ, FwdZ, UpZ, VectorLoadAligned(B.EnvZ), B.LiftZ, B.DragZ, B.ThrustZ, B.EnvForceZ);
+	}
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FFlightModel;
+struct FFlightBodyState;
+struct FFlightControls;
+struct FFlightEnvironment;
+struct FFlightForces;
+
+/**
+ * Linear force inputs and outputs for a small group of aircraft, laid out lane-wise so one
+ * VectorRegister4Float holds the same component of every aircraft in the group.
+ * Aircraft and Drone both fit the same formula; terms a flight type does not use are zeroed.
+ */
+struct alignas(16) FFlightForceBatch
+{
+	static constexpr int32 Lanes = 4;
+
+	// --- Inputs ---
+	float ForwardX[Lanes], ForwardY[Lanes], ForwardZ[Lanes];
+	float UpX[Lanes], UpY[Lanes], UpZ[Lanes];
+	float VelX[Lanes], VelY[Lanes], VelZ[Lanes];
+	/** Wind + turbulence force */
+	float EnvX[Lanes], EnvY[Lanes], EnvZ[Lanes];
+	/** Updraft force along the aircraft up vector */
+	float Updraft[Lanes];
+	/** World Z gravity force (already scaled by mass), 0 for drones */
+	float Gravity[Lanes];
+	float ThrustForce[Lanes];
+	/** 0.5 * Cl for aircraft, 0 for drones */
+	float LiftK[Lanes];
+	/** 0.5 * Cd for aircraft, 0 for drones */
+	float QuadraticDragK[Lanes];
+	/** Cd for drones, 0 for aircraft */
+	float LinearDragK[Lanes];
+	float InvMass[Lanes];
+	/** Cosine of the stall angle: stalled when dot(Forward, VelDir) <= StallCos. Use MakeStallCos */
+	float StallCos[Lanes];
+	/** Part of Env that is the table side force. Not read by the kernel, only split back out by GetLaneForces */
+	float SideX[Lanes], SideY[Lanes], SideZ[Lanes];
+
+	// --- Outputs ---
+	float AccelX[Lanes], AccelY[Lanes], AccelZ[Lanes];
+
+	// --- Outputs by source, only written with bOutputForces. Gravity is the input, the rest sums to the acceleration times mass ---
+	float LiftX[Lanes], LiftY[Lanes], LiftZ[Lanes];
+	/** Quadratic and linear drag */
+	float DragX[Lanes], DragY[Lanes], DragZ[Lanes];
+	float ThrustX[Lanes], ThrustY[Lanes], ThrustZ[Lanes];
+	/** Env plus the updraft along the up vector */
+	float EnvForceX[Lanes], EnvForceY[Lanes], EnvForceZ[Lanes];
+
+	/** Bit per lane, set when the lane is past its stall angle */
+	uint32 StallMask;
+	/** Input: also store every force by source, for lanes whose flight is being recorded */
+	bool bOutputForces = false;
+
+	/** Zeroes a lane so it produces no acceleration and never stalls */
+	void ClearLane(int32 Lane);
+	/** Loads one body's inputs into a lane, so the lane computes what FFlightDynamics::CalculateLinearAcceleration would */
+	void SetLane(int32 Lane, const FFlightModel& Model, const FFlightBodyState& Body, const FFlightControls& Controls,
+		const FFlightEnvironment& Environment);
+	/** The forces one lane's acceleration was summed from, StallTorque left zero. Needs a Compute with bOutputForces */
+	FFlightForces GetLaneForces(int32 Lane) const;
+
+	/** Converts a stall angle to the cosine threshold compared against, matching Abs(AoA) >= StallAngleDegrees */
+	static float MakeStallCos(float StallAngleDegrees);
+	/** Threshold that never reports a stall (drones) */
+	static constexpr float NoStall = -2.f;
+};
+
+/**
+ * Lane-batched linear force model for EFlightType::Aircraft and EFlightType::Drone.
+ * Angle of attack is tested through its cosine, so no Acos is needed per aircraft.
+ */
+struct MYPROJECT_API FFlightForceKernel
+{
+	/** Uses the vector path when the platform has intrinsics and ac.Flight.Simd is set */
+	static void Compute(FFlightForceBatch& Batch);
+
+	static void ComputeScalar(FFlightForceBatch& Batch);
+	static void ComputeVectorized(FFlightForceBatch& Batch);
+};
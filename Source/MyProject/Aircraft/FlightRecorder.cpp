@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightRecorder.h"
+
+#include "AAircraftBase.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Tasks/Task.h"
+
+static TAutoConsoleVariable<bool> CVarRecorderEnable(
+	TEXT("ac.Recorder.Enable"),
+	true,
+	TEXT("Give aircraft spawned afterwards a flight data recorder."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarRecorderSeconds(
+	TEXT("ac.Recorder.Seconds"),
+	10.f,
+	TEXT("Seconds of flight steps each aircraft's recorder keeps. Takes effect for aircraft spawned afterwards."),
+	ECVF_Default);
+
+// Recorders and their aircraft names, gathered on the game thread and handed to the dump task
+using FRecorderSources = TArray<TPair<FString, TSharedPtr<FFlightRecorder, ESPMode::ThreadSafe>>>;
+
+namespace FlightRecorderFormat
+{
+	constexpr uint32 Magic = 0x58424C46; // "FLBX"
+	constexpr uint32 Version = 2;
+
+	static const TCHAR* GetTypeName(EFlightRecordType Type)
+	{
+		switch (Type)
+		{
+			case EFlightRecordType::Step:         return TEXT("Step");
+			case EFlightRecordType::ServerState:  return TEXT("ServerState");
+			case EFlightRecordType::Correction:   return TEXT("Correction");
+			case EFlightRecordType::Clamped:      return TEXT("Clamped");
+			case EFlightRecordType::ReplayedStep: return TEXT("ReplayedStep");
+			default:                              return TEXT("Unknown");
+		}
+	}
+
+	static bool WriteBinary(const FString& Path, const FRecorderSources& Sources, int32& OutNumRecords)
+	{
+		TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*Path));
+		if (!Ar) return false;
+
+		uint32 FileMagic = Magic;
+		uint32 FileVersion = Version;
+		int32 NumAircraft = Sources.Num();
+		*Ar << FileMagic << FileVersion << NumAircraft;
+
+		TArray<FFlightRecord> Records;
+		for (const auto& [Name, Recorder] : Sources)
+		{
+			Recorder->Snapshot(Records);
+			FString AircraftName = Name;
+			int32 NumRecords = Records.Num();
+			*Ar << AircraftName << NumRecords;
+			for (FFlightRecord& Record : Records)
+			{
+				*Ar << Record;
+			}
+			OutNumRecords += NumRecords;
+		}
+		return Ar->Close();
+	}
+
+	static bool WriteCsv(const FString& Path, const FRecorderSources& Sources, int32& OutNumRecords)
+	{
+		FString Csv;
+		FFlightRecorder::WriteCsvHeader(Csv);
+
+		TArray<FFlightRecord> Records;
+		for (const auto& [Name, Recorder] : Sources)
+		{
+			Recorder->Snapshot(Records);
+			FFlightRecorder::WriteCsvRows(Name, Records, Csv);
+			OutNumRecords += Records.Num();
+		}
+		return FFileHelper::SaveStringToFile(Csv, *Path);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdRecorderDump(
+	TEXT("ac.Recorder.Dump"),
+	TEXT("ac.Recorder.Dump <csv|bin=csv> <AircraftName>: writes the flight recorder of every aircraft (or the named one) to Saved/FlightRecorder on a background task."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World) return;
+
+		const bool bBinary = Args.Num() > 0 && Args[0] == TEXT("bin");
+		FRecorderSources Sources;
+		for (TActorIterator<AAAircraftBase> It(World); It; ++It)
+		{
+			if (Args.Num() > 1 && It->GetName() != Args[1]) continue;
+
+			const UFPVMovementComponent* MoveComp = It->FindComponentByClass<UFPVMovementComponent>();
+			if (MoveComp && MoveComp->GetRecorder())
+			{
+				Sources.Emplace(It->GetName(), MoveComp->GetRecorder());
+			}
+		}
+		if (Sources.IsEmpty())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[Recorder] No aircraft with a recorder to dump"));
+			return;
+		}
+
+		// Server and client dumps of the same incident end up side by side
+		const FString Path = FPaths::ProjectSavedDir() / TEXT("FlightRecorder") / FString::Printf(TEXT("%s_%s.%s"),
+			World->GetNetMode() == NM_Client ? TEXT("Client") : TEXT("Server"), *FDateTime::Now().ToString(), bBinary ? TEXT("flightbox") : TEXT("csv"));
+
+		// The game thread only collected pointers, copying the rings and formatting happen on the task
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Sources = MoveTemp(Sources), Path, bBinary]()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			int32 NumRecords = 0;
+			const bool bWritten = bBinary
+				? FlightRecorderFormat::WriteBinary(Path, Sources, NumRecords)
+				: FlightRecorderFormat::WriteCsv(Path, Sources, NumRecords);
+
+			if (bWritten)
+			{
+				UE_LOG(LogTemp, Log, TEXT("[Recorder] Dumped %d records of %d aircraft to %s in %.1f ms"),
+					NumRecords, Sources.Num(), *Path, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("[Recorder] Could not write %s"), *Path);
+			}
+		});
+	}));
+
+void FFlightRecord::SetBody(const FFlightBodyState& Body)
+{
+	Location = Body.Location;
+	Rotation = FQuat4f(Body.Rotation);
+	LinearVelocity = FVector3f(Body.LinearVelocity);
+	AngularVelocity = FVector3f(Body.AngularVelocity);
+}
+
+FArchive& operator<<(FArchive& Ar, FFlightRecord& Record)
+{
+	uint8 Type = static_cast<uint8>(Record.Type);
+	uint8 Stalled = Record.bStalled ? 1 : 0;
+	Ar << Record.Time << Record.Sequence << Type << Stalled;
+	Record.Type = static_cast<EFlightRecordType>(Type);
+	Record.bStalled = Stalled != 0;
+
+	Ar << Record.Thrust << Record.Steering << Record.Yaw;
+	Ar << Record.Location << Record.Rotation << Record.LinearVelocity << Record.AngularVelocity;
+	Ar << Record.Lift << Record.Drag << Record.Side << Record.ThrustForce << Record.Environment << Record.StallTorque;
+	Ar << Record.Error;
+	return Ar;
+}
+
+FFlightRecorder::FFlightRecorder(int32 Capacity)
+{
+	const int32 Size = FMath::RoundUpToPowerOfTwo(FMath::Max(Capacity, 2));
+	Records.SetNum(Size);
+	Mask = Size - 1;
+}
+
+void FFlightRecorder::RecordStep(double Time, uint32 Sequence, const FFlightControls& Controls, const FFlightForces& Forces, bool bStalled,
+	const FFlightBodyState& Body, EFlightRecordType Type)
+{
+	FFlightRecord Record;
+	Record.Time = Time;
+	Record.Sequence = Sequence;
+	Record.Type = Type;
+	Record.bStalled = bStalled;
+	Record.Thrust = Controls.Thrust;
+	Record.Steering = FVector2f(Controls.Steering);
+	Record.Yaw = Controls.Yaw;
+	Record.SetBody(Body);
+	Record.Lift = FVector3f(Forces.Lift);
+	Record.Drag = FVector3f(Forces.Drag);
+	Record.Side = FVector3f(Forces.Side);
+	Record.ThrustForce = FVector3f(Forces.Thrust);
+	Record.Environment = FVector3f(Forces.Environment);
+	Record.StallTorque = FVector3f(Forces.StallTorque);
+	Write(Record);
+}
+
+void FFlightRecorder::Snapshot(TArray<FFlightRecord>& OutRecords) const
+{
+	const uint64 Capacity = Records.Num();
+	const uint64 End = NumWritten.load(std::memory_order_acquire);
+	const uint64 Begin = End > Capacity ? End - Capacity : 0;
+
+	OutRecords.Reset(static_cast<int32>(End - Begin));
+	for (uint64 Index = Begin; Index < End; ++Index)
+	{
+		OutRecords.Add(Records[Index & Mask]);
+	}
+
+	// Every write started since may have torn one of the oldest records copied above, drop those
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64 Started = NumStarted.load(std::memory_order_relaxed);
+	const uint64 FirstIntact = Started > Capacity ? Started - Capacity : 0;
+	if (FirstIntact > Begin)
+	{
+		OutRecords.RemoveAt(0, static_cast<int32>(FMath::Min<uint64>(FirstIntact - Begin, OutRecords.Num())));
+	}
+}
+
+void FFlightRecorder::WriteCsvHeader(FString& Out)
+{
+	Out += TEXT("Aircraft,Time,Type,Sequence,Stalled,Thrust,SteeringX,SteeringY,Yaw,")
+		TEXT("X,Y,Z,QX,QY,QZ,QW,VX,VY,VZ,WX,WY,WZ,")
+		TEXT("LiftX,LiftY,LiftZ,DragX,DragY,DragZ,SideX,SideY,SideZ,ThrustX,ThrustY,ThrustZ,EnvX,EnvY,EnvZ,StallTorqueX,StallTorqueY,StallTorqueZ,")
+		TEXT("ErrorX,ErrorY,ErrorZ\n");
+}
+
+void FFlightRecorder::WriteCsvRows(const FString& AircraftName, TConstArrayView<FFlightRecord> InRecords, FString& Out)
+{
+	auto AppendVector = [&Out](const FVector3f& V) { Out += FString::Printf(TEXT(",%.3f,%.3f,%.3f"), V.X, V.Y, V.Z); };
+
+	for (const FFlightRecord& Record : InRecords)
+	{
+		Out += FString::Printf(TEXT("%s,%.4f,%s,%u,%d,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f,%.5f,%.5f,%.5f,%.5f"),
+			*AircraftName, Record.Time, FlightRecorderFormat::GetTypeName(Record.Type), Record.Sequence, Record.bStalled ? 1 : 0,
+			Record.Thrust, Record.Steering.X, Record.Steering.Y, Record.Yaw,
+			Record.Location.X, Record.Location.Y, Record.Location.Z,
+			Record.Rotation.X, Record.Rotation.Y, Record.Rotation.Z, Record.Rotation.W);
+		AppendVector(Record.LinearVelocity);
+		AppendVector(Record.AngularVelocity);
+		AppendVector(Record.Lift);
+		AppendVector(Record.Drag);
+		AppendVector(Record.Side);
+		AppendVector(Record.ThrustForce);
+		AppendVector(Record.Environment);
+		AppendVector(Record.StallTorque);
+		AppendVector(Record.Error);
+		Out += TEXT("\n");
+	}
+}
+
+TSharedPtr<FFlightRecorder, ESPMode::ThreadSafe> FFlightRecorder::MakeForAircraft()
+{
+	if (!CVarRecorderEnable.GetValueOnGameThread()) return nullptr;
+
+	// Server states and corrections share the ring with the steps, the power-of-two rounding leaves room for them
+	return MakeShared<FFlightRecorder, ESPMode::ThreadSafe>(FMath::CeilToInt32(CVarRecorderSeconds.GetValueOnGameThread() / UFPVMovementComponent::GetNetStepSeconds()));
+}
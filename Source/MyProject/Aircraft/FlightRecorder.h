@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FlightDynamics.h"
+#include <atomic>
+
+enum class EFlightRecordType : uint8
+{
+	/** One simulated step: controls and forces at its start, body state at its end */
+	Step,
+	/** Client: an authoritative server state arrived */
+	ServerState,
+	/** Owning client: the prediction missed and was rewound to the server state */
+	Correction,
+	/** Server: a remotely driven step was clamped to the airframe's limits, state after the clamp */
+	Clamped,
+	/** Owning client: a Step simulated again after a Correction, its sequence already has a Step record */
+	ReplayedStep,
+};
+
+/** One black box entry. Fixed size and trivially copyable, so writing it is a plain copy into the ring */
+struct FFlightRecord
+{
+	double Time = 0.0;
+	/** Input frame a step simulated, or the last input a server state acknowledged */
+	uint32 Sequence = 0;
+	EFlightRecordType Type = EFlightRecordType::Step;
+	bool bStalled = false;
+
+	float Thrust = 0.f;
+	FVector2f Steering = FVector2f::ZeroVector;
+	float Yaw = 0.f;
+
+	FVector Location = FVector::ZeroVector;
+	FQuat4f Rotation = FQuat4f::Identity;
+	FVector3f LinearVelocity = FVector3f::ZeroVector;
+	FVector3f AngularVelocity = FVector3f::ZeroVector;
+
+	FVector3f Lift = FVector3f::ZeroVector;
+	FVector3f Drag = FVector3f::ZeroVector;
+	FVector3f Side = FVector3f::ZeroVector;
+	FVector3f ThrustForce = FVector3f::ZeroVector;
+	FVector3f Environment = FVector3f::ZeroVector;
+	FVector3f StallTorque = FVector3f::ZeroVector;
+
+	/** Correction records: how far the prediction was from the server state */
+	FVector3f Error = FVector3f::ZeroVector;
+
+	void SetBody(const FFlightBodyState& Body);
+
+	friend FArchive& operator<<(FArchive& Ar, FFlightRecord& Record);
+};
+
+/**
+ * Black box of one aircraft: the last few seconds of steps, server states and corrections in a ring that is
+ * allocated once and then overwritten oldest first.
+ *
+ * One writer (whichever thread steps the aircraft, a flight worker for batched aircraft) and any number of
+ * readers. Writing never locks or allocates. Readers copy the ring while it is being written and drop whatever
+ * the writer may have overwritten in the meantime, so a dump can run on a background task during play.
+ */
+class MYPROJECT_API FFlightRecorder
+{
+public:
+	/** Room for at least Capacity records, rounded up to a power of two */
+	explicit FFlightRecorder(int32 Capacity);
+	/** Sized for ac.Recorder.Seconds of fixed steps, null while ac.Recorder.Enable is off */
+	static TSharedPtr<FFlightRecorder, ESPMode::ThreadSafe> MakeForAircraft();
+
+	void Write(const FFlightRecord& Record)
+	{
+		// Seqlock style: announce the slot is being reused before touching it, publish once it is complete
+		const uint64 Index = NumWritten.load(std::memory_order_relaxed);
+		NumStarted.store(Index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Records[Index & Mask] = Record;
+		NumWritten.store(Index + 1, std::memory_order_release);
+	}
+
+	/** Type is Step or ReplayedStep */
+	void RecordStep(double Time, uint32 Sequence, const FFlightControls& Controls, const FFlightForces& Forces, bool bStalled,
+		const FFlightBodyState& Body, EFlightRecordType Type = EFlightRecordType::Step);
+
+	/** Any thread: the records that survived the copy intact, oldest first */
+	void Snapshot(TArray<FFlightRecord>& OutRecords) const;
+
+	int32 GetCapacity() const { return Records.Num(); }
+	SIZE_T GetAllocatedSize() const { return Records.GetAllocatedSize(); }
+
+	/** Dump formats: one row per record with the aircraft name in front, or the records as serialized by FFlightRecord */
+	static void WriteCsvHeader(FString& Out);
+	static void WriteCsvRows(const FString& AircraftName, TConstArrayView<FFlightRecord> InRecords, FString& Out);
+
+private:
+	TArray<FFlightRecord> Records;
+	uint64 Mask = 0;
+	std::atomic<uint64> NumStarted{ 0 };
+	std::atomic<uint64> NumWritten{ 0 };
+};
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightRelevancySubsystem.h"
+
+#include "AAircraftBase.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+static TAutoConsoleVariable<float> CVarNetRelevancyCellSize(
+	TEXT("ac.Net.RelevancyCellSize"),
+	100000.f,
+	TEXT("Size (cm) of the grid cells aircraft are binned into for replication rate decisions."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetRelevancyInterval(
+	TEXT("ac.Net.RelevancyInterval"),
+	0.25f,
+	TEXT("Seconds between aircraft update-rate recalculations."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetWeaponsRange(
+	TEXT("ac.Net.WeaponsRange"),
+	150000.f,
+	TEXT("Aircraft within this distance (cm) of a pilot replicate at full rate and top priority."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetFarDistance(
+	TEXT("ac.Net.FarDistance"),
+	500000.f,
+	TEXT("Distance (cm) at which aircraft reach the minimum update rate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetCullDistance(
+	TEXT("ac.Net.CullDistance"),
+	3000000.f,
+	TEXT("Aircraft further than this (cm) from a connection's viewpoint are not replicated to it."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetViewConeDegrees(
+	TEXT("ac.Net.ViewConeDegrees"),
+	45.f,
+	TEXT("Half-angle of the pilot view cone that gets full rate and priority regardless of distance."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetNearUpdateHz(
+	TEXT("ac.Net.NearUpdateHz"),
+	60.f,
+	TEXT("Net update frequency of aircraft within weapons range of any pilot."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetFarUpdateHz(
+	TEXT("ac.Net.FarUpdateHz"),
+	4.f,
+	TEXT("Net update frequency of aircraft beyond ac.Net.FarDistance from every pilot."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarNetPriorityBoost(
+	TEXT("ac.Net.PriorityBoost"),
+	4.f,
+	TEXT("Net priority multiplier for aircraft in a pilot's weapons range or view cone."),
+	ECVF_Default);
+
+bool UFlightRelevancySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UFlightRelevancySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlightRelevancySubsystem, STATGROUP_Tickables);
+}
+
+float UFlightRelevancySubsystem::GetCullDistance()
+{
+	return CVarNetCullDistance.GetValueOnGameThread();
+}
+
+float UFlightRelevancySubsystem::GetPriorityScale(const FVector& AircraftLocation, const FVector& ViewPos, const FVector& ViewDir)
+{
+	const FVector ToAircraft = AircraftLocation - ViewPos;
+	const double DistSq = ToAircraft.SizeSquared();
+	const double WeaponsRange = CVarNetWeaponsRange.GetValueOnGameThread();
+	if (DistSq <= FMath::Square(WeaponsRange))
+	{
+		return CVarNetPriorityBoost.GetValueOnGameThread();
+	}
+
+	return IsInViewCone(ToAircraft, DistSq, ViewDir) ? CVarNetPriorityBoost.GetValueOnGameThread() : 1.f;
+}
+
+bool UFlightRelevancySubsystem::IsInViewCone(const FVector& ToAircraft, double DistSq, const FVector& ViewDir)
+{
+	// cos(angle) >= cos(cone)  <=>  dot >= |d| * cos(cone), no sqrt of the dot side needed
+	const double CosCone = FMath::Cos(FMath::DegreesToRadians(CVarNetViewConeDegrees.GetValueOnGameThread()));
+	const double Dot = FVector::DotProduct(ToAircraft, ViewDir);
+	return Dot > 0.0 && Dot * Dot >= DistSq * CosCone * CosCone;
+}
+
+void UFlightRelevancySubsystem::RegisterAircraft(AAAircraftBase* InAircraft)
+{
+	if (InAircraft)
+	{
+		Aircraft.AddUnique(InAircraft);
+		InAircraft->SetNetCullDistanceSquared(FMath::Square(GetCullDistance()));
+	}
+}
+
+void UFlightRelevancySubsystem::UnregisterAircraft(AAAircraftBase* InAircraft)
+{
+	Aircraft.RemoveSwap(InAircraft, EAllowShrinking::No);
+}
+
+void UFlightRelevancySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate < CVarNetRelevancyInterval.GetValueOnGameThread() || Aircraft.IsEmpty()) return;
+	TimeSinceUpdate = 0.f;
+
+	UpdateUpdateRates();
+}
+
+void UFlightRelevancySubsystem::UpdateUpdateRates()
+{
+	const double CellSize = FMath::Max(1000.f, CVarNetRelevancyCellSize.GetValueOnGameThread());
+	const double WeaponsRange = CVarNetWeaponsRange.GetValueOnGameThread();
+	const double FarDistance = FMath::Max<double>(CVarNetFarDistance.GetValueOnGameThread(), WeaponsRange + 1.0);
+	const float NearHz = CVarNetNearUpdateHz.GetValueOnGameThread();
+	const float FarHz = CVarNetFarUpdateHz.GetValueOnGameThread();
+
+	auto CellOf = [CellSize](const FVector& Location)
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+	};
+
+	// --- Bin aircraft ---
+	// Rebuilt from scratch so cells nobody occupies any more do not pile up in the map
+	Cells.Reset();
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		Cells.FindOrAdd(CellOf(Aircraft[i]->GetActorLocation())).Add(i);
+	}
+
+	// --- Closest pilot per aircraft: each viewpoint only visits the cells within FarDistance ---
+	ClosestViewerDistSq.Init(TNumericLimits<double>::Max(), Aircraft.Num());
+	bInViewCone.Init(false, Aircraft.Num());
+	const int32 CellRadius = FMath::CeilToInt32(FarDistance / CellSize);
+	const double CullDistSq = FMath::Square(GetCullDistance());
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PC = It->Get();
+		if (!PC) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		const FIntPoint ViewCell = CellOf(ViewLocation);
+
+		for (int32 Y = -CellRadius; Y <= CellRadius; ++Y)
+		{
+			for (int32 X = -CellRadius; X <= CellRadius; ++X)
+			{
+				const TArray<int32>* Cell = Cells.Find(ViewCell + FIntPoint(X, Y));
+				if (!Cell) continue;
+
+				for (const int32 Index : *Cell)
+				{
+					const double DistSq = FVector::DistSquared(ViewLocation, Aircraft[Index]->GetActorLocation());
+					ClosestViewerDistSq[Index] = FMath::Min(ClosestViewerDistSq[Index], DistSq);
+				}
+			}
+		}
+
+		// The cone reaches past the cells visited above, but it is one dot product per aircraft a few times a second
+		const FVector ViewDir = ViewRotation.Vector();
+		for (int32 i = 0; i < Aircraft.Num(); ++i)
+		{
+			if (bInViewCone[i]) continue;
+			const FVector ToAircraft = Aircraft[i]->GetActorLocation() - ViewLocation;
+			const double DistSq = ToAircraft.SizeSquared();
+			bInViewCone[i] = DistSq <= CullDistSq && IsInViewCone(ToAircraft, DistSq, ViewDir);
+		}
+	}
+
+	// --- Update rate from the closest pilot, full rate for anything a pilot is looking at ---
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		AAAircraftBase* Plane = Aircraft[i];
+		const double Distance = FMath::Sqrt(ClosestViewerDistSq[i]);
+		const float Alpha = static_cast<float>(FMath::Clamp((Distance - WeaponsRange) / (FarDistance - WeaponsRange), 0.0, 1.0));
+		const float Hz = bInViewCone[i] ? NearHz : FMath::Lerp(NearHz, FarHz, Alpha);
+
+		// Entering weapons range or a view cone should not wait for the slow rate to come round
+		if (Hz >= NearHz && Plane->GetNetUpdateFrequency() < NearHz)
+		{
+			Plane->ForceNetUpdate();
+		}
+		Plane->SetNetUpdateFrequency(Hz);
+		Plane->SetMinNetUpdateFrequency(FMath::Min(Hz, FarHz));
+	}
+}
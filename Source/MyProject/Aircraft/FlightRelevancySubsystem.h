@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlightRelevancySubsystem.generated.h"
+
+class AAAircraftBase;
+
+/**
+ * Server-side replication budget for aircraft. Aircraft are binned into a uniform grid over the map a few times
+ * per second; every pilot's viewpoint only visits the cells around it to find the aircraft near it.
+ * Aircraft near any pilot or inside any pilot's view cone replicate at full rate, the rest fall back to a trickle
+ * with distance, and the per-connection priority is boosted for aircraft inside that pilot's weapons range or view cone.
+ */
+UCLASS()
+class MYPROJECT_API UFlightRelevancySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterAircraft(AAAircraftBase* InAircraft);
+	void UnregisterAircraft(AAAircraftBase* InAircraft);
+
+	/** Per-connection priority multiplier: boosted inside weapons range or the viewer's view cone */
+	static float GetPriorityScale(const FVector& AircraftLocation, const FVector& ViewPos, const FVector& ViewDir);
+	/** Beyond this distance an aircraft is not relevant to a connection at all */
+	static float GetCullDistance();
+
+private:
+	void UpdateUpdateRates();
+	static bool IsInViewCone(const FVector& ToAircraft, double DistSq, const FVector& ViewDir);
+
+	UPROPERTY()
+	TArray<TObjectPtr<AAAircraftBase>> Aircraft;
+
+	/** Aircraft indices per occupied grid cell, rebuilt every update */
+	TMap<FIntPoint, TArray<int32>> Cells;
+	/** Squared distance from each aircraft to its closest pilot, rebuilt every update */
+	TArray<double> ClosestViewerDistSq;
+	/** Whether each aircraft is inside some pilot's view cone, rebuilt every update */
+	TArray<uint8> bInViewCone;
+
+	float TimeSinceUpdate = 0.f;
+};
@@ -0,0 +1,416 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightReplaySubsystem.h"
+
+#include "AAircraftBase.h"
+#include "FlightSimSubsystem.h"
+#include "FPVMovementComponent.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+static TAutoConsoleVariable<int32> CVarReplayFlushKB(
+	TEXT("ac.Replay.FlushKB"),
+	64,
+	TEXT("Recorded bytes (KB) buffered in memory before they are handed to the background writer."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarReplayTolerance(
+	TEXT("ac.Replay.Tolerance"),
+	1.f,
+	TEXT("Location (cm) and velocity (cm/s) error a re-simulated step may have before playback reports a divergence."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdReplayRecord(
+	TEXT("ac.Replay.Record"),
+	TEXT("ac.Replay.Record <Name=Match>: server only, records every simulated input frame to Saved/Replays/<Name>.flightreplay until ac.Replay.Stop."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UFlightReplaySubsystem* Replay = World ? World->GetSubsystem<UFlightReplaySubsystem>() : nullptr;
+		if (!Replay || World->GetNetMode() == NM_Client) return;
+
+		Replay->StartRecording(Args.Num() > 0 ? Args[0] : TEXT("Match"));
+	}));
+
+static FAutoConsoleCommandWithWorld CmdReplayStop(
+	TEXT("ac.Replay.Stop"),
+	TEXT("Finishes the recording started with ac.Replay.Record."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UFlightReplaySubsystem* Replay = World ? World->GetSubsystem<UFlightReplaySubsystem>() : nullptr)
+		{
+			Replay->StopRecording();
+		}
+	}));
+
+static FAutoConsoleCommand CmdReplayPlay(
+	TEXT("ac.Replay.Play"),
+	TEXT("ac.Replay.Play <Name=Match>: re-simulates Saved/Replays/<Name>.flightreplay headless and logs the first step that diverges."),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const FString Path = UFlightReplaySubsystem::GetReplayPath(Args.Num() > 0 ? Args[0] : TEXT("Match"));
+
+		FFlightReplayReport Report;
+		if (!UFlightReplaySubsystem::Play(Path, Report))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[Replay] Could not play %s"), *Path);
+			return;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("[Replay] %s: %d aircraft, %lld steps (%lld ground contacts, %lld clamps), %.1f s of flight re-simulated in %.2f ms (%.0fx real time)"),
+			*Path, Report.NumAircraft, Report.NumSteps, Report.NumGroundContacts, Report.NumClamps, Report.SimulatedSeconds,
+			Report.WallSeconds * 1000.0, Report.SimulatedSeconds / FMath::Max(Report.WallSeconds, UE_DOUBLE_SMALL_NUMBER));
+
+		if (Report.FirstDivergentStep == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Log, TEXT("[Replay] No divergence"));
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[Replay] First divergence at step %lld, aircraft %u: recorded %s, simulated %s"),
+				Report.FirstDivergentStep, Report.FirstDivergentAircraft, *Report.RecordedLocation.ToString(), *Report.SimulatedLocation.ToString());
+		}
+	}));
+
+// Recording layout: header, then a stream of records, each a type byte and a packed aircraft id.
+// Every helper below is used for both writing and reading, like the net serializers.
+namespace FlightReplayFormat
+{
+	constexpr uint32 Magic = 0x50524C46; // "FLRP"
+	constexpr uint32 Version = 2;
+
+	enum ERecordType : uint8
+	{
+		// Configs and full-precision state, when an aircraft appears or was moved outside the flight model
+		Spawn       = 0,
+		Environment = 1,
+		// One input frame and the (float precision) state the flight model integrated from it
+		Step        = 2,
+		// Server rules applied on top of the step (EPostStep flags) and the full-precision state they left
+		PostStep    = 3,
+	};
+
+	enum EPostStep : uint8
+	{
+		GroundContact = 1 << 0,
+		Clamped       = 1 << 1,
+	};
+
+	struct FHeader
+	{
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		int32 Seed = 0;
+		float StepSeconds = 0.f;
+		uint8 Integrator = 0;
+	};
+
+	static void SerializeHeader(FArchive& Ar, FHeader& Header)
+	{
+		Ar << Header.Magic << Header.Version << Header.Seed << Header.StepSeconds << Header.Integrator;
+	}
+
+	static void SerializeSpawn(FArchive& Ar, EFlightType& FlightType, FAircraftConfig& AircraftConfig, FDroneConfig& DroneConfig, FFlightBodyState& Body)
+	{
+		uint8 Type = static_cast<uint8>(FlightType);
+		Ar << Type;
+		FlightType = static_cast<EFlightType>(Type);
+
+		// Tagged, so recordings survive config fields being added. Asset references (aero tables) go by path
+		FObjectAndNameAsStringProxyArchive ConfigAr(Ar, true);
+		FAircraftConfig::StaticStruct()->SerializeItem(ConfigAr, &AircraftConfig, nullptr);
+		FDroneConfig::StaticStruct()->SerializeItem(ConfigAr, &DroneConfig, nullptr);
+
+		Ar << Body;
+	}
+
+	static void SerializeEnvironment(FArchive& Ar, FFlightEnvironment& Environment)
+	{
+		Ar << Environment.Wind << Environment.Updraft << Environment.Turbulence;
+	}
+
+	static void SerializeStep(FArchive& Ar, FFlightInputFrame& Frame, FVector3f& Location, FQuat4f& Rotation, FVector3f& LinearVelocity)
+	{
+		Ar << Frame.Thrust << Frame.SteeringX << Frame.SteeringY << Frame.Yaw;
+		Ar << Location << Rotation << LinearVelocity;
+	}
+
+	static void SerializePostStep(FArchive& Ar, uint8& Flags, FFlightBodyState& Body)
+	{
+		Ar << Flags << Body;
+	}
+
+	static bool IsSameEnvironment(const FFlightEnvironment& A, const FFlightEnvironment& B)
+	{
+		return A.Wind == B.Wind && A.Updraft == B.Updraft && A.Turbulence == B.Turbulence;
+	}
+
+	static bool IsSameBody(const FFlightBodyState& A, const FFlightBodyState& B)
+	{
+		return A.Location.Equals(B.Location, UE_KINDA_SMALL_NUMBER) && A.Rotation.Equals(B.Rotation, UE_KINDA_SMALL_NUMBER)
+			&& A.LinearVelocity.Equals(B.LinearVelocity, UE_KINDA_SMALL_NUMBER);
+	}
+}
+
+bool UFlightReplaySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFlightReplaySubsystem::Deinitialize()
+{
+	StopRecording();
+
+	Super::Deinitialize();
+}
+
+FString UFlightReplaySubsystem::GetReplayPath(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("Replays") / Name + TEXT(".flightreplay");
+}
+
+bool UFlightReplaySubsystem::StartRecording(const FString& Name)
+{
+	using namespace FlightReplayFormat;
+
+	StopRecording();
+
+	const FString Path = GetReplayPath(Name);
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*Path));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[Replay] Could not open %s for writing"), *Path);
+		return false;
+	}
+
+	// Reseed so anything random in the match can be reproduced from the header
+	FHeader Header;
+	Header.Magic = FlightReplayFormat::Magic;
+	Header.Version = FlightReplayFormat::Version;
+	Header.Seed = static_cast<int32>(FPlatformTime::Cycles());
+	Header.StepSeconds = UFPVMovementComponent::GetNetStepSeconds();
+	Header.Integrator = static_cast<uint8>(UFlightSimSubsystem::GetIntegrator());
+	FMath::RandInit(Header.Seed);
+	FMath::SRandInit(Header.Seed);
+
+	FMemoryWriter Ar(Buffer, false, true);
+	SerializeHeader(Ar, Header);
+
+	UE_LOG(LogTemp, Log, TEXT("[Replay] Recording to %s (seed %d)"), *Path, Header.Seed);
+	return true;
+}
+
+void UFlightReplaySubsystem::StopRecording()
+{
+	if (!Writer) return;
+
+	Flush();
+	LastWrite.Wait();
+	Writer->Close();
+	Writer.Reset();
+
+	Recorded.Reset();
+	NextAircraftId = 1;
+}
+
+void UFlightReplaySubsystem::Flush()
+{
+	if (Buffer.IsEmpty()) return;
+
+	// Tasks launched into one pipe never overlap, so chunks land in the file in order
+	LastWrite = WritePipe.Launch(TEXT("FlightReplayWrite"), [Ar = Writer.Get(), Chunk = MoveTemp(Buffer)]() mutable
+	{
+		Ar->Serialize(Chunk.GetData(), Chunk.Num());
+	});
+	Buffer.Reset();
+}
+
+void UFlightReplaySubsystem::RecordStep(const AAAircraftBase* InAircraft, const FFlightBodyState& PreviousBody, const FFlightInputFrame& Frame)
+{
+	using namespace FlightReplayFormat;
+
+	if (!Writer || !InAircraft) return;
+
+	FMemoryWriter Ar(Buffer, false, true);
+
+	FRecordedAircraft* Entry = Recorded.Find(InAircraft);
+	if (!Entry || !IsSameBody(Entry->LastBody, PreviousBody))
+	{
+		if (!Entry)
+		{
+			Entry = &Recorded.Add(InAircraft);
+			Entry->Id = NextAircraftId++;
+			// Forces an environment record below
+			Entry->LastEnvironment.Updraft = UE_BIG_NUMBER;
+		}
+
+		uint8 Type = Spawn;
+		// Configs go in by value so a recording still plays after its airframe asset was retuned
+		const UAirframeAsset& Airframe = InAircraft->GetAirframe();
+		EFlightType FlightType = Airframe.FlightType;
+		FAircraftConfig AircraftConfig = Airframe.Aircraft;
+		FDroneConfig DroneConfig = Airframe.Drone;
+		FFlightBodyState Body = PreviousBody;
+		Ar << Type;
+		Ar.SerializeIntPacked(Entry->Id);
+		SerializeSpawn(Ar, FlightType, AircraftConfig, DroneConfig, Body);
+	}
+
+	FFlightEnvironment Environment = InAircraft->GetFlightEnvironment();
+	if (!IsSameEnvironment(Entry->LastEnvironment, Environment))
+	{
+		uint8 Type = FlightReplayFormat::Environment;
+		Ar << Type;
+		Ar.SerializeIntPacked(Entry->Id);
+		SerializeEnvironment(Ar, Environment);
+		Entry->LastEnvironment = Environment;
+	}
+
+	// The step record holds what the flight model alone produced, so playback compares like with like
+	const UFPVMovementComponent* MoveComp = InAircraft->MoveComp;
+	const FFlightBodyState Integrated = MoveComp->GetIntegratedBodyState();
+	{
+		uint8 Type = Step;
+		FFlightInputFrame Input = Frame;
+		FVector3f Location(Integrated.Location);
+		FQuat4f Rotation(Integrated.Rotation);
+		FVector3f LinearVelocity(Integrated.LinearVelocity);
+		Ar << Type;
+		Ar.SerializeIntPacked(Entry->Id);
+		SerializeStep(Ar, Input, Location, Rotation, LinearVelocity);
+	}
+
+	// Ground contact and plausibility clamps need the world or the server's limits, playback takes their result as given
+	Entry->LastBody = MoveComp->GetBodyState();
+	uint8 PostStepFlags = 0;
+	PostStepFlags |= MoveComp->HadGroundContact() ? GroundContact : 0;
+	PostStepFlags |= MoveComp->WasClamped() ? Clamped : 0;
+	if (PostStepFlags != 0)
+	{
+		uint8 Type = PostStep;
+		FFlightBodyState Body = Entry->LastBody;
+		Ar << Type;
+		Ar.SerializeIntPacked(Entry->Id);
+		SerializePostStep(Ar, PostStepFlags, Body);
+	}
+
+	if (Buffer.Num() >= CVarReplayFlushKB.GetValueOnGameThread() * 1024)
+	{
+		Flush();
+	}
+}
+
+bool UFlightReplaySubsystem::Play(const FString& Path, FFlightReplayReport& OutReport)
+{
+	using namespace FlightReplayFormat;
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Path)) return false;
+
+	FMemoryReader Ar(Data);
+	FHeader Header;
+	SerializeHeader(Ar, Header);
+	if (Ar.IsError() || Header.Magic != FlightReplayFormat::Magic || Header.Version != FlightReplayFormat::Version) return false;
+
+	FMath::RandInit(Header.Seed);
+	FMath::SRandInit(Header.Seed);
+	const EFlightIntegrator Integrator = static_cast<EFlightIntegrator>(Header.Integrator);
+	const double Tolerance = CVarReplayTolerance.GetValueOnAnyThread();
+
+	struct FPlaybackAircraft
+	{
+		EFlightType FlightType = EFlightType::Aircraft;
+		FAircraftConfig AircraftConfig;
+		FDroneConfig DroneConfig;
+		FFlightEnvironment Environment;
+		FFlightBodyState Body;
+	};
+	TMap<uint32, FPlaybackAircraft> Aircraft;
+
+	OutReport = FFlightReplayReport();
+	const double StartTime = FPlatformTime::Seconds();
+
+	while (!Ar.AtEnd())
+	{
+		uint8 Type = 0;
+		uint32 Id = 0;
+		Ar << Type;
+		Ar.SerializeIntPacked(Id);
+
+		switch (Type)
+		{
+			case Spawn:
+			{
+				FPlaybackAircraft& Plane = Aircraft.FindOrAdd(Id);
+				SerializeSpawn(Ar, Plane.FlightType, Plane.AircraftConfig, Plane.DroneConfig, Plane.Body);
+				break;
+			}
+			case FlightReplayFormat::Environment:
+			{
+				FFlightEnvironment Environment;
+				SerializeEnvironment(Ar, Environment);
+				if (FPlaybackAircraft* Plane = Aircraft.Find(Id))
+				{
+					Plane->Environment = Environment;
+				}
+				break;
+			}
+			case Step:
+			{
+				FFlightInputFrame Frame;
+				FVector3f Location;
+				FQuat4f Rotation;
+				FVector3f LinearVelocity;
+				SerializeStep(Ar, Frame, Location, Rotation, LinearVelocity);
+
+				FPlaybackAircraft* Plane = Aircraft.Find(Id);
+				if (!Plane) return false;
+
+				const FFlightModel Model{ Plane->FlightType, Plane->AircraftConfig, Plane->DroneConfig };
+				FFlightDynamics::Step(Model, Frame.GetControls(), Plane->Environment, Integrator, Header.StepSeconds, Plane->Body);
+
+				const bool bDiverged = !Plane->Body.Location.Equals(FVector(Location), Tolerance)
+					|| !Plane->Body.LinearVelocity.Equals(FVector(LinearVelocity), Tolerance)
+					|| !Plane->Body.Rotation.Equals(FQuat(Rotation), 1.e-3);
+
+				if (bDiverged && OutReport.FirstDivergentStep == INDEX_NONE)
+				{
+					OutReport.FirstDivergentStep = OutReport.NumSteps;
+					OutReport.FirstDivergentAircraft = Id;
+					OutReport.RecordedLocation = FVector(Location);
+					OutReport.SimulatedLocation = Plane->Body.Location;
+				}
+				++OutReport.NumSteps;
+				break;
+			}
+			case PostStep:
+			{
+				uint8 Flags = 0;
+				FFlightBodyState Body;
+				SerializePostStep(Ar, Flags, Body);
+
+				FPlaybackAircraft* Plane = Aircraft.Find(Id);
+				if (!Plane) return false;
+
+				Plane->Body = Body;
+				OutReport.NumGroundContacts += (Flags & GroundContact) != 0;
+				OutReport.NumClamps += (Flags & Clamped) != 0;
+				break;
+			}
+			default:
+				return false;
+		}
+
+		if (Ar.IsError()) return false;
+	}
+
+	OutReport.WallSeconds = FPlatformTime::Seconds() - StartTime;
+	OutReport.NumAircraft = Aircraft.Num();
+	OutReport.SimulatedSeconds = OutReport.NumSteps * Header.StepSeconds;
+	return true;
+}
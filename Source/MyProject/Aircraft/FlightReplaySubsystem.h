@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Pipe.h"
+#include "UObject/ObjectKey.h"
+#include "FlightDynamics.h"
+#include "FlightReplaySubsystem.generated.h"
+
+class AAAircraftBase;
+struct FFlightInputFrame;
+
+/** Outcome of re-simulating a recording */
+struct FFlightReplayReport
+{
+	int32 NumAircraft = 0;
+	int64 NumSteps = 0;
+	/** Flight time the recording covers, summed over aircraft, against the wall time the playback took */
+	double SimulatedSeconds = 0.0;
+	double WallSeconds = 0.0;
+	/** Steps the server's ground contact or plausibility clamp moved after the flight model, taken from the recording */
+	int64 NumGroundContacts = 0;
+	int64 NumClamps = 0;
+
+	/** First step record whose re-simulated state left ac.Replay.Tolerance, INDEX_NONE when the whole match reproduced */
+	int64 FirstDivergentStep = INDEX_NONE;
+	uint32 FirstDivergentAircraft = 0;
+	FVector RecordedLocation = FVector::ZeroVector;
+	FVector SimulatedLocation = FVector::ZeroVector;
+};
+
+/**
+ * Server-side match recorder. Every input frame Server_SendInputs simulates is written together with the state it
+ * produced; an aircraft's full state and configs are written when it first shows up or was moved outside the flight
+ * model, and its environment whenever that changes. Records are appended to a memory buffer that is handed to a
+ * background pipe every ac.Replay.FlushKB, so the game thread never waits on the file.
+ *
+ * Playback needs no world: every aircraft is re-stepped through FFlightDynamics as fast as the CPU allows and compared
+ * against the state the flight model produced on the server, reporting the first step that diverges. Ground contact and
+ * plausibility clamps are recorded as their own records and applied from the recording, so a divergence is always a
+ * flight model desync.
+ */
+UCLASS()
+class MYPROJECT_API UFlightReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+
+	bool StartRecording(const FString& Name);
+	void StopRecording();
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	/** After the server simulated Frame for InAircraft. PreviousBody is the state the step started from */
+	void RecordStep(const AAAircraftBase* InAircraft, const FFlightBodyState& PreviousBody, const FFlightInputFrame& Frame);
+
+	static FString GetReplayPath(const FString& Name);
+	/** Re-simulates a recording headless. False when the file is missing or malformed */
+	static bool Play(const FString& Path, FFlightReplayReport& OutReport);
+
+private:
+	struct FRecordedAircraft
+	{
+		uint32 Id = 0;
+		FFlightBodyState LastBody;
+		FFlightEnvironment LastEnvironment;
+	};
+
+	void Flush();
+
+	TMap<TObjectKey<AAAircraftBase>, FRecordedAircraft> Recorded;
+	uint32 NextAircraftId = 1;
+
+	/** Records not yet handed to the pipe */
+	TArray<uint8> Buffer;
+	TUniquePtr<FArchive> Writer;
+	/** Runs the file writes one after another, off the game thread */
+	UE::Tasks::FPipe WritePipe{ TEXT("FlightReplayWrite") };
+	UE::Tasks::FTask LastWrite;
+};
@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightSimSubsystem.h"
+
+#include "AAircraftBase.h"
+#include "AirflowFieldSubsystem.h"
+#include "FlightForceKernel.h"
+#include "FlightRecorder.h"
+#include "FlightStats.h"
+#include "TerrainHeightfieldSubsystem.h"
+#include "FPVMovementComponent.h"
+#include "Async/ParallelFor.h"
+
+static TAutoConsoleVariable<bool> CVarFlightBatched(
+	TEXT("ac.Flight.Batched"),
+	true,
+	TEXT("When true, aircraft spawned afterwards are simulated by UFlightSimSubsystem in one batched pass instead of ticking individually."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarFlightParallel(
+	TEXT("ac.Flight.Parallel"),
+	true,
+	TEXT("Integrate batched aircraft across worker threads. Results are identical to the single-threaded pass."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFlightParallelBatchSize(
+	TEXT("ac.Flight.ParallelBatchSize"),
+	32,
+	TEXT("Minimum number of aircraft handed to one worker. Below this count the batch runs on the game thread."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarFlightFixedStepHz(
+	TEXT("ac.Flight.FixedStepHz"),
+	60.f,
+	TEXT("Rate of the fixed flight simulation clock. 0 integrates once per frame with the variable frame time."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFlightMaxSubsteps(
+	TEXT("ac.Flight.MaxSubsteps"),
+	8,
+	TEXT("Maximum fixed steps run in one frame. Time beyond this is dropped so hitches do not spiral."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarFlightIntegrator(
+	TEXT("ac.Flight.Integrator"),
+	0,
+	TEXT("0: semi-implicit Euler, 1: RK2 midpoint."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarFlightInterpolate(
+	TEXT("ac.Flight.Interpolate"),
+	true,
+	TEXT("Interpolate the rendered aircraft transform between the last two fixed steps."),
+	ECVF_Default);
+
+bool UFlightSimSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFlightSimSubsystem::Deinitialize()
+{
+	Aircraft.Reset();
+	bSimulated.Reset();
+	Airframes.Reset();
+	Controls.Reset();
+	LocalAirflows.Reset();
+	Environments.Reset();
+	Turbulences.Reset();
+	FieldTimes.Reset();
+	Recorders.Reset();
+	Airflow = nullptr;
+	Terrain = nullptr;
+	Locations.Reset();
+	Rotations.Reset();
+	LinearVelocities.Reset();
+	AngularVelocities.Reset();
+	ControlAngularVelocities.Reset();
+	PreviousLocations.Reset();
+	PreviousRotations.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId UFlightSimSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlightSimSubsystem, STATGROUP_Tickables);
+}
+
+bool UFlightSimSubsystem::IsBatchedSimulationEnabled()
+{
+	return CVarFlightBatched.GetValueOnGameThread();
+}
+
+float UFlightSimSubsystem::GetFixedStepSeconds()
+{
+	const float Hz = CVarFlightFixedStepHz.GetValueOnGameThread();
+	return Hz > 0.f ? 1.f / Hz : 0.f;
+}
+
+int32 UFlightSimSubsystem::GetMaxSubsteps()
+{
+	return FMath::Max(1, CVarFlightMaxSubsteps.GetValueOnGameThread());
+}
+
+EFlightIntegrator UFlightSimSubsystem::GetIntegrator()
+{
+	return CVarFlightIntegrator.GetValueOnGameThread() == 1 ? EFlightIntegrator::Midpoint : EFlightIntegrator::SemiImplicitEuler;
+}
+
+void UFlightSimSubsystem::RegisterAircraft(AAAircraftBase* InAircraft)
+{
+	check(InAircraft && InAircraft->MoveComp);
+	if (InAircraft->FlightSimIndex != INDEX_NONE) return;
+
+	InAircraft->FlightSimIndex = Aircraft.Add(InAircraft);
+
+	bSimulated.Add(false);
+	Airframes.Add(&InAircraft->GetAirframe());
+	Controls.AddDefaulted();
+	LocalAirflows.AddDefaulted();
+	Environments.Add(InAircraft->StepEnvironment);
+	Turbulences.Add(InAircraft->LastTurbulence);
+	FieldTimes.Add(InAircraft->StepFieldTime);
+	Recorders.Add(InAircraft->MoveComp->GetRecorder().Get());
+
+	const FFlightBodyState Body = InAircraft->MoveComp->GetBodyState();
+	Locations.Add(InAircraft->GetActorLocation());
+	Rotations.Add(Body.Rotation);
+	LinearVelocities.Add(Body.LinearVelocity);
+	AngularVelocities.Add(Body.AngularVelocity);
+	ControlAngularVelocities.Add(Body.ControlAngularVelocity);
+	PreviousLocations.Add(Locations.Last());
+	PreviousRotations.Add(Body.Rotation);
+}
+
+void UFlightSimSubsystem::UnregisterAircraft(AAAircraftBase* InAircraft)
+{
+	if (!InAircraft || !Aircraft.IsValidIndex(InAircraft->FlightSimIndex)) return;
+	check(Aircraft[InAircraft->FlightSimIndex] == InAircraft);
+
+	RemoveAtSwap(InAircraft->FlightSimIndex);
+	InAircraft->FlightSimIndex = INDEX_NONE;
+}
+
+void UFlightSimSubsystem::RemoveAtSwap(int32 Index)
+{
+	Aircraft.RemoveAtSwap(Index, EAllowShrinking::No);
+	bSimulated.RemoveAtSwap(Index, EAllowShrinking::No);
+	Airframes.RemoveAtSwap(Index, EAllowShrinking::No);
+	Controls.RemoveAtSwap(Index, EAllowShrinking::No);
+	LocalAirflows.RemoveAtSwap(Index, EAllowShrinking::No);
+	Environments.RemoveAtSwap(Index, EAllowShrinking::No);
+	Turbulences.RemoveAtSwap(Index, EAllowShrinking::No);
+	FieldTimes.RemoveAtSwap(Index, EAllowShrinking::No);
+	Recorders.RemoveAtSwap(Index, EAllowShrinking::No);
+	Locations.RemoveAtSwap(Index, EAllowShrinking::No);
+	Rotations.RemoveAtSwap(Index, EAllowShrinking::No);
+	LinearVelocities.RemoveAtSwap(Index, EAllowShrinking::No);
+	AngularVelocities.RemoveAtSwap(Index, EAllowShrinking::No);
+	ControlAngularVelocities.RemoveAtSwap(Index, EAllowShrinking::No);
+	PreviousLocations.RemoveAtSwap(Index, EAllowShrinking::No);
+	PreviousRotations.RemoveAtSwap(Index, EAllowShrinking::No);
+
+	// The last aircraft was moved into the freed slot
+	if (Aircraft.IsValidIndex(Index))
+	{
+		Aircraft[Index]->FlightSimIndex = Index;
+	}
+}
+
+void UFlightSimSubsystem::SyncFromActor(AAAircraftBase* InAircraft)
+{
+	if (!InAircraft || !Aircraft.IsValidIndex(InAircraft->FlightSimIndex)) return;
+
+	PullActorState(InAircraft->FlightSimIndex);
+}
+
+void UFlightSimSubsystem::PullActorState(int32 Index)
+{
+	const AAAircraftBase* Plane = Aircraft[Index];
+	FFlightBodyState Body = Plane->MoveComp->GetBodyState();
+	Body.Location = PreviousLocations[Index] = Plane->GetActorLocation();
+	Body.Rotation = PreviousRotations[Index] = Plane->GetActorQuat();
+	SetBodyState(Index, Body);
+}
+
+FFlightBodyState UFlightSimSubsystem::GetBodyState(int32 Index) const
+{
+	FFlightBodyState Body;
+	Body.Location               = Locations[Index];
+	Body.Rotation               = Rotations[Index];
+	Body.LinearVelocity         = LinearVelocities[Index];
+	Body.AngularVelocity        = AngularVelocities[Index];
+	Body.ControlAngularVelocity = ControlAngularVelocities[Index];
+	return Body;
+}
+
+void UFlightSimSubsystem::SetBodyState(int32 Index, const FFlightBodyState& Body)
+{
+	Locations[Index]                = Body.Location;
+	Rotations[Index]                = Body.Rotation;
+	LinearVelocities[Index]         = Body.LinearVelocity;
+	AngularVelocities[Index]        = Body.AngularVelocity;
+	ControlAngularVelocities[Index] = Body.ControlAngularVelocity;
+}
+
+void UFlightSimSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	FlightStats::Tick();
+	if (Aircraft.IsEmpty()) return;
+
+	FLIGHT_SCOPE(Flight, BatchedTick);
+
+	const float StepSeconds = GetFixedStepSeconds();
+	const int32 NumSteps = Clock.Advance(DeltaTime, StepSeconds, GetMaxSubsteps());
+	const float StepDeltaTime = StepSeconds > 0.f ? StepSeconds : DeltaTime;
+	Integrator = GetIntegrator();
+	Airflow = GetWorld()->GetSubsystem<UAirflowFieldSubsystem>();
+	Terrain = GetWorld()->GetSubsystem<UTerrainHeightfieldSubsystem>();
+
+	GatherInputs();
+#if FLIGHT_PROFILING
+	// Remote players' aircraft are counted by their own steps in UFPVMovementComponent::ApplyPhysicsStep
+	int32 NumSimulated = 0;
+	for (const uint8 bSlotSimulated : bSimulated)
+	{
+		NumSimulated += bSlotSimulated;
+	}
+	SET_DWORD_STAT(STAT_FlightAircraftSimulated, NumSimulated);
+	CSV_CUSTOM_STAT(Flight, AircraftSimulated, NumSimulated, ECsvCustomStatOp::Set);
+	FLIGHT_COUNT(Flight, Steps, NumSimulated * NumSteps);
+#endif
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		StepWorldTime = GetWorld()->GetTimeSeconds() - (NumSteps - 1 - Step) * StepDeltaTime;
+		UpdatePilots(StepDeltaTime);
+		Simulate(StepDeltaTime);
+	}
+	ScatterTransforms(CVarFlightInterpolate.GetValueOnGameThread() ? Clock.GetAlpha(StepSeconds) : 1.f);
+}
+
+void UFlightSimSubsystem::GatherInputs()
+{
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		const AAAircraftBase* Plane = Aircraft[i];
+
+		// Remote players' aircraft are stepped by their input frames; keep the slot current for when that stops
+		bSimulated[i] = !Plane->MoveComp->IsDrivenByRemoteInputs();
+		if (!bSimulated[i])
+		{
+			PullActorState(i);
+			continue;
+		}
+
+		Airframes[i]    = &Plane->GetAirframe();
+		Controls[i]     = Plane->GetFlightControls();
+		LocalAirflows[i] = Plane->EnvAirflow;
+		FieldTimes[i]   = Plane->StepFieldTime;
+		Recorders[i]    = Plane->MoveComp->GetRecorder().Get();
+	}
+}
+
+void UFlightSimSubsystem::UpdatePilots(float DeltaTime)
+{
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		if (!bSimulated[i]) continue;
+
+		AAAircraftBase* Plane = Aircraft[i];
+		Plane->SamplePilotInput();
+		Plane->PreFlightStep({ Locations[i], Rotations[i], LinearVelocities[i] }, DeltaTime);
+
+		Controls[i] = Plane->GetFlightControls();
+	}
+}
+
+void UFlightSimSubsystem::Simulate(float DeltaTime)
+{
+	FLIGHT_SCOPE(Flight, BatchedSimulate);
+
+	// Every aircraft only reads and writes its own slot, so the work splits across threads without locks
+	// and each slot sees exactly the same instruction sequence as on the game thread.
+	const int32 NumBatches = FMath::DivideAndRoundUp(Aircraft.Num(), FFlightForceBatch::Lanes);
+	const int32 BatchSize = FMath::Max(1, CVarFlightParallelBatchSize.GetValueOnGameThread() / FFlightForceBatch::Lanes);
+
+	if (CVarFlightParallel.GetValueOnGameThread() && NumBatches > BatchSize)
+	{
+		ParallelFor(TEXT("FlightSim.Simulate"), NumBatches, BatchSize, [this, DeltaTime](int32 Batch)
+		{
+			SimulateBatch(Batch, DeltaTime);
+		});
+	}
+	else
+	{
+		for (int32 Batch = 0; Batch < NumBatches; ++Batch)
+		{
+			SimulateBatch(Batch, DeltaTime);
+		}
+	}
+}
+
+void UFlightSimSubsystem::SimulateBatch(int32 Batch, float DeltaTime)
+{
+	const int32 FirstIndex = Batch * FFlightForceBatch::Lanes;
+	const int32 LastIndex = FMath::Min(FirstIndex + FFlightForceBatch::Lanes, Aircraft.Num());
+
+	// Field lookups are read-only, so the airflow is sampled inside the parallel batch too
+	for (int32 Index = FirstIndex; Index < LastIndex; ++Index)
+	{
+		if (!bSimulated[Index]) continue;
+
+		FVector& Turbulence = Turbulences[Index];
+		Turbulence = FVector::ZeroVector;
+		Environments[Index] = Airflow
+			? Airflow->SampleEnvironment(LocalAirflows[Index], Locations[Index], FieldTimes[Index], Turbulence)
+			: FFlightEnvironment::Make(LocalAirflows[Index], Turbulence);
+		FieldTimes[Index] += DeltaTime;
+	}
+
+	FFlightForceBatch Forces;
+	FillForceBatch(FirstIndex, Forces);
+	// Recorded lanes get the forces by source out of the same kernel pass
+	for (int32 Index = FirstIndex; Index < LastIndex && !Forces.bOutputForces; ++Index)
+	{
+		Forces.bOutputForces = bSimulated[Index] && Recorders[Index];
+	}
+	FFlightForceKernel::Compute(Forces);
+
+	for (int32 Lane = 0; Lane < FFlightForceBatch::Lanes; ++Lane)
+	{
+		const int32 Index = FirstIndex + Lane;
+		if (Index >= Aircraft.Num()) break;
+		if (!bSimulated[Index]) continue;
+
+		const FVector LinearAccel(Forces.AccelX[Lane], Forces.AccelY[Lane], Forces.AccelZ[Lane]);
+		const bool bStalled = (Forces.StallMask & (1u << Lane)) != 0;
+
+		FFlightBodyState Body = GetBodyState(Index);
+		PreviousLocations[Index] = Body.Location;
+		PreviousRotations[Index] = Body.Rotation;
+
+		// Each slot's recorder has this worker as its only writer
+		FFlightRecorder* Recorder = Recorders[Index];
+		FFlightForces RecordedForces = Recorder ? Forces.GetLaneForces(Lane) : FFlightForces();
+
+		const FVector AngularVel = FFlightDynamics::UpdateControlAngularVelocity(GetFlightModel(Index), Controls[Index], bStalled, DeltaTime, Body,
+			RecordedForces.StallTorque);
+		FFlightDynamics::Integrate(Integrator, DeltaTime, LinearAccel, AngularVel, Body);
+		if (Terrain)
+		{
+			Terrain->ResolveGroundContact(Body);
+		}
+		SetBodyState(Index, Body);
+
+		if (Recorder)
+		{
+			Recorder->RecordStep(StepWorldTime, 0, Controls[Index], RecordedForces, bStalled, Body);
+		}
+	}
+}
+
+// Game thread only: one pass over the actors once every slot has finished integrating.
+// The actor is drawn Alpha of the way between the last two steps, replication always gets the latest step.
+void UFlightSimSubsystem::ScatterTransforms(float Alpha)
+{
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		if (!bSimulated[i]) continue;
+
+		const FFlightBodyState Body = GetBodyState(i);
+		const FVector RenderLocation = FMath::Lerp(PreviousLocations[i], Body.Location, Alpha);
+		const FQuat RenderRotation   = FQuat::Slerp(PreviousRotations[i], Body.Rotation, Alpha);
+
+		AAAircraftBase* Plane = Aircraft[i];
+		Plane->MoveComp->ApplySimulatedState(Body, RenderLocation, RenderRotation);
+		Plane->ReportInputToMotion();
+		// What the aircraft would have kept had it stepped itself, for the recorder, replays and the per-actor path
+		Plane->StepEnvironment = Environments[i];
+		Plane->LastTurbulence  = Turbulences[i];
+		Plane->StepFieldTime   = FieldTimes[i];
+	}
+}
+
+void UFlightSimSubsystem::FillForceBatch(int32 FirstIndex, FFlightForceBatch& Batch) const
+{
+	for (int32 Lane = 0; Lane < FFlightForceBatch::Lanes; ++Lane)
+	{
+		const int32 Index = FirstIndex + Lane;
+		if (Index >= Aircraft.Num() || !bSimulated[Index])
+		{
+			Batch.ClearLane(Lane);
+			continue;
+		}
+
+		Batch.SetLane(Lane, GetFlightModel(Index), GetBodyState(Index), Controls[Index], Environments[Index]);
+	}
+}
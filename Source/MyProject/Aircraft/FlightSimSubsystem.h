@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MyProject/GCore/Config.h"
+#include "FlightDynamics.h"
+#include "FlightSimSubsystem.generated.h"
+
+class AAAircraftBase;
+class UAirflowFieldSubsystem;
+class UTerrainHeightfieldSubsystem;
+class FFlightRecorder;
+struct FFlightForceBatch;
+
+/**
+ * Owns the flight state of every registered aircraft and advances all of them in one batched pass per frame.
+ * State is kept in flat per-slot arrays so the simulate pass walks contiguous memory instead of chasing
+ * actor and component pointers. Actors only feed inputs in (gather) and receive transforms back (scatter).
+ * The linear forces go through the lane-batched FFlightForceKernel, everything else through FFlightDynamics.
+ */
+UCLASS()
+class MYPROJECT_API UFlightSimSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Whether newly spawned aircraft should hand their flight over to this subsystem (ac.Flight.Batched) */
+	static bool IsBatchedSimulationEnabled();
+
+	/** Length of one fixed flight step (ac.Flight.FixedStepHz), 0 when the clock follows the frame time */
+	static float GetFixedStepSeconds();
+	static int32 GetMaxSubsteps();
+	static EFlightIntegrator GetIntegrator();
+
+	void RegisterAircraft(AAAircraftBase* InAircraft);
+	void UnregisterAircraft(AAAircraftBase* InAircraft);
+
+	/** Pulls the actor transform back into the batch after something outside the simulation moved the aircraft */
+	void SyncFromActor(AAAircraftBase* InAircraft);
+
+	int32 GetNumAircraft() const { return Aircraft.Num(); }
+
+private:
+	void GatherInputs();
+	// Lets pilots (AI) set new inputs from the current simulated state before each step
+	void UpdatePilots(float DeltaTime);
+	void Simulate(float DeltaTime);
+	void SimulateBatch(int32 Batch, float DeltaTime);
+	void ScatterTransforms(float Alpha);
+
+	void FillForceBatch(int32 FirstIndex, FFlightForceBatch& Batch) const;
+	FFlightModel GetFlightModel(int32 Index) const { return FFlightModel(*Airframes[Index]); }
+	// FFlightDynamics works on one body at a time: gather a slot into it and scatter the result back
+	FFlightBodyState GetBodyState(int32 Index) const;
+	void SetBodyState(int32 Index, const FFlightBodyState& Body);
+
+	void RemoveAtSwap(int32 Index);
+	void PullActorState(int32 Index);
+
+	FFlightFixedClock Clock;
+	EFlightIntegrator Integrator = EFlightIntegrator::SemiImplicitEuler;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AAAircraftBase>> Aircraft;
+
+	// --- Per-frame inputs (gathered) ---
+	TArray<uint8> bSimulated;
+	/** Owned by the asset manager (or the class default for aircraft without one), never null */
+	TArray<const UAirframeAsset*> Airframes;
+	TArray<FFlightControls> Controls;
+	TArray<FEnvAirflow> LocalAirflows;
+	/** Local airflow plus the field, sampled for every aircraft at the start of each step */
+	TArray<FFlightEnvironment> Environments;
+	/** Raw turbulence noise of each slot's last step */
+	TArray<FVector> Turbulences;
+	/** Field time each slot's next step samples at, counted in steps from the aircraft's own field clock */
+	TArray<double> FieldTimes;
+
+	UPROPERTY()
+	TObjectPtr<UAirflowFieldSubsystem> Airflow;
+	UPROPERTY()
+	TObjectPtr<UTerrainHeightfieldSubsystem> Terrain;
+	/** Owned by each aircraft's movement component, null when it records nothing */
+	TArray<FFlightRecorder*> Recorders;
+	/** World time the step being simulated ends at, stamped on recorder entries */
+	double StepWorldTime = 0.0;
+
+	// --- Flight state (owned here) ---
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+	TArray<FVector> LinearVelocities;
+	TArray<FVector> AngularVelocities;
+	TArray<FVector> ControlAngularVelocities;
+	/** Transform before the last step, for render interpolation */
+	TArray<FVector> PreviousLocations;
+	TArray<FQuat> PreviousRotations;
+};
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightStats.h"
+
+DEFINE_STAT(STAT_FlightCalculateAerialPhysics);
+DEFINE_STAT(STAT_FlightApplyPhysicsStep);
+DEFINE_STAT(STAT_FlightCommitMove);
+DEFINE_STAT(STAT_FlightBatchedTick);
+DEFINE_STAT(STAT_FlightBatchedSimulate);
+DEFINE_STAT(STAT_FlightAircraftSimulated);
+DEFINE_STAT(STAT_FlightSteps);
+DEFINE_STAT(STAT_FlightPilotInput);
+DEFINE_STAT(STAT_FlightPilotInputUpdates);
+DEFINE_STAT(STAT_FlightInputLatency);
+
+DEFINE_STAT(STAT_FlightServerSendInputs);
+DEFINE_STAT(STAT_FlightOnRepServerState);
+DEFINE_STAT(STAT_FlightCorrections);
+DEFINE_STAT(STAT_FlightInputRpcsPerSecond);
+DEFINE_STAT(STAT_FlightStateBytes);
+DEFINE_STAT(STAT_FlightStateBytesPerSecond);
+
+CSV_DEFINE_CATEGORY_MODULE(MYPROJECT_API, Flight, true);
+CSV_DEFINE_CATEGORY_MODULE(MYPROJECT_API, FlightNet, true);
+
+#if FLIGHT_PROFILING
+namespace FlightStats
+{
+	// Counts since the window opened, published and reset once a second
+	static double WindowStart = -1.0;
+	static int32 NumInputRpcs = 0;
+	static int32 NumStates = 0;
+	static int64 NumStateBytes = 0;
+
+	// Last published rates, held between windows so the stat and CSV lines stay continuous
+	static float InputRpcsPerSecond = 0.f;
+	static float StateBytes = 0.f;
+	static float StateBytesPerSecond = 0.f;
+
+	void CountInputRpc()
+	{
+		++NumInputRpcs;
+	}
+
+	void CountReplicatedState(int32 Bytes)
+	{
+		++NumStates;
+		NumStateBytes += Bytes;
+	}
+
+	void Tick()
+	{
+		// Real time, a hitch must not inflate the rates
+		const double Now = FPlatformTime::Seconds();
+		if (WindowStart < 0.0)
+		{
+			WindowStart = Now;
+		}
+
+		const double Elapsed = Now - WindowStart;
+		if (Elapsed >= 1.0)
+		{
+			InputRpcsPerSecond = static_cast<float>(NumInputRpcs / Elapsed);
+			StateBytes = NumStates > 0 ? static_cast<float>(double(NumStateBytes) / NumStates) : 0.f;
+			StateBytesPerSecond = static_cast<float>(NumStateBytes / Elapsed);
+
+			WindowStart = Now;
+			NumInputRpcs = NumStates = 0;
+			NumStateBytes = 0;
+		}
+
+		SET_FLOAT_STAT(STAT_FlightInputRpcsPerSecond, InputRpcsPerSecond);
+		SET_FLOAT_STAT(STAT_FlightStateBytes, StateBytes);
+		SET_FLOAT_STAT(STAT_FlightStateBytesPerSecond, StateBytesPerSecond);
+		CSV_CUSTOM_STAT(FlightNet, InputRpcsPerSecond, InputRpcsPerSecond, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(FlightNet, StateBytes, StateBytes, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(FlightNet, StateBytesPerSecond, StateBytesPerSecond, ECsvCustomStatOp::Set);
+	}
+}
+#endif
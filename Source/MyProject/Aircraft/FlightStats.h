@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+/**
+ * Profiling for flight simulation, its replication and pilot input.
+ *  - stat Flight / stat FlightNet in game, STATGROUP_* counters in a -trace=cpu,stats capture.
+ *  - CSV timers and counters under the Flight and FlightNet categories (csvprofile start/stop).
+ *  - FLIGHT_SCOPE regions appear as CPU events in Unreal Insights, through the cycle stat when stats exist.
+ * Everything here is compiled out of Shipping, call sites need no guards of their own.
+ */
+#define FLIGHT_PROFILING !UE_BUILD_SHIPPING
+
+DECLARE_STATS_GROUP(TEXT("Flight"), STATGROUP_Flight, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Calculate Aerial Physics"), STAT_FlightCalculateAerialPhysics, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply Physics Step"), STAT_FlightApplyPhysicsStep, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Commit Move"), STAT_FlightCommitMove, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched Tick"), STAT_FlightBatchedTick, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batched Simulate"), STAT_FlightBatchedSimulate, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Aircraft Simulated"), STAT_FlightAircraftSimulated, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Flight Steps"), STAT_FlightSteps, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pilot Input"), STAT_FlightPilotInput, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pilot Input Updates"), STAT_FlightPilotInputUpdates, STATGROUP_Flight, MYPROJECT_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Input Latency (ms)"), STAT_FlightInputLatency, STATGROUP_Flight, MYPROJECT_API);
+
+DECLARE_STATS_GROUP(TEXT("FlightNet"), STATGROUP_FlightNet, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Server_SendInputs"), STAT_FlightServerSendInputs, STATGROUP_FlightNet, MYPROJECT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnRep_ServerState"), STAT_FlightOnRepServerState, STATGROUP_FlightNet, MYPROJECT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Corrections Applied"), STAT_FlightCorrections, STATGROUP_FlightNet, MYPROJECT_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Input RPCs/s"), STAT_FlightInputRpcsPerSecond, STATGROUP_FlightNet, MYPROJECT_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("ServerState Bytes Per Aircraft"), STAT_FlightStateBytes, STATGROUP_FlightNet, MYPROJECT_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("ServerState Bytes/s"), STAT_FlightStateBytesPerSecond, STATGROUP_FlightNet, MYPROJECT_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(MYPROJECT_API, Flight);
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(MYPROJECT_API, FlightNet);
+
+#if FLIGHT_PROFILING
+	#if STATS
+		// Cycle stats already emit an Insights CPU event, a second trace scope would only nest a duplicate
+		#define FLIGHT_SCOPE(Category, Name) SCOPE_CYCLE_COUNTER(STAT_Flight##Name); CSV_SCOPED_TIMING_STAT(Category, Name)
+	#else
+		#define FLIGHT_SCOPE(Category, Name) TRACE_CPUPROFILER_EVENT_SCOPE(Flight##Name); CSV_SCOPED_TIMING_STAT(Category, Name)
+	#endif
+	/** Per-frame counter in both the stat group and the CSV capture */
+	#define FLIGHT_COUNT(Category, Name, Amount) INC_DWORD_STAT_BY(STAT_Flight##Name, Amount); CSV_CUSTOM_STAT(Category, Name, Amount, ECsvCustomStatOp::Accumulate)
+#else
+	#define FLIGHT_SCOPE(Category, Name)
+	#define FLIGHT_COUNT(Category, Name, Amount)
+#endif
+
+/** Rates that need a time window rather than a per-frame count. Game thread only */
+namespace FlightStats
+{
+#if FLIGHT_PROFILING
+	MYPROJECT_API void CountInputRpc();
+	MYPROJECT_API void CountReplicatedState(int32 Bytes);
+	/** Publishes the rates once a second, called every frame by UFlightSimSubsystem */
+	MYPROJECT_API void Tick();
+#else
+	inline void CountInputRpc() {}
+	inline void CountReplicatedState(int32 Bytes) {}
+	inline void Tick() {}
+#endif
+}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** How acceleration is turned into position over one simulation step */
+enum class EFlightIntegrator : uint8
+{
+	/** v += a*dt, x += v*dt (the original integrator) */
+	SemiImplicitEuler,
+	/** v += a*dt, x += (v0 + v)/2 * dt, second order for acceleration held over the step (RK2 midpoint) */
+	Midpoint,
+};
+
+struct FFlightIntegrator
+{
+	static void IntegrateLinear(EFlightIntegrator Integrator, float DeltaTime, const FVector& InAccel, FVector& InOutVelocity, FVector& InOutLocation)
+	{
+		const FVector StartVelocity = InOutVelocity;
+		InOutVelocity += InAccel * DeltaTime;
+
+		if (Integrator == EFlightIntegrator::Midpoint)
+		{
+			InOutLocation += (StartVelocity + InOutVelocity) * (0.5f * DeltaTime);
+		}
+		else
+		{
+			InOutLocation += InOutVelocity * DeltaTime;
+		}
+	}
+};
+
+/** Simulated state handed to whoever sets an aircraft's inputs before a step */
+struct FFlightPilotState
+{
+	FVector Location;
+	FQuat Rotation;
+	FVector Velocity;
+};
+
+/**
+ * Fixed-rate simulation clock. Frame time goes into an accumulator and comes out as whole steps of a
+ * constant length, so every machine integrates the same trajectory no matter its frame rate.
+ */
+struct FFlightFixedClock
+{
+	float Accumulator = 0.f;
+
+	/**
+	 * Banks DeltaTime and returns how many steps to run this frame. Time beyond MaxSubsteps is dropped so a
+	 * hitch slows the simulation down instead of spiralling. StepSeconds <= 0 means one variable step of DeltaTime.
+	 */
+	int32 Advance(float DeltaTime, float StepSeconds, int32 MaxSubsteps)
+	{
+		if (StepSeconds <= 0.f)
+		{
+			Accumulator = 0.f;
+			return 1;
+		}
+
+		Accumulator = FMath::Min(Accumulator + DeltaTime, StepSeconds * FMath::Max(MaxSubsteps, 1));
+		const int32 Steps = FMath::FloorToInt32(Accumulator / StepSeconds);
+		Accumulator -= Steps * StepSeconds;
+		return Steps;
+	}
+
+	/** How far into the next step the frame is, for interpolating the rendered transform */
+	float GetAlpha(float StepSeconds) const
+	{
+		return StepSeconds > 0.f ? FMath::Clamp(Accumulator / StepSeconds, 0.f, 1.f) : 1.f;
+	}
+};
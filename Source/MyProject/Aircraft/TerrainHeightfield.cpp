@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainHeightfield.h"
+
+// Keeps a badly sized bake from allocating the whole machine
+static constexpr int64 MaxSamples = 16 * 1024 * 1024;
+
+// Largest relief a half tile may hold, half floats still resolve 8 cm at its top
+static constexpr float MaxHalfRelief = 8192.f;
+
+void FTerrainHeightfield::Reset()
+{
+	Tiles.Reset();
+	HalfHeights.Reset();
+	FullHeights.Reset();
+	NumCells = FIntPoint::ZeroValue;
+	NumTiles = FIntPoint::ZeroValue;
+	Bounds = FBox2D(ForceInit);
+}
+
+void FTerrainHeightfield::BeginBuild(const FTerrainBakeSettings& Settings)
+{
+	Reset();
+	if (!Settings.Bounds.IsValid) return;
+
+	const FVector2D Size(Settings.Bounds.GetSize());
+	CellSize = FMath::Max<double>(Settings.CellSize, 10.0);
+	if ((Size.X / CellSize + 1.0) * (Size.Y / CellSize + 1.0) > MaxSamples)
+	{
+		// Coarser is better than no ground at all
+		CellSize = FMath::Sqrt(Size.X * Size.Y / MaxSamples) * 1.01;
+		UE_LOG(LogTemp, Warning, TEXT("[Terrain] Bounds too large for the requested cell size, baking at %.0f cm"), CellSize);
+	}
+	InvCellSize = 1.0 / CellSize;
+
+	const int32 TileSize = FMath::RoundUpToPowerOfTwo(FMath::Clamp(Settings.TileSize, 4, 256));
+	TileShift = FMath::FloorLog2(TileSize);
+	TileMask = TileSize - 1;
+	TileStride = TileSize + 1;
+	bHalfPrecision = Settings.bHalfPrecision;
+
+	Origin = FVector2D(Settings.Bounds.Min);
+	NumCells = FIntPoint(FMath::Max(1, FMath::CeilToInt32(Size.X * InvCellSize)), FMath::Max(1, FMath::CeilToInt32(Size.Y * InvCellSize)));
+	NumTiles = FIntPoint(FMath::DivideAndRoundUp(NumCells.X, TileSize), FMath::DivideAndRoundUp(NumCells.Y, TileSize));
+	Bounds = FBox2D(Origin, Origin + FVector2D(NumCells) * CellSize);
+	Tiles.Reserve(NumTiles.X * NumTiles.Y);
+}
+
+bool FTerrainHeightfield::BuildTiles(TFunctionRef<float(double X, double Y)> HeightAt, int32 MaxTiles)
+{
+	const int32 TotalTiles = NumTiles.X * NumTiles.Y;
+	const int32 EndTile = FMath::Min(TotalTiles, Tiles.Num() + FMath::Max(MaxTiles, 1));
+
+	// Each tile samples its own window, the shared edge row and column are sampled by both neighbours
+	TArray<float> Window;
+	Window.SetNumUninitialized(TileStride * TileStride);
+	while (Tiles.Num() < EndTile)
+	{
+		const int32 TileX = Tiles.Num() % NumTiles.X;
+		const int32 TileY = Tiles.Num() / NumTiles.X;
+
+		// Edge tiles repeat the last sample past the end of the grid, copied rather than sampled again
+		const int32 FirstX = TileX << TileShift;
+		const int32 FirstY = TileY << TileShift;
+		float MinHeight = UE_BIG_NUMBER;
+		float MaxHeight = -UE_BIG_NUMBER;
+		for (int32 Y = 0; Y < TileStride; ++Y)
+		{
+			const int32 SampleY = FMath::Min(FirstY + Y, NumCells.Y);
+			const bool bRepeatRow = Y > 0 && SampleY == FMath::Min(FirstY + Y - 1, NumCells.Y);
+			for (int32 X = 0; X < TileStride; ++X)
+			{
+				const int32 SampleX = FMath::Min(FirstX + X, NumCells.X);
+				float& Height = Window[Y * TileStride + X];
+				if (bRepeatRow)
+				{
+					Height = Window[(Y - 1) * TileStride + X];
+				}
+				else if (X > 0 && SampleX == FMath::Min(FirstX + X - 1, NumCells.X))
+				{
+					Height = Window[Y * TileStride + X - 1];
+				}
+				else
+				{
+					Height = HeightAt(Origin.X + SampleX * CellSize, Origin.Y + SampleY * CellSize);
+				}
+				MinHeight = FMath::Min(MinHeight, Height);
+				MaxHeight = FMath::Max(MaxHeight, Height);
+			}
+		}
+
+		FTile& Tile = Tiles.AddDefaulted_GetRef();
+		Tile.BaseHeight = MinHeight;
+		if (MaxHeight - MinHeight <= UE_KINDA_SMALL_NUMBER)
+		{
+			Tile.Format = ETileFormat::Flat;
+		}
+		else if (bHalfPrecision && MaxHeight - MinHeight <= MaxHalfRelief)
+		{
+			Tile.Format = ETileFormat::Half;
+			Tile.FirstSample = HalfHeights.Num();
+			for (const float Height : Window)
+			{
+				HalfHeights.Add(FFloat16(Height - MinHeight));
+			}
+		}
+		else
+		{
+			Tile.Format = ETileFormat::Full;
+			Tile.FirstSample = FullHeights.Num();
+			FullHeights.Append(Window);
+		}
+	}
+
+	if (Tiles.Num() < TotalTiles) return false;
+
+	HalfHeights.Shrink();
+	FullHeights.Shrink();
+
+	const FTerrainMemoryStats Stats = GetMemoryStats();
+	UE_LOG(LogTemp, Log, TEXT("[Terrain] Baked %dx%d cells at %.0f cm: %d tiles (%d flat, %d half, %d full), %.1f KB vs %.1f KB dense"),
+		NumCells.X, NumCells.Y, CellSize, Stats.NumTiles, Stats.NumFlatTiles, Stats.NumHalfTiles, Stats.NumFullTiles,
+		Stats.AllocatedBytes / 1024.0, Stats.DenseFloatBytes / 1024.0);
+	return true;
+}
+
+void FTerrainHeightfield::LocateCell(double X, double Y, int32& OutCellX, int32& OutCellY, float& OutAlphaX, float& OutAlphaY) const
+{
+	const double FX = FMath::Clamp((X - Origin.X) * InvCellSize, 0.0, double(NumCells.X));
+	const double FY = FMath::Clamp((Y - Origin.Y) * InvCellSize, 0.0, double(NumCells.Y));
+
+	// The far border uses the last cell with an alpha of 1
+	OutCellX = FMath::Min(static_cast<int32>(FX), NumCells.X - 1);
+	OutCellY = FMath::Min(static_cast<int32>(FY), NumCells.Y - 1);
+	OutAlphaX = static_cast<float>(FX - OutCellX);
+	OutAlphaY = static_cast<float>(FY - OutCellY);
+}
+
+void FTerrainHeightfield::ReadCell(int32 CellX, int32 CellY, float OutCorners[4]) const
+{
+	const FTile& Tile = Tiles[(CellY >> TileShift) * NumTiles.X + (CellX >> TileShift)];
+	const int32 Index = Tile.FirstSample + (CellY & TileMask) * TileStride + (CellX & TileMask);
+
+	switch (Tile.Format)
+	{
+		case ETileFormat::Half:
+		{
+			const FFloat16* Samples = HalfHeights.GetData() + Index;
+			OutCorners[0] = Tile.BaseHeight + Samples[0].GetFloat();
+			OutCorners[1] = Tile.BaseHeight + Samples[1].GetFloat();
+			OutCorners[2] = Tile.BaseHeight + Samples[TileStride].GetFloat();
+			OutCorners[3] = Tile.BaseHeight + Samples[TileStride + 1].GetFloat();
+			break;
+		}
+		case ETileFormat::Full:
+		{
+			const float* Samples = FullHeights.GetData() + Index;
+			OutCorners[0] = Samples[0];
+			OutCorners[1] = Samples[1];
+			OutCorners[2] = Samples[TileStride];
+			OutCorners[3] = Samples[TileStride + 1];
+			break;
+		}
+		default:
+			OutCorners[0] = OutCorners[1] = OutCorners[2] = OutCorners[3] = Tile.BaseHeight;
+			break;
+	}
+}
+
+float FTerrainHeightfield::GetHeight(double X, double Y) const
+{
+	if (Tiles.IsEmpty()) return 0.f;
+
+	int32 CellX, CellY;
+	float AlphaX, AlphaY;
+	LocateCell(X, Y, CellX, CellY, AlphaX, AlphaY);
+
+	float H[4];
+	ReadCell(CellX, CellY, H);
+	return FMath::Lerp(FMath::Lerp(H[0], H[1], AlphaX), FMath::Lerp(H[2], H[3], AlphaX), AlphaY);
+}
+
+FTerrainSample FTerrainHeightfield::Sample(double X, double Y) const
+{
+	FTerrainSample Result;
+	if (Tiles.IsEmpty()) return Result;
+
+	int32 CellX, CellY;
+	float AlphaX, AlphaY;
+	LocateCell(X, Y, CellX, CellY, AlphaX, AlphaY);
+
+	float H[4];
+	ReadCell(CellX, CellY, H);
+	Result.Height = FMath::Lerp(FMath::Lerp(H[0], H[1], AlphaX), FMath::Lerp(H[2], H[3], AlphaX), AlphaY);
+
+	// Gradient of the bilinear patch at the point
+	const float InvCell = static_cast<float>(InvCellSize);
+	const float SlopeX = FMath::Lerp(H[1] - H[0], H[3] - H[2], AlphaY) * InvCell;
+	const float SlopeY = FMath::Lerp(H[2] - H[0], H[3] - H[1], AlphaX) * InvCell;
+	Result.Normal = FVector3f(-SlopeX, -SlopeY, 1.f).GetUnsafeNormal();
+	return Result;
+}
+
+void FTerrainHeightfield::SampleBatch(TConstArrayView<FVector> Locations, TArrayView<FTerrainSample> OutSamples) const
+{
+	check(Locations.Num() == OutSamples.Num());
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		OutSamples[i] = Sample(Locations[i].X, Locations[i].Y);
+	}
+}
+
+FTerrainMemoryStats FTerrainHeightfield::GetMemoryStats() const
+{
+	FTerrainMemoryStats Stats;
+	Stats.NumTiles = Tiles.Num();
+	for (const FTile& Tile : Tiles)
+	{
+		Stats.NumFlatTiles += Tile.Format == ETileFormat::Flat;
+		Stats.NumHalfTiles += Tile.Format == ETileFormat::Half;
+		Stats.NumFullTiles += Tile.Format == ETileFormat::Full;
+	}
+	Stats.AllocatedBytes = Tiles.GetAllocatedSize() + HalfHeights.GetAllocatedSize() + FullHeights.GetAllocatedSize();
+	Stats.DenseFloatBytes = SIZE_T(NumCells.X + 1) * (NumCells.Y + 1) * sizeof(float);
+	return Stats;
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Ground under one point */
+struct FTerrainSample
+{
+	float Height = 0.f;
+	FVector3f Normal = FVector3f::UpVector;
+};
+
+struct FTerrainBakeSettings
+{
+	/** XY extent to bake, Z is only used for the trace range */
+	FBox Bounds = FBox(ForceInit);
+	/** Distance (cm) between samples */
+	float CellSize = 400.f;
+	/** Samples per tile edge, rounded up to a power of two */
+	int32 TileSize = 64;
+	/** Store each tile as 16-bit offsets from its lowest sample when its relief fits */
+	bool bHalfPrecision = true;
+};
+
+/** Footprint of a baked heightfield */
+struct FTerrainMemoryStats
+{
+	int32 NumTiles = 0;
+	int32 NumFlatTiles = 0;
+	int32 NumHalfTiles = 0;
+	int32 NumFullTiles = 0;
+	SIZE_T AllocatedBytes = 0;
+	/** What one float per sample would have taken */
+	SIZE_T DenseFloatBytes = 0;
+};
+
+/**
+ * Ground height over the map, baked once into square tiles. Flat tiles (sea, runways, the floor outside the
+ * level) store nothing, the rest store one sample per grid corner as floats or as half floats relative to the
+ * tile's lowest point. Tiles repeat their last row and column so a lookup never crosses a tile: finding the
+ * cell, its tile and four samples is pure arithmetic. Built a few tiles at a time, so a bake can be spread over
+ * frames; read-only once built, safe to sample from any thread.
+ */
+class MYPROJECT_API FTerrainHeightfield
+{
+public:
+	/** Lays out the grid over Settings.Bounds, BuildTiles then fills it in */
+	void BeginBuild(const FTerrainBakeSettings& Settings);
+	/**
+	 * Samples and packs up to MaxTiles more tiles in row order, true once every tile is built. HeightAt(X, Y)
+	 * returns the ground height at a world XY, it is called once per tile sample.
+	 */
+	bool BuildTiles(TFunctionRef<float(double X, double Y)> HeightAt, int32 MaxTiles);
+	bool IsBuilt() const { return !Tiles.IsEmpty() && Tiles.Num() == NumTiles.X * NumTiles.Y; }
+	/** Tiles built so far and in total */
+	int32 GetNumBuiltTiles() const { return Tiles.Num(); }
+	int32 GetNumTiles() const { return NumTiles.X * NumTiles.Y; }
+	void Reset();
+	bool IsEmpty() const { return Tiles.IsEmpty(); }
+
+	/** Bilinear height, clamped to the border outside the baked area */
+	float GetHeight(double X, double Y) const;
+	/** Bilinear height and the normal of the interpolated surface */
+	FTerrainSample Sample(double X, double Y) const;
+	/** Sample for every location, OutSamples must be as long as Locations */
+	void SampleBatch(TConstArrayView<FVector> Locations, TArrayView<FTerrainSample> OutSamples) const;
+
+	FTerrainMemoryStats GetMemoryStats() const;
+	const FBox2D& GetBounds() const { return Bounds; }
+
+private:
+	enum class ETileFormat : uint8
+	{
+		Flat,
+		Half,
+		Full,
+	};
+
+	struct FTile
+	{
+		/** Height of a flat tile, the offset base of a half tile */
+		float BaseHeight = 0.f;
+		/** First sample in HalfHeights or FullHeights */
+		int32 FirstSample = 0;
+		ETileFormat Format = ETileFormat::Flat;
+	};
+
+	/** Cell containing the point, clamped, and the blend factors inside it */
+	void LocateCell(double X, double Y, int32& OutCellX, int32& OutCellY, float& OutAlphaX, float& OutAlphaY) const;
+	/** Heights at the cell corners: (0,0), (1,0), (0,1), (1,1) */
+	void ReadCell(int32 CellX, int32 CellY, float OutCorners[4]) const;
+
+	FBox2D Bounds = FBox2D(ForceInit);
+	FVector2D Origin = FVector2D::ZeroVector;
+	double CellSize = 1.0;
+	double InvCellSize = 1.0;
+	/** Cells along each axis, one less than the samples */
+	FIntPoint NumCells = FIntPoint::ZeroValue;
+	FIntPoint NumTiles = FIntPoint::ZeroValue;
+	int32 TileShift = 0;
+	int32 TileMask = 0;
+	/** TileSize + 1 */
+	int32 TileStride = 0;
+	bool bHalfPrecision = true;
+
+	TArray<FTile> Tiles;
+	TArray<FFloat16> HalfHeights;
+	TArray<float> FullHeights;
+};
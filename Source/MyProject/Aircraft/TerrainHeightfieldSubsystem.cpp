@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainHeightfieldSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/World.h"
+#include "LandscapeProxy.h"
+
+static TAutoConsoleVariable<bool> CVarTerrainEnable(
+	TEXT("ac.Terrain.Enable"),
+	true,
+	TEXT("Bake a terrain heightfield at begin play and collide aircraft with it."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarTerrainCellSize(
+	TEXT("ac.Terrain.CellSize"),
+	400.f,
+	TEXT("Distance (cm) between heightfield samples. Takes effect on the next bake."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarTerrainTileSize(
+	TEXT("ac.Terrain.TileSize"),
+	64,
+	TEXT("Heightfield samples per tile edge, a power of two. Takes effect on the next bake."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<bool> CVarTerrainHalfPrecision(
+	TEXT("ac.Terrain.HalfPrecision"),
+	true,
+	TEXT("Store tiles as 16-bit offsets when their relief allows it. Takes effect on the next bake."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarTerrainBakeBudgetMs(
+	TEXT("ac.Terrain.BakeBudgetMs"),
+	2.f,
+	TEXT("Game-thread milliseconds per frame a terrain bake may take. At least one tile is built every frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarTerrainClearance(
+	TEXT("ac.Terrain.Clearance"),
+	150.f,
+	TEXT("Height (cm) aircraft are kept above the terrain."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld CmdTerrainRebake(
+	TEXT("ac.Terrain.Rebake"),
+	TEXT("Bakes the terrain heightfield again with the current ac.Terrain settings."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UTerrainHeightfieldSubsystem* Terrain = World ? World->GetSubsystem<UTerrainHeightfieldSubsystem>() : nullptr)
+		{
+			Terrain->Bake();
+		}
+	}));
+
+bool UTerrainHeightfieldSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTerrainHeightfieldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// World Partition streams landscape in and out as cells, each arrives as a level
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UTerrainHeightfieldSubsystem::OnLevelChanged);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UTerrainHeightfieldSubsystem::OnLevelChanged);
+}
+
+void UTerrainHeightfieldSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	Bake();
+}
+
+void UTerrainHeightfieldSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	Heightfield.Reset();
+	PendingHeightfield.Reset();
+	Landscapes.Reset();
+	bBaking = false;
+	bBakeQueued = false;
+
+	Super::Deinitialize();
+}
+
+TStatId UTerrainHeightfieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTerrainHeightfieldSubsystem, STATGROUP_Tickables);
+}
+
+void UTerrainHeightfieldSubsystem::OnLevelChanged(ULevel* InLevel, UWorld* InWorld)
+{
+	if (InWorld != GetWorld() || !InLevel || !InWorld->HasBegunPlay()) return;
+
+	const bool bHasLandscape = InLevel->Actors.ContainsByPredicate([](const AActor* Actor) { return Actor && Actor->IsA<ALandscapeProxy>(); });
+	if (!bHasLandscape) return;
+
+	// Restarting on every streamed cell could keep a bake from ever finishing, the running one completes first
+	if (bBaking)
+	{
+		bBakeQueued = true;
+	}
+	else
+	{
+		Bake();
+	}
+}
+
+void UTerrainHeightfieldSubsystem::Bake()
+{
+	PendingHeightfield.Reset();
+	Landscapes.Reset();
+	bBaking = false;
+	bBakeQueued = false;
+	if (!CVarTerrainEnable.GetValueOnGameThread())
+	{
+		Heightfield.Reset();
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	SourceBounds = FBox(ForceInit);
+	TSet<FGuid> LandscapeGuids;
+	for (TActorIterator<ALandscapeProxy> It(World); It; ++It)
+	{
+		SourceBounds += It->GetComponentsBoundingBox();
+		bool bKnownLandscape = false;
+		LandscapeGuids.Add(It->GetLandscapeGuid(), &bKnownLandscape);
+		if (!bKnownLandscape)
+		{
+			Landscapes.Add(*It);
+		}
+	}
+
+	// No landscape: trace the static geometry of every level instead
+	if (Landscapes.IsEmpty())
+	{
+		for (const ULevel* Level : World->GetLevels())
+		{
+			SourceBounds += ALevelBounds::CalculateLevelBounds(Level);
+		}
+	}
+	if (!SourceBounds.IsValid)
+	{
+		Heightfield.Reset();
+		return;
+	}
+
+	FTerrainBakeSettings Settings;
+	Settings.Bounds = SourceBounds;
+	Settings.CellSize = CVarTerrainCellSize.GetValueOnGameThread();
+	Settings.TileSize = CVarTerrainTileSize.GetValueOnGameThread();
+	Settings.bHalfPrecision = CVarTerrainHalfPrecision.GetValueOnGameThread();
+	PendingHeightfield.BeginBuild(Settings);
+
+	bBaking = true;
+	BakeSeconds = 0.0;
+	BakeFrames = 0;
+}
+
+void UTerrainHeightfieldSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (!bBaking) return;
+
+	const double BudgetSeconds = CVarTerrainBakeBudgetMs.GetValueOnGameThread() * 0.001;
+	const double StartTime = FPlatformTime::Seconds();
+	bool bBuilt = false;
+	do
+	{
+		bBuilt = PendingHeightfield.BuildTiles([this](double X, double Y) { return SampleSource(X, Y); }, 1);
+	}
+	while (!bBuilt && FPlatformTime::Seconds() - StartTime < BudgetSeconds);
+	BakeSeconds += FPlatformTime::Seconds() - StartTime;
+	++BakeFrames;
+	if (!bBuilt) return;
+
+	// Flight workers only sample inside the flight sim's tick, nothing reads the heightfield while it is replaced
+	UE_LOG(LogTemp, Log, TEXT("[Terrain] Bake from %s took %.1f ms over %d frames"),
+		Landscapes.IsEmpty() ? TEXT("traces") : TEXT("landscape"), BakeSeconds * 1000.0, BakeFrames);
+	Heightfield = MoveTemp(PendingHeightfield);
+	PendingHeightfield.Reset();
+	Landscapes.Reset();
+	bBaking = false;
+
+	if (bBakeQueued)
+	{
+		Bake();
+	}
+}
+
+float UTerrainHeightfieldSubsystem::SampleSource(double X, double Y) const
+{
+	double Height = SourceBounds.Min.Z;
+	if (Landscapes.IsEmpty())
+	{
+		// Static geometry only, pawns and projectiles must not end up in the ground
+		FHitResult Hit;
+		const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+		const FCollisionQueryParams Params(SCENE_QUERY_STAT(TerrainBake), false);
+		if (GetWorld()->LineTraceSingleByObjectType(Hit, FVector(X, Y, SourceBounds.Max.Z + 100.0), FVector(X, Y, SourceBounds.Min.Z - 100.0), ObjectParams, Params))
+		{
+			Height = Hit.ImpactPoint.Z;
+		}
+		return static_cast<float>(Height);
+	}
+
+	// Overlapping landscapes: the highest ground wins, holes and unloaded cells fall back to the bottom of the extent
+	const FVector Location(X, Y, 0.0);
+	for (const TWeakObjectPtr<ALandscapeProxy>& Landscape : Landscapes)
+	{
+		if (const ALandscapeProxy* Proxy = Landscape.Get())
+		{
+			const TOptional<float> LandscapeHeight = Proxy->GetHeightAtLocation(Location);
+			if (LandscapeHeight.IsSet())
+			{
+				Height = FMath::Max<double>(Height, LandscapeHeight.GetValue());
+			}
+		}
+	}
+	return static_cast<float>(Height);
+}
+
+double UTerrainHeightfieldSubsystem::GetRadarAltitude(const FVector& Location) const
+{
+	return Location.Z - Heightfield.GetHeight(Location.X, Location.Y);
+}
+
+bool UTerrainHeightfieldSubsystem::ResolveGroundContact(FFlightBodyState& Body) const
+{
+	if (Heightfield.IsEmpty()) return false;
+
+	const FTerrainSample Ground = Heightfield.Sample(Body.Location.X, Body.Location.Y);
+	const double MinZ = Ground.Height + CVarTerrainClearance.GetValueOnAnyThread();
+	if (Body.Location.Z >= MinZ) return false;
+
+	Body.Location.Z = MinZ;
+
+	const FVector Normal(Ground.Normal);
+	const double IntoGround = FVector::DotProduct(Body.LinearVelocity, Normal);
+	if (IntoGround < 0.0)
+	{
+		Body.LinearVelocity -= IntoGround * Normal;
+	}
+	return true;
+}
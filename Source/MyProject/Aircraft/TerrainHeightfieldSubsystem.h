@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TerrainHeightfield.h"
+#include "FlightDynamics.h"
+#include "TerrainHeightfieldSubsystem.generated.h"
+
+class ALandscapeProxy;
+
+/**
+ * Bakes the level's ground into an FTerrainHeightfield when play begins, on the server and on every client,
+ * and answers ground queries from it: collision response for flight steps, radar altitude, AI terrain
+ * avoidance. All queries are read-only and may run on the flight workers.
+ *
+ * The bake reads landscape height data over the extent of the loaded landscape; levels without one trace
+ * their static geometry instead. Either way it is spread over frames within ac.Terrain.BakeBudgetMs, and
+ * the finished heightfield replaces the old one between flight steps.
+ */
+UCLASS()
+class MYPROJECT_API UTerrainHeightfieldSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Starts baking the ground again, the current heightfield answers queries until the new one is done.
+	 * Called at begin play, when landscape streams in or out, and by ac.Terrain.Rebake.
+	 */
+	void Bake();
+	bool IsBaking() const { return bBaking; }
+	const FTerrainHeightfield& GetHeightfield() const { return Heightfield; }
+
+	/** Height above the ground directly below, Location.Z when nothing was baked */
+	double GetRadarAltitude(const FVector& Location) const;
+
+	/**
+	 * Keeps the body ac.Terrain.Clearance above the ground: pushes it back up and removes the velocity going
+	 * into the slope, so aircraft slide along the terrain instead of passing through it. True on contact.
+	 */
+	bool ResolveGroundContact(FFlightBodyState& Body) const;
+
+private:
+	void OnLevelChanged(ULevel* InLevel, UWorld* InWorld);
+	/** Ground height at a world XY from whatever the running bake reads */
+	float SampleSource(double X, double Y) const;
+
+	FTerrainHeightfield Heightfield;
+	/** Bake in progress, moved into Heightfield once its last tile is built */
+	FTerrainHeightfield PendingHeightfield;
+	bool bBaking = false;
+	/** Landscape streamed in or out during a bake, start another when it finishes */
+	bool bBakeQueued = false;
+
+	/** One proxy per loaded landscape, each answers for all of its landscape's loaded components */
+	TArray<TWeakObjectPtr<ALandscapeProxy>> Landscapes;
+	/** Extent of the running bake, its Min.Z is the ground where nothing was found */
+	FBox SourceBounds = FBox(ForceInit);
+	/** Game-thread time the running bake has taken so far */
+	double BakeSeconds = 0.0;
+	int32 BakeFrames = 0;
+
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+};
@@ -6,22 +6,20 @@
 // Sets default values
 AAProjectile::AAProjectile()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Moved in bulk by UProjectileSubsystem
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = false;
 
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+	SetActorEnableCollision(false);
 }
 
-// Called when the game starts or when spawned
-void AAProjectile::BeginPlay()
+void AAProjectile::ActivateVisual()
 {
-	Super::BeginPlay();
-	
+	SetActorHiddenInGame(false);
 }
 
-// Called every frame
-void AAProjectile::Tick(float DeltaTime)
+void AAProjectile::DeactivateVisual()
 {
-	Super::Tick(DeltaTime);
-
+	SetActorHiddenInGame(true);
 }
-
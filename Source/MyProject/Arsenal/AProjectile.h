@@ -6,6 +6,10 @@
 #include "GameFramework/Actor.h"
 #include "AProjectile.generated.h"
 
+/**
+ * Visual stand-in for a round simulated by UProjectileSubsystem. Carries no gameplay state, does not tick or
+ * collide, and is recycled from the subsystem's pool instead of being spawned per shot.
+ */
 UCLASS()
 class MYPROJECT_API AAProjectile : public AActor
 {
@@ -15,12 +19,12 @@ public:
 	// Sets default values for this actor's properties
 	AAProjectile();
 
-protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
+	/** Called by the pool when the actor is handed to a new round / given back */
+	void ActivateVisual();
+	void DeactivateVisual();
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	/** The round this actor was drawing hit something; spawn impact effects here */
+	UFUNCTION(BlueprintImplementableEvent, Category="Projectile")
+	void ReceiveImpact(const FHitResult& Hit);
 
 };
@@ -3,25 +3,66 @@
 
 #include "AWeaponBase.h"
 
+#include "LagCompensationSubsystem.h"
+#include "ProjectileSubsystem.h"
+#include "GameFramework/Pawn.h"
+#include "MyProject/Aircraft/FPVMovementComponent.h"
+#include "Engine/World.h"
+
 // Sets default values
 AAWeaponBase::AAWeaponBase()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Rounds are advanced by UProjectileSubsystem, the weapon itself has nothing to do per frame
+	PrimaryActorTick.bCanEverTick = false;
+	bReplicates = true;
+
+}
+
+void AAWeaponBase::Fire()
+{
+	if (HasAuthority())
+	{
+		FireAuthoritative(0.f);
+		return;
+	}
 
+	const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+	if (OwnerPawn && OwnerPawn->IsLocallyControlled())
+	{
+		Server_Fire(UFPVMovementComponent::GetProxyRenderTime(GetWorld()));
+	}
 }
 
-// Called when the game starts or when spawned
-void AAWeaponBase::BeginPlay()
+void AAWeaponBase::Server_Fire_Implementation(double ViewTime)
 {
-	Super::BeginPlay();
-	
+	const ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	FireAuthoritative(LagComp ? LagComp->GetRewindSeconds(ViewTime) : 0.f);
 }
 
-// Called every frame
-void AAWeaponBase::Tick(float DeltaTime)
+void AAWeaponBase::FireAuthoritative(float RewindSeconds)
 {
-	Super::Tick(DeltaTime);
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (LastFireTime >= 0.0 && Now - LastFireTime < 60.0 / FMath::Max(RoundsPerMinute, 1.f)) return;
+	LastFireTime = Now;
 
+	// Rounds inherit the velocity of the aircraft carrying the gun
+	const FVector Origin = GetActorLocation();
+	const FVector Velocity = GetActorForwardVector() * Projectile.MuzzleSpeed + (GetOwner() ? GetOwner()->GetVelocity() : FVector::ZeroVector);
+
+	if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+	{
+		Projectiles->FireRound(Projectile, Origin, Velocity, GetOwner(), true, RewindSeconds);
+	}
+	Multicast_FireCosmetic(Origin, Velocity);
 }
 
+void AAWeaponBase::Multicast_FireCosmetic_Implementation(FVector_NetQuantize Origin, FVector_NetQuantize10 Velocity)
+{
+	// The server already has the real round
+	if (HasAuthority()) return;
+
+	if (UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>())
+	{
+		Projectiles->FireRound(Projectile, Origin, Velocity, GetOwner(), false);
+	}
+}
@@ -4,23 +4,44 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "MyProject/GCore/Config.h"
 #include "AWeaponBase.generated.h"
 
+/**
+ * Gun mounted on an aircraft. Rounds are data in UProjectileSubsystem, never actors: the server's round deals
+ * the damage and every client runs a cosmetic copy of it from one unreliable multicast.
+ */
 UCLASS()
 class MYPROJECT_API AAWeaponBase : public AActor
 {
 	GENERATED_BODY()
+	friend class FLagCompensationFireTest;
 	
 public:	
 	// Sets default values for this actor's properties
 	AAWeaponBase();
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Weapon")
+	FProjectileConfig Projectile;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Weapon")
+	float RoundsPerMinute = 1200.f;
+
+	/** Fires one round along the weapon's forward axis if the fire rate allows. The owning client asks the server */
+	UFUNCTION(BlueprintCallable, Category="Weapon")
+	void Fire();
+
 protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
+	/** ViewTime is the server time the client was drawing other aircraft at, the round is lag compensated to it */
+	UFUNCTION(Server, Unreliable)
+	void Server_Fire(double ViewTime);
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	void FireAuthoritative(float RewindSeconds);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void Multicast_FireCosmetic(FVector_NetQuantize Origin, FVector_NetQuantize10 Velocity);
+
+private:
+	double LastFireTime = -1.0;
 
 };
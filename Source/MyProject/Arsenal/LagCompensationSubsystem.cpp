@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LagCompensationSubsystem.h"
+
+#include "CollisionQueryParams.h"
+#include "Engine/World.h"
+#include "MyProject/Aircraft/AAircraftBase.h"
+
+static TAutoConsoleVariable<float> CVarNetLagCompMaxRewind(
+	TEXT("ac.Net.LagCompMaxRewind"),
+	0.4f,
+	TEXT("Furthest back (s) a shot may be rewound. Also sizes the per-aircraft history, so it is fixed at startup."),
+	ECVF_ReadOnly);
+
+static TAutoConsoleVariable<float> CVarNetLagCompRecordHz(
+	TEXT("ac.Net.LagCompRecordHz"),
+	60.f,
+	TEXT("Rate aircraft poses are recorded at for lag compensation. Fixed at startup."),
+	ECVF_ReadOnly);
+
+void FLagCompHistory::Record(double Time, const FVector& Location, const FQuat& Rotation)
+{
+	FLagCompFrame& Frame = Frames[Head];
+	Frame.Time = Time;
+	Frame.Location = Location;
+	Frame.Rotation = Rotation;
+
+	Head = (Head + 1) % Frames.Num();
+	Num = FMath::Min(Num + 1, Frames.Num());
+}
+
+bool FLagCompHistory::Sample(double Time, FVector& OutLocation, FQuat& OutRotation) const
+{
+	if (Num == 0) return false;
+
+	const int32 Capacity = Frames.Num();
+	const int32 Oldest = (Head - Num + Capacity) % Capacity;
+	auto At = [&](int32 Age) -> const FLagCompFrame& { return Frames[(Oldest + Age) % Capacity]; };
+
+	if (Time <= At(0).Time)
+	{
+		OutLocation = At(0).Location;
+		OutRotation = At(0).Rotation;
+		return true;
+	}
+	if (Time >= At(Num - 1).Time)
+	{
+		OutLocation = At(Num - 1).Location;
+		OutRotation = At(Num - 1).Rotation;
+		return true;
+	}
+
+	// First frame newer than Time; frames are in recording order so a binary search finds it
+	int32 Low = 1;
+	int32 High = Num - 1;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (At(Mid).Time > Time) High = Mid;
+		else Low = Mid + 1;
+	}
+
+	const FLagCompFrame& From = At(Low - 1);
+	const FLagCompFrame& To = At(Low);
+	const double Alpha = (Time - From.Time) / FMath::Max(To.Time - From.Time, UE_SMALL_NUMBER);
+	OutLocation = FMath::Lerp(From.Location, To.Location, Alpha);
+	OutRotation = FQuat::Slerp(From.Rotation, To.Rotation, Alpha);
+	return true;
+}
+
+bool ULagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	Aircraft.Reset();
+	Histories.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::RegisterAircraft(AAAircraftBase* InAircraft)
+{
+	if (!InAircraft || Aircraft.Contains(InAircraft)) return;
+
+	Aircraft.Add(InAircraft);
+	FLagCompHistory& History = Histories.AddDefaulted_GetRef();
+
+	// Two extra frames so the full window always has a frame on both sides of it
+	const float RecordHz = FMath::Max(1.f, CVarNetLagCompRecordHz.GetValueOnGameThread());
+	History.Frames.SetNum(FMath::CeilToInt32(CVarNetLagCompMaxRewind.GetValueOnGameThread() * RecordHz) + 2);
+
+	History.LocalBounds = InAircraft->CalculateComponentsBoundingBoxInLocalSpace(true);
+	if (!History.LocalBounds.IsValid)
+	{
+		History.LocalBounds = FBox(FVector(-100.0), FVector(100.0));
+	}
+	History.BoundingRadius = History.LocalBounds.GetExtent().Size() + History.LocalBounds.GetCenter().Size();
+
+	History.Record(GetWorld()->GetTimeSeconds(), InAircraft->GetActorLocation(), InAircraft->GetActorQuat());
+}
+
+void ULagCompensationSubsystem::UnregisterAircraft(AAAircraftBase* InAircraft)
+{
+	const int32 Index = Aircraft.Find(InAircraft);
+	if (Index == INDEX_NONE) return;
+
+	Aircraft.RemoveAtSwap(Index, EAllowShrinking::No);
+	Histories.RemoveAtSwap(Index, EAllowShrinking::No);
+}
+
+bool ULagCompensationSubsystem::IsTracked(const AActor* Actor) const
+{
+	const AAAircraftBase* Plane = Cast<AAAircraftBase>(Actor);
+	return Plane && Aircraft.Contains(Plane);
+}
+
+void ULagCompensationSubsystem::AddTrackedAircraft(FCollisionQueryParams& Params) const
+{
+	for (const AAAircraftBase* Plane : Aircraft)
+	{
+		Params.AddIgnoredActor(Plane);
+	}
+}
+
+double ULagCompensationSubsystem::GetRewindSeconds(double ViewTime) const
+{
+	return FMath::Clamp(GetWorld()->GetTimeSeconds() - ViewTime, 0.0, static_cast<double>(CVarNetLagCompMaxRewind.GetValueOnGameThread()));
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Aircraft.IsEmpty()) return;
+
+	TimeSinceRecord += DeltaTime;
+	if (TimeSinceRecord < 1.f / FMath::Max(1.f, CVarNetLagCompRecordHz.GetValueOnGameThread())) return;
+	TimeSinceRecord = 0.f;
+
+	RecordFrames();
+}
+
+void ULagCompensationSubsystem::RecordFrames()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		Histories[i].Record(Now, Aircraft[i]->GetActorLocation(), Aircraft[i]->GetActorQuat());
+	}
+}
+
+bool ULagCompensationSubsystem::TraceRewound(const FVector& Start, const FVector& End, double Time, const AActor* IgnoreActor, FLagCompHit& OutHit) const
+{
+	OutHit = FLagCompHit();
+
+	for (int32 i = 0; i < Aircraft.Num(); ++i)
+	{
+		if (Aircraft[i] == IgnoreActor) continue;
+
+		const FLagCompHistory& History = Histories[i];
+		FVector Location;
+		FQuat Rotation;
+		if (!History.Sample(Time, Location, Rotation)) continue;
+
+		// Bounding sphere first, the oriented box only for the few that pass
+		if (FMath::PointDistToSegmentSquared(Location, Start, End) > FMath::Square(History.BoundingRadius)) continue;
+
+		const FVector LocalStart = Rotation.UnrotateVector(Start - Location);
+		const FVector LocalEnd = Rotation.UnrotateVector(End - Location);
+		FVector LocalHit;
+		FVector LocalNormal;
+		float HitTime;
+		if (!FMath::LineExtentBoxIntersection(History.LocalBounds, LocalStart, LocalEnd, FVector::ZeroVector, LocalHit, LocalNormal, HitTime)) continue;
+		if (HitTime >= OutHit.Time) continue;
+
+		OutHit.Aircraft = Aircraft[i];
+		OutHit.Location = Location + Rotation.RotateVector(LocalHit);
+		OutHit.Normal = Rotation.RotateVector(LocalNormal);
+		OutHit.Time = HitTime;
+	}
+
+	return OutHit.Aircraft != nullptr;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class AAAircraftBase;
+
+/** One recorded pose of an aircraft */
+struct FLagCompFrame
+{
+	double Time = 0.0;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+};
+
+/** Ring of past poses plus the actor-space box they are tested with. Frames never reallocate after registration */
+struct FLagCompHistory
+{
+	TArray<FLagCompFrame> Frames;
+	int32 Head = 0;
+	int32 Num = 0;
+	FBox LocalBounds = FBox(ForceInit);
+	double BoundingRadius = 0.0;
+
+	void Record(double Time, const FVector& Location, const FQuat& Rotation);
+	/** Pose at Time, interpolated between the two frames around it and clamped to the recorded range */
+	bool Sample(double Time, FVector& OutLocation, FQuat& OutRotation) const;
+};
+
+struct FLagCompHit
+{
+	AAAircraftBase* Aircraft = nullptr;
+	FVector Location = FVector::ZeroVector;
+	FVector Normal = FVector::ZeroVector;
+	/** 0..1 along the traced segment */
+	float Time = 1.f;
+};
+
+/**
+ * Server-side hit registration against where a shooter saw its targets. Every authority aircraft's pose is
+ * recorded at a fixed rate into a preallocated ring; shots from clients are traced against the aircraft
+ * rewound to the client's view time, never further back than ac.Net.LagCompMaxRewind.
+ */
+UCLASS()
+class MYPROJECT_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterAircraft(AAAircraftBase* InAircraft);
+	void UnregisterAircraft(AAAircraftBase* InAircraft);
+	bool IsTracked(const AActor* Actor) const;
+	/** Makes a query ignore every tracked aircraft, for traces that test them separately through TraceRewound */
+	void AddTrackedAircraft(FCollisionQueryParams& Params) const;
+
+	/** Seconds to rewind for a shot fired at client ViewTime, bounded by the rewind window */
+	double GetRewindSeconds(double ViewTime) const;
+
+	/** First tracked aircraft the segment passes through with every aircraft posed at Time */
+	bool TraceRewound(const FVector& Start, const FVector& End, double Time, const AActor* IgnoreActor, FLagCompHit& OutHit) const;
+
+private:
+	void RecordFrames();
+
+	UPROPERTY()
+	TArray<TObjectPtr<AAAircraftBase>> Aircraft;
+
+	TArray<FLagCompHistory> Histories;
+
+	float TimeSinceRecord = 0.f;
+};
@@ -0,0 +1,343 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileSubsystem.h"
+
+#include "AProjectile.h"
+#include "LagCompensationSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_STATS_GROUP(TEXT("Projectiles"), STATGROUP_Projectiles, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Resolve Hits"), STAT_ProjectileResolveHits, STATGROUP_Projectiles);
+DECLARE_CYCLE_STAT(TEXT("Integrate"), STAT_ProjectileIntegrate, STATGROUP_Projectiles);
+DECLARE_CYCLE_STAT(TEXT("Resolve Rewound Hits"), STAT_ProjectileResolveRewoundHits, STATGROUP_Projectiles);
+DECLARE_CYCLE_STAT(TEXT("Queue Traces"), STAT_ProjectileQueueTraces, STATGROUP_Projectiles);
+DECLARE_CYCLE_STAT(TEXT("Update Visuals"), STAT_ProjectileUpdateVisuals, STATGROUP_Projectiles);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live Rounds"), STAT_ProjectileLiveRounds, STATGROUP_Projectiles);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Active Visuals"), STAT_ProjectileActiveVisuals, STATGROUP_Projectiles);
+
+static TAutoConsoleVariable<int32> CVarWeaponsMaxVisuals(
+	TEXT("ac.Weapons.MaxVisuals"),
+	1024,
+	TEXT("Maximum pooled projectile actors shown at once. Rounds fired beyond this are simulated but not drawn."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarWeaponsMaxTracesPerFrame(
+	TEXT("ac.Weapons.MaxTracesPerFrame"),
+	4096,
+	TEXT("Async traces queued per frame at most, round-robin over live rounds. Rounds without a trace this frame sweep their longer segment later. 0 traces every round every frame."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs CmdWeaponsStress(
+	TEXT("ac.Weapons.Stress"),
+	TEXT("ac.Weapons.Stress <Count>: fires Count authoritative rounds in random directions from the first player's pawn. Watch 'stat Projectiles', the budget itself is checked by the MyProject.Weapons.Projectiles.Budget automation test."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UProjectileSubsystem* Projectiles = World ? World->GetSubsystem<UProjectileSubsystem>() : nullptr;
+		if (!Projectiles) return;
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		const APawn* Pawn = UGameplayStatics::GetPlayerPawn(World, 0);
+		const FVector Origin = Pawn ? Pawn->GetActorLocation() : FVector::ZeroVector;
+
+		FProjectileConfig Config;
+		Config.Lifetime = 10.f;
+		for (int32 i = 0; i < Count; ++i)
+		{
+			Projectiles->FireRound(Config, Origin, FMath::VRand() * Config.MuzzleSpeed, nullptr, true);
+		}
+	}));
+
+bool UProjectileSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectileSubsystem::Deinitialize()
+{
+	Locations.Reset();
+	PreviousLocations.Reset();
+	Velocities.Reset();
+	TimesLeft.Reset();
+	DragCoefficients.Reset();
+	GravityZ.Reset();
+	Damages.Reset();
+	TraceChannels.Reset();
+	bAuthoritative.Reset();
+	RewindSeconds.Reset();
+	Instigators.Reset();
+	TraceHandles.Reset();
+	Visuals.Reset();
+	FreeVisuals.Reset();
+	NumActiveVisuals = 0;
+
+	Super::Deinitialize();
+}
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables);
+}
+
+void UProjectileSubsystem::FireRound(const FProjectileConfig& Config, const FVector& Origin, const FVector& Velocity, AActor* Instigator, bool bInAuthoritative,
+	float InRewindSeconds)
+{
+	Locations.Add(Origin);
+	PreviousLocations.Add(Origin);
+	Velocities.Add(Velocity);
+	TimesLeft.Add(Config.Lifetime);
+	DragCoefficients.Add(Config.DragCoefficient);
+	GravityZ.Add(GetWorld()->GetGravityZ() * Config.GravityScale);
+	Damages.Add(Config.Damage);
+	TraceChannels.Add(Config.TraceChannel);
+	bAuthoritative.Add(bInAuthoritative);
+	RewindSeconds.Add(bInAuthoritative ? InRewindSeconds : 0.f);
+	Instigators.Add(Instigator);
+	TraceHandles.AddDefaulted();
+
+	AAProjectile* Visual = AcquireVisual(Config.VisualClass);
+	if (Visual)
+	{
+		Visual->SetActorLocationAndRotation(Origin, Velocity.Rotation());
+	}
+	Visuals.Add(Visual);
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Last frame's traces belong to the rounds at the same indices: nothing is removed between queueing and here.
+	// Rewound rounds never queue one, their segment is resolved synchronously right after it is integrated
+	ResolveHits();
+	Integrate(DeltaTime);
+	ResolveRewoundHits();
+	QueueTraces();
+	UpdateVisuals();
+
+	SET_DWORD_STAT(STAT_ProjectileLiveRounds, Locations.Num());
+	SET_DWORD_STAT(STAT_ProjectileActiveVisuals, NumActiveVisuals);
+	LastTickMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+}
+
+void UProjectileSubsystem::ResolveHits()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileResolveHits);
+
+	UWorld* World = GetWorld();
+	FTraceDatum Datum;
+
+	// Backwards so RemoveAtSwap only ever pulls in rounds that were already checked
+	for (int32 i = Locations.Num() - 1; i >= 0; --i)
+	{
+		if (!TraceHandles[i].IsValid() || !World->QueryTraceData(TraceHandles[i], Datum)) continue;
+		if (Datum.OutHits.IsEmpty() || !Datum.OutHits[0].bBlockingHit) continue;
+
+		ApplyHit(i, Datum.OutHits[0]);
+	}
+}
+
+void UProjectileSubsystem::ResolveRewoundHits()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileResolveRewoundHits);
+
+	UWorld* World = GetWorld();
+	const ULagCompensationSubsystem* LagComp = World->GetSubsystem<ULagCompensationSubsystem>();
+	if (!LagComp) return;
+
+	// Aircraft are tested where the shooter saw them, so the world trace must only see everything else
+	FCollisionQueryParams WorldParams(SCENE_QUERY_STAT(ProjectileRewoundTrace), false);
+	bool bHaveWorldParams = false;
+
+	const double Now = World->GetTimeSeconds();
+	for (int32 i = Locations.Num() - 1; i >= 0; --i)
+	{
+		if (RewindSeconds[i] <= 0.f) continue;
+
+		if (!bHaveWorldParams)
+		{
+			LagComp->AddTrackedAircraft(WorldParams);
+			bHaveWorldParams = true;
+		}
+
+		AActor* Instigator = Instigators[i].Get();
+		FHitResult Hit;
+		bool bHit;
+		if (!Instigator || LagComp->IsTracked(Instigator))
+		{
+			bHit = World->LineTraceSingleByChannel(Hit, PreviousLocations[i], Locations[i], TraceChannels[i], WorldParams);
+		}
+		else
+		{
+			FCollisionQueryParams Params = WorldParams;
+			Params.AddIgnoredActor(Instigator);
+			bHit = World->LineTraceSingleByChannel(Hit, PreviousLocations[i], Locations[i], TraceChannels[i], Params);
+		}
+
+		// Whichever comes first along the segment: a wall in front of the rewound aircraft stops the round
+		FLagCompHit Rewound;
+		if (LagComp->TraceRewound(PreviousLocations[i], Locations[i], Now - RewindSeconds[i], Instigator, Rewound)
+			&& (!bHit || Rewound.Time < Hit.Time))
+		{
+			Hit = FHitResult(Rewound.Aircraft, Cast<UPrimitiveComponent>(Rewound.Aircraft->GetRootComponent()), Rewound.Location, Rewound.Normal);
+			Hit.TraceStart = PreviousLocations[i];
+			Hit.TraceEnd = Locations[i];
+			Hit.Time = Rewound.Time;
+			bHit = true;
+		}
+
+		if (bHit)
+		{
+			ApplyHit(i, Hit);
+		}
+	}
+}
+
+void UProjectileSubsystem::ApplyHit(int32 Index, const FHitResult& Hit)
+{
+	if (bAuthoritative[Index] && Hit.GetActor())
+	{
+		AActor* Instigator = Instigators[Index].Get();
+		UGameplayStatics::ApplyPointDamage(Hit.GetActor(), Damages[Index], Velocities[Index].GetSafeNormal(), Hit,
+			Instigator ? Instigator->GetInstigatorController() : nullptr, Instigator, UDamageType::StaticClass());
+	}
+
+	if (Visuals[Index])
+	{
+		Visuals[Index]->SetActorLocation(Hit.ImpactPoint);
+		Visuals[Index]->ReceiveImpact(Hit);
+	}
+	OnRoundHit.Broadcast(Hit, bAuthoritative[Index] != 0);
+	RemoveRound(Index);
+}
+
+void UProjectileSubsystem::Integrate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileIntegrate);
+
+	for (int32 i = Locations.Num() - 1; i >= 0; --i)
+	{
+		TimesLeft[i] -= DeltaTime;
+		if (TimesLeft[i] <= 0.f)
+		{
+			RemoveRound(i);
+			continue;
+		}
+
+		// Gravity plus quadratic drag, semi-implicit Euler like the flight model
+		FVector& Velocity = Velocities[i];
+		const FVector Accel = FVector(0.f, 0.f, GravityZ[i]) - Velocity * (Velocity.Size() * DragCoefficients[i]);
+		Velocity += Accel * DeltaTime;
+
+		// A segment the trace budget skipped keeps its start, so the next trace covers every frame since.
+		// Rewound rounds are tested every frame in ResolveRewoundHits
+		if (TraceHandles[i].IsValid() || RewindSeconds[i] > 0.f)
+		{
+			PreviousLocations[i] = Locations[i];
+		}
+		Locations[i] += Velocity * DeltaTime;
+	}
+}
+
+void UProjectileSubsystem::QueueTraces()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileQueueTraces);
+
+	UWorld* World = GetWorld();
+	const int32 NumRounds = Locations.Num();
+	const int32 MaxTraces = CVarWeaponsMaxTracesPerFrame.GetValueOnGameThread();
+	const int32 NumTraces = MaxTraces > 0 ? FMath::Min(MaxTraces, NumRounds) : NumRounds;
+
+	for (FTraceHandle& Handle : TraceHandles)
+	{
+		Handle = FTraceHandle();
+	}
+	for (int32 n = 0; n < NumTraces; ++n)
+	{
+		const int32 i = (NextTraceRound + n) % NumRounds;
+		if (RewindSeconds[i] > 0.f) continue;
+
+		const FCollisionQueryParams Params(SCENE_QUERY_STAT(ProjectileTrace), false, Instigators[i].Get());
+		TraceHandles[i] = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, PreviousLocations[i], Locations[i], TraceChannels[i], Params);
+	}
+	NextTraceRound = NumRounds > 0 ? (NextTraceRound + NumTraces) % NumRounds : 0;
+}
+
+void UProjectileSubsystem::UpdateVisuals()
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileUpdateVisuals);
+
+	if (NumActiveVisuals == 0) return;
+
+	for (int32 i = 0; i < Visuals.Num(); ++i)
+	{
+		if (AAProjectile* Visual = Visuals[i])
+		{
+			Visual->SetActorLocationAndRotation(Locations[i], Velocities[i].Rotation());
+		}
+	}
+}
+
+void UProjectileSubsystem::RemoveRound(int32 Index)
+{
+	if (Visuals[Index])
+	{
+		ReleaseVisual(Visuals[Index]);
+	}
+
+	Locations.RemoveAtSwap(Index, EAllowShrinking::No);
+	PreviousLocations.RemoveAtSwap(Index, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, EAllowShrinking::No);
+	TimesLeft.RemoveAtSwap(Index, EAllowShrinking::No);
+	DragCoefficients.RemoveAtSwap(Index, EAllowShrinking::No);
+	GravityZ.RemoveAtSwap(Index, EAllowShrinking::No);
+	Damages.RemoveAtSwap(Index, EAllowShrinking::No);
+	TraceChannels.RemoveAtSwap(Index, EAllowShrinking::No);
+	bAuthoritative.RemoveAtSwap(Index, EAllowShrinking::No);
+	RewindSeconds.RemoveAtSwap(Index, EAllowShrinking::No);
+	Instigators.RemoveAtSwap(Index, EAllowShrinking::No);
+	TraceHandles.RemoveAtSwap(Index, EAllowShrinking::No);
+	Visuals.RemoveAtSwap(Index, EAllowShrinking::No);
+}
+
+AAProjectile* UProjectileSubsystem::AcquireVisual(TSubclassOf<AAProjectile> VisualClass)
+{
+	UWorld* World = GetWorld();
+	if (!VisualClass || World->GetNetMode() == NM_DedicatedServer) return nullptr;
+	if (NumActiveVisuals >= CVarWeaponsMaxVisuals.GetValueOnGameThread()) return nullptr;
+
+	AAProjectile* Visual = nullptr;
+	for (int32 i = FreeVisuals.Num() - 1; i >= 0; --i)
+	{
+		if (FreeVisuals[i] && FreeVisuals[i]->GetClass() == VisualClass)
+		{
+			Visual = FreeVisuals[i];
+			FreeVisuals.RemoveAtSwap(i, EAllowShrinking::No);
+			break;
+		}
+	}
+
+	if (!Visual)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		Visual = World->SpawnActor<AAProjectile>(VisualClass, FTransform::Identity, SpawnParams);
+		if (!Visual) return nullptr;
+	}
+
+	Visual->ActivateVisual();
+	++NumActiveVisuals;
+	return Visual;
+}
+
+void UProjectileSubsystem::ReleaseVisual(AAProjectile* Visual)
+{
+	Visual->DeactivateVisual();
+	FreeVisuals.Add(Visual);
+	--NumActiveVisuals;
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "MyProject/GCore/Config.h"
+#include "ProjectileSubsystem.generated.h"
+
+class AAProjectile;
+
+/** A round hit something: the hit, and whether the round was the server's (damage was applied) */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnProjectileHit, const FHitResult& /*Hit*/, bool /*bAuthoritative*/);
+
+/**
+ * Every live round in the world, stored as a structure of arrays and advanced in one pass per frame.
+ * Each round's swept segment is queued as an async line trace so the engine runs them as one batch off the
+ * game thread; results are read back the following frame. At most ac.Weapons.MaxTracesPerFrame rounds are traced
+ * per frame, the others keep growing their segment until their turn comes round. Rounds are plain data: actors only exist for the
+ * visuals and are recycled from a pool, and dedicated servers never create them.
+ * Lag-compensated rounds are not queued: they are tested in the same frame, synchronously against world geometry
+ * and against the rewound aircraft, and the nearer hit wins.
+ */
+UCLASS()
+class MYPROJECT_API UProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * Puts a round into the air. Authoritative rounds apply damage on hit; cosmetic ones (client copies of
+	 * server fire) only play the impact. Rounds fired by a client pass RewindSeconds so they are tested
+	 * against aircraft where that client saw them (see ULagCompensationSubsystem).
+	 */
+	void FireRound(const FProjectileConfig& Config, const FVector& Origin, const FVector& Velocity, AActor* Instigator, bool bAuthoritative,
+		float RewindSeconds = 0.f);
+
+	int32 GetNumLiveRounds() const { return Locations.Num(); }
+	/** Every impact, after damage was applied */
+	FOnProjectileHit OnRoundHit;
+
+	/** Game-thread time of the last Tick */
+	double GetLastTickMilliseconds() const { return LastTickMilliseconds; }
+
+private:
+	void ResolveHits();
+	void Integrate(float DeltaTime);
+	void ResolveRewoundHits();
+	void QueueTraces();
+	void UpdateVisuals();
+	void RemoveRound(int32 Index);
+	void ApplyHit(int32 Index, const FHitResult& Hit);
+
+	AAProjectile* AcquireVisual(TSubclassOf<AAProjectile> VisualClass);
+	void ReleaseVisual(AAProjectile* Visual);
+
+	// --- Rounds ---
+	TArray<FVector> Locations;
+	TArray<FVector> PreviousLocations;
+	TArray<FVector> Velocities;
+	TArray<float> TimesLeft;
+	TArray<float> DragCoefficients;
+	TArray<float> GravityZ;
+	TArray<float> Damages;
+	TArray<TEnumAsByte<ECollisionChannel>> TraceChannels;
+	TArray<uint8> bAuthoritative;
+	TArray<float> RewindSeconds;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+	/** Trace queued for each round's last segment, invalid for rounds fired or skipped by the trace budget this frame */
+	TArray<FTraceHandle> TraceHandles;
+	/** First round to get a trace next frame when the budget does not cover all of them */
+	int32 NextTraceRound = 0;
+	double LastTickMilliseconds = 0.0;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AAProjectile>> Visuals;
+
+	// --- Visual pool ---
+	UPROPERTY()
+	TArray<TObjectPtr<AAProjectile>> FreeVisuals;
+
+	int32 NumActiveVisuals = 0;
+};
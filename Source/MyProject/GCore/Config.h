@@ -2,6 +2,7 @@
 
 #include "Config/FlightConfigs.h"
 #include "Config/EnvConfigs.h"
+#include "Config/WeaponConfigs.h"
 
 #define PRINTSCREEN(Text) \
 if (GEngine) { \
@@ -0,0 +1,172 @@
+﻿#include "AeroTableAsset.h"
+#include "Misc/CoreDelegates.h"
+
+// Piecewise linear over points sorted by Key, clamped at both ends
+template<typename PointType, typename KeyFunc, typename ValueFunc>
+static float InterpolatePoints(const TArray<PointType>& Points, float At, KeyFunc Key, ValueFunc Value)
+{
+    if (Points.IsEmpty()) return 0.f;
+    if (At <= Key(Points[0])) return Value(Points[0]);
+
+    for (int32 i = 1; i < Points.Num(); ++i)
+    {
+        if (At <= Key(Points[i]))
+        {
+            const float Span = Key(Points[i]) - Key(Points[i - 1]);
+            const float Alpha = Span > UE_KINDA_SMALL_NUMBER ? (At - Key(Points[i - 1])) / Span : 1.f;
+            return FMath::Lerp(Value(Points[i - 1]), Value(Points[i]), Alpha);
+        }
+    }
+    return Value(Points.Last());
+}
+
+static FAeroCoefficients LerpCoefficients(const TArray<FAeroCoefficients>& Samples, float Position)
+{
+    const int32 Index = FMath::Clamp(static_cast<int32>(Position), 0, Samples.Num() - 2);
+    const float Alpha = FMath::Clamp(Position - Index, 0.f, 1.f);
+    const FAeroCoefficients& A = Samples[Index];
+    const FAeroCoefficients& B = Samples[Index + 1];
+
+    FAeroCoefficients Result;
+    Result.Lift   = FMath::Lerp(A.Lift, B.Lift, Alpha);
+    Result.Drag   = FMath::Lerp(A.Drag, B.Drag, Alpha);
+    Result.Side   = FMath::Lerp(A.Side, B.Side, Alpha);
+    Result.Moment = FMath::Lerp(A.Moment, B.Moment, Alpha);
+    return Result;
+}
+
+FAeroCoefficients FAeroTable::Sample(float CosAngle, bool bNegativeAngle, float SinSideslip, float Mach) const
+{
+    // sin(a/2) = sqrt((1 - cos a) / 2)
+    const float HalfAngleSin = FMath::Sqrt(FMath::Clamp((1.f - CosAngle) * 0.5f, 0.f, 1.f));
+    FAeroCoefficients Result = LerpCoefficients(bNegativeAngle ? NegativeAngle : PositiveAngle, HalfAngleSin * (AngleSamples - 1));
+
+    if (!Sideslip.IsEmpty())
+    {
+        const FAeroCoefficients Slip = LerpCoefficients(Sideslip, (FMath::Clamp(SinSideslip, -1.f, 1.f) + 1.f) * 0.5f * (SideslipSamples - 1));
+        Result.Side = Slip.Side;
+        Result.Drag += Slip.Drag;
+    }
+
+    if (!MachDragScale.IsEmpty())
+    {
+        const float Position = FMath::Clamp(Mach / MaxMach, 0.f, 1.f) * (MachSamples - 1);
+        const int32 Index = FMath::Min(static_cast<int32>(Position), MachSamples - 2);
+        Result.Drag *= FMath::Lerp(MachDragScale[Index], MachDragScale[Index + 1], Position - Index);
+    }
+
+    return Result;
+}
+
+void UAeroTableAsset::PostLoad()
+{
+    Super::PostLoad();
+    // Nothing flies with the asset before it has loaded, so the first bake goes straight into the live table
+    Bake(Table);
+}
+
+void UAeroTableAsset::BeginDestroy()
+{
+    FCoreDelegates::OnBeginFrame.Remove(SwapHandle);
+    SwapHandle.Reset();
+    PendingTable.Reset();
+
+    Super::BeginDestroy();
+}
+
+#if WITH_EDITOR
+void UAeroTableAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // Batched flight may be reading Table on worker threads, the swap waits for the frame boundary
+    PendingTable = MakeUnique<FAeroTable>();
+    Bake(*PendingTable);
+    if (!SwapHandle.IsValid())
+    {
+        SwapHandle = FCoreDelegates::OnBeginFrame.AddUObject(this, &UAeroTableAsset::SwapInPendingTable);
+    }
+}
+#endif
+
+void UAeroTableAsset::SwapInPendingTable()
+{
+    FCoreDelegates::OnBeginFrame.Remove(SwapHandle);
+    SwapHandle.Reset();
+
+    if (PendingTable)
+    {
+        Table = MoveTemp(*PendingTable);
+        PendingTable.Reset();
+    }
+}
+
+void UAeroTableAsset::Bake(FAeroTable& OutTable) const
+{
+    OutTable = FAeroTable();
+    OutTable.PitchMomentRate = PitchMomentRate;
+    OutTable.ReferenceSpeed = FMath::Max(ReferenceSpeed, 1.f);
+    if (AngleOfAttack.IsEmpty()) return;
+
+    auto AngleKey = [](const FAeroPolarPoint& Point) { return Point.AngleDegrees; };
+    auto PolarAt = [this, &AngleKey](float AngleDegrees)
+    {
+        FAeroCoefficients Result;
+        Result.Lift   = InterpolatePoints(AngleOfAttack, AngleDegrees, AngleKey, [](const FAeroPolarPoint& Point) { return Point.Lift; });
+        Result.Drag   = InterpolatePoints(AngleOfAttack, AngleDegrees, AngleKey, [](const FAeroPolarPoint& Point) { return Point.Drag; });
+        Result.Moment = InterpolatePoints(AngleOfAttack, AngleDegrees, AngleKey, [](const FAeroPolarPoint& Point) { return Point.Moment; });
+        return Result;
+    };
+
+    // Trig is fine here, this runs once per asset
+    OutTable.PositiveAngle.SetNum(FAeroTable::AngleSamples);
+    OutTable.NegativeAngle.SetNum(FAeroTable::AngleSamples);
+    float StallDegrees = 180.f;
+    bool bFoundStall = false;
+    for (int32 i = 0; i < FAeroTable::AngleSamples; ++i)
+    {
+        const float HalfAngleSin = float(i) / (FAeroTable::AngleSamples - 1);
+        const float AngleDegrees = FMath::RadiansToDegrees(2.f * FMath::Asin(HalfAngleSin));
+        OutTable.PositiveAngle[i] = PolarAt(AngleDegrees);
+        OutTable.NegativeAngle[i] = PolarAt(-AngleDegrees);
+
+        // First lift peak on the positive side is the stall: the last angle before lift starts to fall.
+        // Post-stall humps further out (flat-plate lift near 45 degrees) do not count even when higher
+        if (!bFoundStall && AngleDegrees <= 90.f)
+        {
+            if (i > 0 && OutTable.PositiveAngle[i].Lift < OutTable.PositiveAngle[i - 1].Lift)
+            {
+                bFoundStall = true;
+            }
+            else
+            {
+                StallDegrees = AngleDegrees;
+            }
+        }
+    }
+    OutTable.StallCos = FMath::Cos(FMath::DegreesToRadians(StallDegrees));
+
+    if (!Sideslip.IsEmpty())
+    {
+        auto SlipKey = [](const FAeroSideslipPoint& Point) { return Point.AngleDegrees; };
+        OutTable.Sideslip.SetNum(FAeroTable::SideslipSamples);
+        for (int32 i = 0; i < FAeroTable::SideslipSamples; ++i)
+        {
+            const float SinSlip = 2.f * i / (FAeroTable::SideslipSamples - 1) - 1.f;
+            const float AngleDegrees = FMath::RadiansToDegrees(FMath::Asin(SinSlip));
+            OutTable.Sideslip[i].Side = InterpolatePoints(Sideslip, AngleDegrees, SlipKey, [](const FAeroSideslipPoint& Point) { return Point.Side; });
+            OutTable.Sideslip[i].Drag = InterpolatePoints(Sideslip, AngleDegrees, SlipKey, [](const FAeroSideslipPoint& Point) { return Point.Drag; });
+        }
+    }
+
+    if (!Mach.IsEmpty())
+    {
+        auto MachKey = [](const FAeroMachPoint& Point) { return Point.Mach; };
+        OutTable.MachDragScale.SetNum(FAeroTable::MachSamples);
+        for (int32 i = 0; i < FAeroTable::MachSamples; ++i)
+        {
+            const float AtMach = FAeroTable::MaxMach * i / (FAeroTable::MachSamples - 1);
+            OutTable.MachDragScale[i] = InterpolatePoints(Mach, AtMach, MachKey, [](const FAeroMachPoint& Point) { return Point.DragScale; });
+        }
+    }
+}
@@ -0,0 +1,140 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "AeroTableAsset.generated.h"
+
+/** One authored point of the polar: coefficients at an angle of attack */
+USTRUCT(BlueprintType)
+struct FAeroPolarPoint
+{
+    GENERATED_BODY()
+
+    /** Angle of attack (deg), positive with the nose above the flight path */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float AngleDegrees = 0.f;
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float Lift = 0.f;
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float Drag = 0.f;
+    /** Pitching moment, positive pitches the nose up */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float Moment = 0.f;
+};
+
+/** Side force and extra drag at a sideslip angle */
+USTRUCT(BlueprintType)
+struct FAeroSideslipPoint
+{
+    GENERATED_BODY()
+
+    /** Sideslip (deg), positive with the air coming from the right */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float AngleDegrees = 0.f;
+    /** Side force along the right wing */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float Side = 0.f;
+    /** Added to the polar's drag */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float Drag = 0.f;
+};
+
+/** Compressibility: drag multiplier at a Mach number */
+USTRUCT(BlueprintType)
+struct FAeroMachPoint
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float Mach = 0.f;
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Aero")
+    float DragScale = 1.f;
+};
+
+struct FAeroCoefficients
+{
+    float Lift = 0.f;
+    float Drag = 0.f;
+    float Side = 0.f;
+    float Moment = 0.f;
+};
+
+/**
+ * Coefficients resampled onto uniform tables at load. The angle of attack axis is sin(|AoA|/2), which comes
+ * out of the cosine with one square root and is close to linear in the angle, so small angles keep their
+ * resolution and a lookup needs no trig at all.
+ */
+struct MYPROJECT_API FAeroTable
+{
+    static constexpr int32 AngleSamples = 256;
+    static constexpr int32 SideslipSamples = 64;
+    static constexpr int32 MachSamples = 32;
+    static constexpr float MaxMach = 4.f;
+    /** cm/s */
+    static constexpr float SpeedOfSound = 34300.f;
+
+    /** Indexed by sin(|AoA|/2), one table per sign of the angle */
+    TArray<FAeroCoefficients> PositiveAngle;
+    TArray<FAeroCoefficients> NegativeAngle;
+    /** Indexed by sin(sideslip) over [-1, 1], only Side and Drag are used */
+    TArray<FAeroCoefficients> Sideslip;
+    TArray<float> MachDragScale;
+
+    /** Cosine of the stall: the first positive angle the lift peaks at. The airframe is stalled at or below it */
+    float StallCos = -2.f;
+    /** See UAeroTableAsset */
+    float PitchMomentRate = 0.f;
+    float ReferenceSpeed = 1.f;
+
+    bool IsValid() const { return !PositiveAngle.IsEmpty(); }
+
+    /**
+     * CosAngle = dot(Forward, VelocityDir). bNegativeAngle when the nose is below the flight path,
+     * SinSideslip = dot(VelocityDir, Right).
+     */
+    FAeroCoefficients Sample(float CosAngle, bool bNegativeAngle, float SinSideslip, float Mach) const;
+};
+
+/**
+ * Lift, drag and moment curves of one airframe, shared by every aircraft that references it.
+ * Authored as sorted points, baked into FAeroTable once when the asset loads. Edits bake into a separate table
+ * that replaces the live one at the start of the next frame, so flight steps never read a half-built table.
+ */
+UCLASS(BlueprintType)
+class MYPROJECT_API UAeroTableAsset : public UDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    /** Polar over the full circle, sorted by angle. Should cover -180 to 180 */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Aero|Angle of Attack")
+    TArray<FAeroPolarPoint> AngleOfAttack;
+    /** Sorted by angle, -90 to 90. Empty means no side force */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Aero|Sideslip")
+    TArray<FAeroSideslipPoint> Sideslip;
+    /** Sorted by Mach. Empty means no compressibility drag */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Aero|Mach")
+    TArray<FAeroMachPoint> Mach;
+    /** Pitch rate (deg/s) a moment coefficient of 1 produces at ReferenceSpeed, grows with dynamic pressure */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Aero|Moment")
+    float PitchMomentRate = 30.f;
+    /** cm/s */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Aero|Moment")
+    float ReferenceSpeed = 8000.f;
+
+    const FAeroTable& GetTable() const { return Table; }
+
+    virtual void PostLoad() override;
+    virtual void BeginDestroy() override;
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+    void Bake(FAeroTable& OutTable) const;
+    void SwapInPendingTable();
+
+    FAeroTable Table;
+    /** Baked from an edit, waiting for the next frame to become Table */
+    TUniquePtr<FAeroTable> PendingTable;
+    FDelegateHandle SwapHandle;
+};
@@ -0,0 +1,14 @@
+﻿#include "AirframeAsset.h"
+
+const FPrimaryAssetType UAirframeAsset::PrimaryAssetType(TEXT("Airframe"));
+
+const FBaseFlightConfig& UAirframeAsset::GetBaseConfig() const
+{
+    if (FlightType == EFlightType::Drone) return Drone;
+    return Aircraft;
+}
+
+FPrimaryAssetId UAirframeAsset::GetPrimaryAssetId() const
+{
+    return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "FlightConfigs.h"
+#include "AirframeAsset.generated.h"
+
+/**
+ * Flight definition of one airframe type, loaded once and referenced by every aircraft flying it.
+ * Aircraft read it through the pointer each step, so edits reach all live aircraft of the type.
+ */
+UCLASS(BlueprintType)
+class MYPROJECT_API UAirframeAsset : public UPrimaryDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    static const FPrimaryAssetType PrimaryAssetType;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Flight")
+    EFlightType FlightType = EFlightType::Aircraft;
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Flight", meta=(EditCondition="FlightType == EFlightType::Aircraft", EditConditionHides))
+    FAircraftConfig Aircraft;
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Flight", meta=(EditCondition="FlightType == EFlightType::Drone", EditConditionHides))
+    FDroneConfig Drone;
+
+    /** Mass, g limit and gravity of whichever config FlightType selects */
+    const FBaseFlightConfig& GetBaseConfig() const;
+
+    /** Stands in for aircraft that have no airframe assigned: the default configs, shared */
+    static const UAirframeAsset& GetFallback() { return *GetDefault<UAirframeAsset>(); }
+
+    virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+};
@@ -17,4 +17,85 @@ struct FEnvAirflow
 	float TurbulenceStrength = 0.f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float UpdraftForce = 0.f;
-};
\ No newline at end of file
+};
+
+/**
+ * Rising column of warm air, strongest at the centre and fading out towards TopAltitude
+ */
+USTRUCT(BlueprintType)
+struct FAirflowThermal
+{
+	GENERATED_BODY()
+	/** Ground position of the column (Z ignored) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	FVector Center = FVector::ZeroVector;
+	/** Distance (cm) at which the lift has dropped to ~37% */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	float Radius = 30000.f;
+	/** Updraft force at the core, same units as FEnvAirflow::UpdraftForce */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	float Strength = 200000.f;
+	/** Altitude (cm) the thermal tops out at */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	float TopAltitude = 200000.f;
+};
+
+/**
+ * Slope lift along a ridge line, only produced while the base wind blows across the ridge
+ */
+USTRUCT(BlueprintType)
+struct FAirflowRidge
+{
+	GENERATED_BODY()
+	/** Ridge line on the ground (Z ignored) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	FVector Start = FVector::ZeroVector;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	FVector End = FVector(100000.f, 0.f, 0.f);
+	/** Distance (cm) from the ridge line at which the lift has dropped to ~37% */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	float Width = 20000.f;
+	/** Updraft force with the wind straight across the ridge */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	float Strength = 150000.f;
+	/** Altitude (cm) the lift fades out at */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	float TopAltitude = 100000.f;
+};
+
+/**
+ * Map-wide airflow, baked into a coarse grid by UAirflowFieldSubsystem
+ */
+USTRUCT(BlueprintType)
+struct FAirflowFieldConfig
+{
+	GENERATED_BODY()
+	/** Volume the grid covers, samples outside are clamped to the border cells */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Grid")
+	FBox Bounds = FBox(FVector(-1000000.f, -1000000.f, 0.f), FVector(1000000.f, 1000000.f, 300000.f));
+	/** Horizontal cell size (cm) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Grid")
+	float CellSize = 20000.f;
+	/** Vertical cell size (cm) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Grid")
+	float CellHeight = 10000.f;
+	/** Wind force everywhere, also decides which side of a ridge gets lift */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Wind")
+	FVector BaseWind = FVector::ZeroVector;
+	/** Turbulence force everywhere, thermals and ridges add to it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Turbulence")
+	float BaseTurbulence = 0.f;
+	/** Share of a thermal's or ridge's lift that becomes turbulence */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Turbulence")
+	float LiftTurbulenceRatio = 0.2f;
+	/** Size (cm) of the turbulent eddies */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Turbulence")
+	float TurbulenceScale = 20000.f;
+	/** Speed (cm/s) the turbulence pattern drifts through space */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow|Turbulence")
+	float TurbulenceDrift = 1000.f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	TArray<FAirflowThermal> Thermals;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Airflow")
+	TArray<FAirflowRidge> Ridges;
+};
@@ -1,6 +1,7 @@
 ﻿#pragma once
 #include "CoreMinimal.h"
 #include "FlightConfigs.generated.h"
+class UAeroTableAsset;
 /**
  * Flight type enum to switch configs dynamically
  */
@@ -56,6 +57,9 @@ struct FAircraftConfig : public FBaseFlightConfig
     /** Stall angle threshold (deg) */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight|Aerodynamics")
     float StallAngleDegrees = 45.f;
+    /** Lift, drag and moment curves. When set they replace the constant coefficients, the stall angle and the stability torque */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight|Aerodynamics")
+    TObjectPtr<UAeroTableAsset> AeroTable = nullptr;
     /** Natural stability torque (restoring moment) */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Flight|Stability")
     float StabilityTorque = 1000.f;
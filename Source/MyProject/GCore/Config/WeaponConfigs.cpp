@@ -0,0 +1 @@
+﻿#include "WeaponConfigs.h"
@@ -0,0 +1,37 @@
+﻿#pragma once
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "WeaponConfigs.generated.h"
+
+class AAProjectile;
+
+/**
+ * Ballistics of one kind of round, simulated by UProjectileSubsystem
+ */
+USTRUCT(BlueprintType)
+struct FProjectileConfig
+{
+    GENERATED_BODY()
+
+    /** Speed relative to the shooter when leaving the muzzle (cm/s) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Ballistics")
+    float MuzzleSpeed = 100000.f;
+    /** Quadratic drag, deceleration = DragCoefficient * speed² (1/cm) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Ballistics")
+    float DragCoefficient = 0.000002f;
+    /** Global gravity scale modifier */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Ballistics")
+    float GravityScale = 1.f;
+    /** Seconds before an unspent round is removed */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Ballistics")
+    float Lifetime = 3.f;
+    /** Damage applied to whatever the round hits */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Damage")
+    float Damage = 10.f;
+    /** Channel the round's swept trace runs against */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Damage")
+    TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+    /** Pooled actor drawn for the round; none means the round is invisible */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Projectile|Visuals")
+    TSubclassOf<AAProjectile> VisualClass;
+};
@@ -1,34 +1,18 @@
 #include "ACGameModeBase.h"
 #include "GameFramework/PlayerStart.h"
-#include "Kismet/GameplayStatics.h"
-#include "GameFramework/Pawn.h"
 #include "EngineUtils.h" // for TActorIterator
+#include "MyProject/Aircraft/AircraftSpatialSubsystem.h"
 
 AActor* AACGameModeBase::ChoosePlayerStart_Implementation(AController* Player)
 {
-	TArray<AActor*> Starts;
-	UGameplayStatics::GetAllActorsOfClass(this, APlayerStart::StaticClass(), Starts);
+	const UAircraftSpatialSubsystem* Spatial = GetWorld()->GetSubsystem<UAircraftSpatialSubsystem>();
 
-	for (AActor* Start : Starts)
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
 	{
 		// Check if occupied
-		bool bOccupied = false;
-
-		for (TActorIterator<APawn> It(GetWorld()); It; ++It)
-		{
-			if (APawn* OtherPawn = *It)
-			{
-				if (OtherPawn->GetActorLocation().Equals(Start->GetActorLocation(), 10.f))
-				{
-					bOccupied = true;
-					break;
-				}
-			}
-		}
-
-		if (!bOccupied)
+		if (!Spatial || !Spatial->IsAnyAircraftWithin(It->GetActorLocation(), 10.f))
 		{
-			return Start; // Use the first free spawn
+			return *It; // Use the first free spawn
 		}
 	}
 
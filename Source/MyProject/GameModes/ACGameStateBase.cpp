@@ -3,3 +3,14 @@
 
 #include "ACGameStateBase.h"
 
+#include "MyProject/Aircraft/AirflowFieldSubsystem.h"
+
+void AACGameStateBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UAirflowFieldSubsystem* Airflow = GetWorld()->GetSubsystem<UAirflowFieldSubsystem>())
+	{
+		Airflow->SetConfig(AirflowField);
+	}
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameStateBase.h"
+#include "MyProject/GCore/Config.h"
 #include "ACGameStateBase.generated.h"
 
 /**
@@ -13,5 +14,13 @@ UCLASS()
 class MYPROJECT_API AACGameStateBase : public AGameStateBase
 {
 	GENERATED_BODY()
+
+public:
+	// Airflow over the map, set on the Blueprint so the server and every client build the same field
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Environment")
+	FAirflowFieldConfig AirflowField;
+
+protected:
+	virtual void BeginPlay() override;
 	
 };
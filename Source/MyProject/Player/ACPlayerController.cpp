@@ -7,7 +7,7 @@
 #include "InputMappingContext.h"
 #include "InputAction.h"
 #include "InputActionValue.h"
-
+#include "MyProject/Aircraft/FlightStats.h"
 
 void AACPlayerController::SetupInputComponent()
 {
@@ -37,38 +37,59 @@ void AACPlayerController::SetupInputComponent()
 }
 
 
+template <typename ValueType>
+void AACPlayerController::SetPilotAxis(ValueType& Axis, const ValueType& Value)
+{
+	// A held stick keeps triggering Ongoing with the same value, that is no new input for the aircraft
+	if (Axis == Value) return;
+	Axis = Value;
+	StampPilotInput();
+}
+
+void AACPlayerController::StampPilotInput()
+{
+	PilotInput.Timestamp = FPlatformTime::Seconds();
+	++PilotInput.Serial;
+}
+
 void AACPlayerController::ProcessSteer(const FInputActionValue& Value)
 {
-	FVector2D Input = Value.Get<FVector2D>();
-	OnSteerInput.Broadcast(Input);
+	FLIGHT_SCOPE(Flight, PilotInput);
+	SetPilotAxis(PilotInput.Steering, Value.Get<FVector2D>());
+	if (OnSteerInput.IsBound()) OnSteerInput.Broadcast(PilotInput.Steering);
 }
 
 void AACPlayerController::ProcessYaw(const FInputActionValue& Value)
 {
-	float Input = Value.Get<float>();
-	OnYawInput.Broadcast(Input);
+	FLIGHT_SCOPE(Flight, PilotInput);
+	SetPilotAxis(PilotInput.Yaw, Value.Get<float>());
+	if (OnYawInput.IsBound()) OnYawInput.Broadcast(PilotInput.Yaw);
 }
 
 void AACPlayerController::ResetThrust(const FInputActionValue& Value)
 {
-	OnThrustInput.Broadcast(0);
+	FLIGHT_SCOPE(Flight, PilotInput);
+	SetPilotAxis(PilotInput.Thrust, 0.f);
+	if (OnThrustInput.IsBound()) OnThrustInput.Broadcast(0);
 }
 
 void AACPlayerController::ResetSteer(const FInputActionValue& Value)
 {
-	FVector2D Input = FVector2D::ZeroVector;
-	OnSteerInput.Broadcast(Input);
-
+	FLIGHT_SCOPE(Flight, PilotInput);
+	SetPilotAxis(PilotInput.Steering, FVector2D::ZeroVector);
+	if (OnSteerInput.IsBound()) OnSteerInput.Broadcast(PilotInput.Steering);
 }
 
 void AACPlayerController::ResetYaw(const FInputActionValue& Value)
 {
-	OnYawInput.Broadcast(0);
-
+	FLIGHT_SCOPE(Flight, PilotInput);
+	SetPilotAxis(PilotInput.Yaw, 0.f);
+	if (OnYawInput.IsBound()) OnYawInput.Broadcast(0);
 }
 
 void AACPlayerController::ProcessThrust(const FInputActionValue& Value)
 {
-	float Input = Value.Get<float>();
-	OnThrustInput.Broadcast(Input);
+	FLIGHT_SCOPE(Flight, PilotInput);
+	SetPilotAxis(PilotInput.Thrust, Value.Get<float>());
+	if (OnThrustInput.IsBound()) OnThrustInput.Broadcast(PilotInput.Thrust);
 }
@@ -15,6 +15,18 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSteerInput, FVector2D, Value);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnYawInput, float, Value);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnThrustInput, float, Value);
 
+/** Latest value of every flight axis, written by Enhanced Input and read by the possessed aircraft before each flight step */
+struct FPilotInputSample
+{
+	float Thrust = 0.f;
+	FVector2D Steering = FVector2D::ZeroVector;
+	float Yaw = 0.f;
+	// FPlatformTime::Seconds() of the last change
+	double Timestamp = 0.0;
+	// Bumped whenever a value changes, tells a reader whether it has already consumed this sample
+	uint32 Serial = 0;
+};
+
 UCLASS()
 class MYPROJECT_API AACPlayerController : public APlayerController
 {
@@ -25,7 +37,9 @@ class MYPROJECT_API AACPlayerController : public APlayerController
 
 public:
 	// MOVEMENT INPUTS
-	// Delegates (events other classes can bind to)
+	// Flight reads this directly, no delegate involved
+	const FPilotInputSample& GetPilotInput() const { return PilotInput; }
+	// Delegates for Blueprint listeners, only broadcast while something is bound
 	UPROPERTY(BlueprintAssignable, Category="Input")
 	FOnSteerInput OnSteerInput;
 	UPROPERTY(BlueprintAssignable, Category="Input")
@@ -39,6 +53,11 @@ private:
 	UInputAction* IA_Steer;
 	UPROPERTY(EditAnywhere, Category = "Input")
 	UInputAction* IA_Yaw;
+	FPilotInputSample PilotInput;
+	// Stores Value and stamps the sample, unless the axis already held it
+	template <typename ValueType>
+	void SetPilotAxis(ValueType& Axis, const ValueType& Value);
+	void StampPilotInput();
 	void ProcessThrust(const FInputActionValue& Value);
 	void ProcessSteer(const FInputActionValue& Value);
 	void ProcessYaw(const FInputActionValue& Value);
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/AI/AIPilotSubsystem.h"
+#include "MyProject/Aircraft/AEnemyAircraft.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAIPilotThinkBudgetTest, "MyProject.AI.Pilots.ThinkBudget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FAIPilotThinkBudgetTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumBots = 200;
+	static constexpr float StepSeconds = 1.f / 60.f;
+	static constexpr int32 NumWarmupFrames = 10;
+	static constexpr int32 NumFrames = 120;
+
+	FFlightTestWorld TestWorld;
+	UAIPilotSubsystem* PilotSubsystem = TestWorld.World->GetSubsystem<UAIPilotSubsystem>();
+	if (!TestNotNull(TEXT("AI pilot subsystem"), PilotSubsystem)) return false;
+
+	const IConsoleVariable* BudgetVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("ac.AI.ThinkBudgetMs"));
+	if (!TestNotNull(TEXT("ac.AI.ThinkBudgetMs"), BudgetVariable)) return false;
+	const double BudgetMilliseconds = BudgetVariable->GetFloat();
+
+	// Same spread as ac.AI.SpawnBots, seeded so every run sees the same encounters
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	FRandomStream Random(1234);
+	for (int32 i = 0; i < NumBots; ++i)
+	{
+		const FVector Location(Random.FRandRange(-1000000.0, 1000000.0), Random.FRandRange(-1000000.0, 1000000.0), Random.FRandRange(100000.0, 300000.0));
+		TestWorld.World->SpawnActor<AAEnemyAircraft>(Location, FRotator(0.0, Random.FRandRange(0.0, 360.0), 0.0), SpawnParams);
+	}
+	if (!TestEqual(TEXT("Possessed bots"), PilotSubsystem->GetNumPilots(), NumBots)) return false;
+
+	double TotalMilliseconds = 0.0;
+	double WorstMilliseconds = 0.0;
+	for (int32 Frame = 0; Frame < NumWarmupFrames + NumFrames; ++Frame)
+	{
+		TestWorld.Tick(StepSeconds);
+		if (Frame < NumWarmupFrames) continue;
+
+		TotalMilliseconds += PilotSubsystem->GetLastThinkMilliseconds();
+		WorstMilliseconds = FMath::Max(WorstMilliseconds, PilotSubsystem->GetLastThinkMilliseconds());
+	}
+
+	const double MeanMilliseconds = TotalMilliseconds / NumFrames;
+	AddInfo(FString::Printf(TEXT("%d bots: %.3f ms mean, %.3f ms worst think time per frame (budget %.2f ms)"),
+		NumBots, MeanMilliseconds, WorstMilliseconds, BudgetMilliseconds));
+	TestTrue(FString::Printf(TEXT("Mean think %.3f ms within %.2f ms"), MeanMilliseconds, BudgetMilliseconds), MeanMilliseconds <= BudgetMilliseconds);
+	return true;
+}
+
+#endif
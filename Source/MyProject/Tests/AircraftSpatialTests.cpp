@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/AircraftSpatialGrid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AircraftSpatialTests
+{
+	static constexpr double Extent = 2000000.0;
+
+	static FVector RandomPoint(FRandomStream& Random)
+	{
+		return FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), Random.FRandRange(0.0, 500000.0));
+	}
+
+	/** A grid next to a plain list of where each of its ids is, for checking queries against */
+	struct FPoints
+	{
+		FAircraftSpatialGrid Grid;
+		TArray<FVector> Locations;
+		TArray<bool> bAlive;
+
+		FPoints(int32 NumPoints, double CellSize, FRandomStream& Random)
+			: Grid(CellSize)
+		{
+			for (int32 i = 0; i < NumPoints; ++i)
+			{
+				Locations.Add(RandomPoint(Random));
+				bAlive.Add(true);
+				verify(Grid.Add(Locations.Last()) == i);
+			}
+		}
+
+		template <typename PredicateType>
+		TArray<int32> BruteForce(PredicateType&& Predicate) const
+		{
+			TArray<int32> Ids;
+			for (int32 i = 0; i < Locations.Num(); ++i)
+			{
+				if (bAlive[i] && Predicate(Locations[i]))
+				{
+					Ids.Add(i);
+				}
+			}
+			return Ids;
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAircraftSpatialGridTest, "MyProject.Spatial.Grid.MatchesBruteForce",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FAircraftSpatialGridTest::RunTest(const FString& Parameters)
+{
+	using namespace AircraftSpatialTests;
+	static constexpr int32 NumPoints = 1000;
+	static constexpr int32 NumQueries = 200;
+	static constexpr double Radius = 150000.0;
+	static constexpr double ConeRange = 400000.0;
+	static constexpr double ConeHalfAngle = 30.0;
+	static constexpr int32 NearestCount = 8;
+
+	FRandomStream Random(1234);
+	FPoints Points(NumPoints, 50000.0, Random);
+
+	auto CheckQueries = [&](const TCHAR* Phase)
+	{
+		int32 NumRadiusMismatched = 0;
+		int32 NumConeMismatched = 0;
+		int32 NumNearestMismatched = 0;
+		TArray<int32> Ids;
+
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			const FVector Origin = RandomPoint(Random);
+
+			Points.Grid.QueryRadius(Origin, Radius, Ids);
+			Ids.Sort();
+			NumRadiusMismatched += Ids != Points.BruteForce([&](const FVector& Location) { return FVector::DistSquared(Location, Origin) <= Radius * Radius; });
+
+			const FVector Direction = Random.GetUnitVector();
+			const double CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(ConeHalfAngle));
+			Points.Grid.QueryCone(Origin, Direction, ConeHalfAngle, ConeRange, Ids);
+			Ids.Sort();
+			NumConeMismatched += Ids != Points.BruteForce([&](const FVector& Location)
+			{
+				return FVector::DistSquared(Location, Origin) <= ConeRange * ConeRange && ((Location - Origin).GetSafeNormal() | Direction) >= CosHalfAngle;
+			});
+
+			// The same points as sorting everything by distance, in the same order
+			Points.Grid.QueryNearest(Origin, NearestCount, UE_DOUBLE_BIG_NUMBER, Ids);
+			TArray<int32> Nearest = Points.BruteForce([](const FVector&) { return true; });
+			Nearest.Sort([&](int32 A, int32 B) { return FVector::DistSquared(Points.Locations[A], Origin) < FVector::DistSquared(Points.Locations[B], Origin); });
+			Nearest.SetNum(FMath::Min(NearestCount, Nearest.Num()));
+			NumNearestMismatched += Ids != Nearest;
+		}
+
+		TestEqual(FString::Printf(TEXT("%s: radius queries differing from brute force"), Phase), NumRadiusMismatched, 0);
+		TestEqual(FString::Printf(TEXT("%s: cone queries differing from brute force"), Phase), NumConeMismatched, 0);
+		TestEqual(FString::Printf(TEXT("%s: nearest-%d queries differing from brute force"), Phase, NearestCount), NumNearestMismatched, 0);
+	};
+
+	CheckQueries(TEXT("After adding"));
+
+	// A frame of flight moves most points within their cell, every tenth one jumps somewhere else entirely
+	for (int32 i = 0; i < NumPoints; ++i)
+	{
+		Points.Locations[i] = i % 10 == 0 ? RandomPoint(Random) : Points.Locations[i] + FVector(500.0, -300.0, 50.0);
+		Points.Grid.Update(i, Points.Locations[i]);
+	}
+	CheckQueries(TEXT("After moving"));
+
+	for (int32 i = 0; i < NumPoints; i += 3)
+	{
+		Points.Grid.Remove(i);
+		Points.bAlive[i] = false;
+	}
+	TestEqual(TEXT("Points left after removing"), Points.Grid.Num(), NumPoints - FMath::DivideAndRoundUp(NumPoints, 3));
+	CheckQueries(TEXT("After removing"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAircraftSpatialGridBenchmark, "MyProject.Spatial.Grid.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FAircraftSpatialGridBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace AircraftSpatialTests;
+	static constexpr int32 NumPoints = 1000;
+	static constexpr int32 NumQueries = 1000;
+	static constexpr double Radius = 150000.0;
+
+	// Measure the cell size the game runs with
+	const IConsoleVariable* CellSize = IConsoleManager::Get().FindConsoleVariable(TEXT("ac.Spatial.CellSize"));
+	FRandomStream Random(5678);
+	FPoints Points(NumPoints, CellSize ? CellSize->GetFloat() : 50000.0, Random);
+
+	TArray<FVector> Origins;
+	for (int32 i = 0; i < NumQueries; ++i)
+	{
+		Origins.Add(RandomPoint(Random));
+	}
+
+	TArray<int32> Ids;
+	int64 GridFound = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (const FVector& Origin : Origins)
+	{
+		Points.Grid.QueryRadius(Origin, Radius, Ids);
+		GridFound += Ids.Num();
+	}
+	const double GridRadiusSeconds = FPlatformTime::Seconds() - StartTime;
+
+	int64 BruteFound = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (const FVector& Origin : Origins)
+	{
+		for (const FVector& Point : Points.Locations)
+		{
+			BruteFound += FVector::DistSquared(Point, Origin) <= Radius * Radius;
+		}
+	}
+	const double BruteRadiusSeconds = FPlatformTime::Seconds() - StartTime;
+	TestEqual(TEXT("Points found by grid and brute-force radius queries"), GridFound, BruteFound);
+
+	StartTime = FPlatformTime::Seconds();
+	for (const FVector& Origin : Origins)
+	{
+		Points.Grid.QueryNearest(Origin, 4, UE_DOUBLE_BIG_NUMBER, Ids);
+	}
+	const double GridNearestSeconds = FPlatformTime::Seconds() - StartTime;
+
+	// A frame of flight at 300 m/s, most moves stay inside their cell
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumPoints; ++i)
+	{
+		Points.Locations[i] += FVector(500.0, 0.0, 0.0);
+		Points.Grid.Update(i, Points.Locations[i]);
+	}
+	const double UpdateSeconds = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d points, %d queries: radius grid %.2f us vs brute %.2f us per query, nearest-4 grid %.2f us, update %.3f us per point"),
+		NumPoints, NumQueries, GridRadiusSeconds * 1e6 / NumQueries, BruteRadiusSeconds * 1e6 / NumQueries,
+		GridNearestSeconds * 1e6 / NumQueries, UpdateSeconds * 1e6 / NumPoints));
+	return true;
+}
+
+#endif
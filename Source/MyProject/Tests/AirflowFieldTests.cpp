@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/AirflowFieldSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAirflowFieldBenchmark, "MyProject.Airflow.Field.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FAirflowFieldBenchmark::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumAircraft = 1024;
+	static constexpr int32 NumSteps = 120;
+	static constexpr float StepSeconds = 1.f / 60.f;
+	// Sampled for every aircraft on every step, so it has to stay well under a microsecond
+	static constexpr double BudgetNanoseconds = 1000.0;
+
+	FFlightTestWorld TestWorld;
+	UAirflowFieldSubsystem* Airflow = TestWorld.World->GetSubsystem<UAirflowFieldSubsystem>();
+	if (!TestNotNull(TEXT("Airflow subsystem"), Airflow)) return false;
+
+	FAirflowFieldConfig Config;
+	Config.BaseWind = FVector(20000.0, 5000.0, 0.0);
+	Config.BaseTurbulence = 5000.f;
+	Config.Thermals.Add(FAirflowThermal());
+	Config.Ridges.Add(FAirflowRidge());
+	Airflow->SetConfig(Config);
+	if (!TestFalse(TEXT("Field built"), Airflow->GetField().IsEmpty())) return false;
+	const FAirflowField& Field = Airflow->GetField();
+
+	FRandomStream Random(1234);
+	TArray<FVector> Locations;
+	for (int32 i = 0; i < NumAircraft; ++i)
+	{
+		Locations.Add(FVector(Random.FRandRange(-1000000.0, 1000000.0), Random.FRandRange(-1000000.0, 1000000.0), Random.FRandRange(0.0, 300000.0)));
+	}
+	FEnvAirflow LocalAirflow;
+
+	// Summed into the report so no lookup can be optimised away
+	double Checksum = 0.0;
+	auto TimeNanoseconds = [](TFunctionRef<void(double)> Body)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			Body(Step * StepSeconds);
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1.e9 / (double(NumAircraft) * NumSteps);
+	};
+
+	const double GridNs = TimeNanoseconds([&](double Time)
+	{
+		for (const FVector& Location : Locations)
+		{
+			const FAirflowSample Sample = Field.Sample(Location);
+			Checksum += Sample.Updraft + Sample.Wind.X;
+		}
+	});
+	const double TurbulenceNs = TimeNanoseconds([&](double Time)
+	{
+		for (const FVector& Location : Locations)
+		{
+			Checksum += Field.SampleTurbulence(Location, Time).X;
+		}
+	});
+	// What UFlightSimSubsystem pays per aircraft and step
+	const double EnvironmentNs = TimeNanoseconds([&](double Time)
+	{
+		FVector Turbulence;
+		for (const FVector& Location : Locations)
+		{
+			Checksum += Airflow->SampleEnvironment(LocalAirflow, Location, Time, Turbulence).Updraft;
+		}
+	});
+
+	AddInfo(FString::Printf(TEXT("ns per aircraft-step over %d aircraft: grid %.1f, turbulence %.1f, full environment %.1f (checksum %g)"),
+		NumAircraft, GridNs, TurbulenceNs, EnvironmentNs, Checksum));
+	TestTrue(FString::Printf(TEXT("Environment sample %.1f ns within %.0f ns"), EnvironmentNs, BudgetNanoseconds), EnvironmentNs <= BudgetNanoseconds);
+	return true;
+}
+
+#endif
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Async/ParallelFor.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/FlightDynamics.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightDynamicsIsolationTest, "MyProject.Flight.Dynamics.Isolation",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FFlightDynamicsIsolationTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumBodies = 64;
+	static constexpr int32 NumSteps = 600;
+	static constexpr float StepSeconds = 1.f / 60.f;
+
+	const FAircraftConfig AircraftConfig;
+	const FDroneConfig DroneConfig;
+	const FFlightModel AircraftModel{ EFlightType::Aircraft, AircraftConfig, DroneConfig };
+	const FFlightModel DroneModel{ EFlightType::Drone, AircraftConfig, DroneConfig };
+	const FFlightEnvironment Calm;
+	FRandomStream Random(5678);
+
+	TArray<FFlightControls> Controls;
+	TArray<FFlightBodyState> Initial;
+	for (int32 i = 0; i < NumBodies; ++i)
+	{
+		Controls.Add({ Random.FRand(), FVector2D(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f)), Random.FRandRange(-1.f, 1.f) });
+
+		FFlightBodyState& Body = Initial.AddDefaulted_GetRef();
+		Body.Location = FVector(0.0, 0.0, 100000.0);
+		Body.LinearVelocity = FVector(AircraftConfig.CruiseSpeed, 0.0, 0.0);
+	}
+
+	auto StepBody = [&](int32 Index, FFlightBodyState& Body)
+	{
+		FFlightDynamics::Step(Index % 4 == 0 ? DroneModel : AircraftModel, Controls[Index], Calm, EFlightIntegrator::SemiImplicitEuler, StepSeconds, Body);
+	};
+
+	// Each body on its own: nothing another body does can reach it
+	TArray<FFlightBodyState> Alone = Initial;
+	for (int32 i = 0; i < NumBodies; ++i)
+	{
+		for (int32 Step = 0; Step < NumSteps; ++Step) StepBody(i, Alone[i]);
+	}
+
+	// Every body stepped once before any takes its next step, then the same on all workers at once
+	TArray<FFlightBodyState> Interleaved = Initial;
+	TArray<FFlightBodyState> Parallel = Initial;
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		for (int32 i = 0; i < NumBodies; ++i) StepBody(i, Interleaved[i]);
+		ParallelFor(NumBodies, [&](int32 i) { StepBody(i, Parallel[i]); });
+	}
+
+	auto IsSame = [](const FFlightBodyState& A, const FFlightBodyState& B)
+	{
+		return A.Location == B.Location && A.Rotation == B.Rotation && A.LinearVelocity == B.LinearVelocity
+			&& A.AngularVelocity == B.AngularVelocity && A.ControlAngularVelocity == B.ControlAngularVelocity;
+	};
+
+	int32 NumInterleavedMismatched = 0;
+	int32 NumParallelMismatched = 0;
+	int32 NumIdentical = 0;
+	for (int32 i = 0; i < NumBodies; ++i)
+	{
+		NumInterleavedMismatched += !IsSame(Alone[i], Interleaved[i]);
+		NumParallelMismatched += !IsSame(Alone[i], Parallel[i]);
+		// Different inputs must give different flights
+		NumIdentical += i > 0 && IsSame(Alone[i], Alone[i - 1]);
+	}
+
+	TestEqual(TEXT("Bodies whose interleaved flight differs from flying alone"), NumInterleavedMismatched, 0);
+	TestEqual(TEXT("Bodies whose parallel flight differs from flying alone"), NumParallelMismatched, 0);
+	TestEqual(TEXT("Bodies ending in their neighbour's state"), NumIdentical, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/FlightDynamics.h"
+#include "MyProject/Aircraft/FlightForceKernel.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FlightForceKernelTests
+{
+	/** Random bodies, inputs and environments, every fourth one a drone */
+	struct FCases
+	{
+		FAircraftConfig AircraftConfig;
+		FDroneConfig DroneConfig;
+		TArray<FFlightBodyState> Bodies;
+		TArray<FFlightControls> Controls;
+		TArray<FFlightEnvironment> Environments;
+
+		FCases(int32 NumCases, int32 Seed)
+		{
+			FRandomStream Random(Seed);
+			for (int32 i = 0; i < NumCases; ++i)
+			{
+				FFlightBodyState& Body = Bodies.AddDefaulted_GetRef();
+				Body.Rotation = FRotator(Random.FRandRange(-90.f, 90.f), Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f)).Quaternion();
+				// Some bodies at rest, where the kernel has no velocity direction to work with
+				Body.LinearVelocity = i % 16 == 1 ? FVector::ZeroVector : Random.GetUnitVector() * Random.FRandRange(0.f, 2.f * AircraftConfig.CruiseSpeed);
+
+				Controls.Add({ Random.FRand(), FVector2D(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f)), Random.FRandRange(-1.f, 1.f) });
+
+				FFlightEnvironment& Environment = Environments.AddDefaulted_GetRef();
+				Environment.Wind = Random.GetUnitVector() * Random.FRandRange(0.f, 2000.f);
+				Environment.Updraft = Random.FRandRange(-500.f, 500.f);
+				Environment.Turbulence = Random.GetUnitVector() * Random.FRandRange(0.f, 500.f);
+			}
+		}
+
+		int32 Num() const { return Bodies.Num(); }
+		FFlightModel GetModel(int32 Index) const
+		{
+			return FFlightModel(Index % 4 == 0 ? EFlightType::Drone : EFlightType::Aircraft, AircraftConfig, DroneConfig);
+		}
+
+		void FillBatch(int32 FirstIndex, FFlightForceBatch& Batch) const
+		{
+			for (int32 Lane = 0; Lane < FFlightForceBatch::Lanes; ++Lane)
+			{
+				const int32 Index = FirstIndex + Lane;
+				if (Index < Num())
+				{
+					Batch.SetLane(Lane, GetModel(Index), Bodies[Index], Controls[Index], Environments[Index]);
+				}
+				else
+				{
+					Batch.ClearLane(Lane);
+				}
+			}
+		}
+	};
+
+	static FVector3f GetLaneAccel(const FFlightForceBatch& Batch, int32 Lane)
+	{
+		return FVector3f(Batch.AccelX[Lane], Batch.AccelY[Lane], Batch.AccelZ[Lane]);
+	}
+
+	static bool IsLaneStalled(const FFlightForceBatch& Batch, int32 Lane)
+	{
+		return (Batch.StallMask & (1u << Lane)) != 0;
+	}
+
+	static bool AreForcesNear(const FFlightForces& A, const FFlightForces& B, double Tolerance)
+	{
+		return A.Gravity.Equals(B.Gravity, Tolerance) && A.Lift.Equals(B.Lift, Tolerance) && A.Drag.Equals(B.Drag, Tolerance)
+			&& A.Side.Equals(B.Side, Tolerance) && A.Thrust.Equals(B.Thrust, Tolerance) && A.Environment.Equals(B.Environment, Tolerance);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightForceKernelEquivalenceTest, "MyProject.Flight.ForceKernel.MatchesFlightDynamics",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FFlightForceKernelEquivalenceTest::RunTest(const FString& Parameters)
+{
+	using namespace FlightForceKernelTests;
+	const FCases Cases(4096, 1234);
+
+	int32 NumScalarMismatched = 0;
+	int32 NumVectorMismatched = 0;
+	int32 NumForcesMismatched = 0;
+	for (int32 FirstIndex = 0; FirstIndex < Cases.Num(); FirstIndex += FFlightForceBatch::Lanes)
+	{
+		FFlightForceBatch Scalar;
+		Cases.FillBatch(FirstIndex, Scalar);
+		Scalar.bOutputForces = true;
+		FFlightForceBatch Vectorized = Scalar;
+		FFlightForceKernel::ComputeScalar(Scalar);
+		FFlightForceKernel::ComputeVectorized(Vectorized);
+
+		for (int32 Lane = 0; Lane < FFlightForceBatch::Lanes; ++Lane)
+		{
+			const int32 Index = FirstIndex + Lane;
+			bool bStalled = false;
+			const FVector3f Want(FFlightDynamics::CalculateLinearAcceleration(Cases.GetModel(Index), Cases.Bodies[Index], Cases.Controls[Index],
+				Cases.Environments[Index], bStalled));
+			// The kernel runs in float, the reference in double
+			const float Tolerance = FMath::Max(1.e-3f, Want.Size() * 1.e-4f);
+
+			if (!GetLaneAccel(Scalar, Lane).Equals(Want, Tolerance) || IsLaneStalled(Scalar, Lane) != bStalled)
+			{
+				if (NumScalarMismatched++ == 0)
+				{
+					AddError(FString::Printf(TEXT("Scalar kernel case %d: %s (stalled %d) vs %s (stalled %d)"), Index,
+						*GetLaneAccel(Scalar, Lane).ToString(), IsLaneStalled(Scalar, Lane), *Want.ToString(), bStalled));
+				}
+			}
+			if (!GetLaneAccel(Vectorized, Lane).Equals(Want, Tolerance) || IsLaneStalled(Vectorized, Lane) != bStalled)
+			{
+				if (NumVectorMismatched++ == 0)
+				{
+					AddError(FString::Printf(TEXT("Vectorized kernel case %d: %s (stalled %d) vs %s (stalled %d)"), Index,
+						*GetLaneAccel(Vectorized, Lane).ToString(), IsLaneStalled(Vectorized, Lane), *Want.ToString(), bStalled));
+				}
+			}
+
+			// The breakdown the recorder gets from the kernel, against the model's own
+			const FFlightForces WantForces = FFlightDynamics::CalculateForces(Cases.GetModel(Index), Cases.Bodies[Index], Cases.Controls[Index],
+				Cases.Environments[Index], bStalled);
+			const double ForceTolerance = FMath::Max(1.e-2, WantForces.GetTotal().Size() * 1.e-4);
+			NumForcesMismatched += !AreForcesNear(Scalar.GetLaneForces(Lane), WantForces, ForceTolerance)
+				|| !AreForcesNear(Vectorized.GetLaneForces(Lane), WantForces, ForceTolerance);
+		}
+	}
+
+	TestEqual(TEXT("Cases where the scalar kernel is outside tolerance of FFlightDynamics"), NumScalarMismatched, 0);
+	TestEqual(TEXT("Cases where the vectorized kernel is outside tolerance of FFlightDynamics"), NumVectorMismatched, 0);
+	TestEqual(TEXT("Cases where the kernel's forces by source are outside tolerance of FFlightDynamics::CalculateForces"), NumForcesMismatched, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightForceKernelBenchmark, "MyProject.Flight.ForceKernel.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FFlightForceKernelBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace FlightForceKernelTests;
+	static constexpr int32 NumCases = 4096;
+	static constexpr int32 NumSteps = 200;
+	static constexpr float StepSeconds = 1.f / 60.f;
+	const FCases Cases(NumCases, 5678);
+
+	TArray<FFlightForceBatch> Batches;
+	Batches.SetNum(NumCases / FFlightForceBatch::Lanes);
+	for (int32 Batch = 0; Batch < Batches.Num(); ++Batch)
+	{
+		Cases.FillBatch(Batch * FFlightForceBatch::Lanes, Batches[Batch]);
+	}
+
+	// Summed into the report so no variant can be optimised away
+	double Checksum = 0.0;
+	auto TimeNanoseconds = [&Checksum](TFunctionRef<void()> Body)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			Body();
+		}
+		return (FPlatformTime::Seconds() - StartTime) * 1.e9 / (double(NumCases) * NumSteps);
+	};
+
+	const double PerAircraftNs = TimeNanoseconds([&]()
+	{
+		for (int32 i = 0; i < NumCases; ++i)
+		{
+			bool bStalled = false;
+			Checksum += FFlightDynamics::CalculateLinearAcceleration(Cases.GetModel(i), Cases.Bodies[i], Cases.Controls[i], Cases.Environments[i], bStalled).Z;
+		}
+	});
+	const double ScalarNs = TimeNanoseconds([&]()
+	{
+		for (FFlightForceBatch& Batch : Batches)
+		{
+			FFlightForceKernel::ComputeScalar(Batch);
+			Checksum += Batch.AccelZ[0];
+		}
+	});
+	const double VectorizedNs = TimeNanoseconds([&]()
+	{
+		for (FFlightForceBatch& Batch : Batches)
+		{
+			FFlightForceKernel::ComputeVectorized(Batch);
+			Checksum += Batch.AccelZ[0];
+		}
+	});
+
+	// A whole step through the headless core, forces, controls and integration
+	TArray<FFlightBodyState> Bodies = Cases.Bodies;
+	const double FullStepNs = TimeNanoseconds([&]()
+	{
+		for (int32 i = 0; i < NumCases; ++i)
+		{
+			FFlightDynamics::Step(Cases.GetModel(i), Cases.Controls[i], Cases.Environments[i], EFlightIntegrator::SemiImplicitEuler, StepSeconds, Bodies[i]);
+		}
+	});
+	Checksum += Bodies[0].Location.Z;
+
+	AddInfo(FString::Printf(TEXT("ns per aircraft-step over %d aircraft: FFlightDynamics forces %.2f, scalar kernel %.2f, vectorized kernel %.2f (%.2fx), full step %.2f (checksum %g)"),
+		NumCases, PerAircraftNs, ScalarNs, VectorizedNs, ScalarNs / FMath::Max(VectorizedNs, UE_DOUBLE_SMALL_NUMBER), FullStepNs, Checksum));
+	return true;
+}
+
+#endif
@@ -0,0 +1,322 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightTestWorld.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/AAircraftBase.h"
+#include "UObject/CoreNet.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FlightNetTests
+{
+	/**
+	 * One direction of an emulated connection with a fixed one-way delay and random packet loss, like PktLag and
+	 * PktLoss. Values cross it through their NetSerialize, so what arrives is exactly what the wire carries.
+	 */
+	struct FLossyLink
+	{
+		struct FPacket
+		{
+			double ArrivalTime = 0.0;
+			TArray<uint8> Data;
+			int64 NumBits = 0;
+		};
+
+		double Latency = 0.0;
+		float LossRate = 0.f;
+		FRandomStream Random;
+		TArray<FPacket> InFlight;
+		// Payload only, packet and bunch headers come on top
+		int64 NumBytesSent = 0;
+		int32 NumLost = 0;
+
+		FLossyLink(double InLatency, float InLossRate, int32 Seed)
+			: Latency(InLatency), LossRate(InLossRate), Random(Seed)
+		{
+		}
+
+		template <typename StructType>
+		void Send(double Now, StructType& Value)
+		{
+			FNetBitWriter Writer(nullptr, 1024);
+			bool bSuccess = false;
+			Value.NetSerialize(Writer, nullptr, bSuccess);
+			NumBytesSent += Writer.GetNumBytes();
+			if (Random.FRand() < LossRate)
+			{
+				++NumLost;
+				return;
+			}
+			InFlight.Add({ Now + Latency, TArray<uint8>(Writer.GetData(), Writer.GetNumBytes()), Writer.GetNumBits() });
+		}
+
+		/** Reads every packet due by Now into Target, calling OnReceived after each. The delay is fixed, so they arrive in order */
+		template <typename StructType, typename CallbackType>
+		void Deliver(double Now, StructType& Target, CallbackType&& OnReceived)
+		{
+			int32 NumArrived = 0;
+			for (; NumArrived < InFlight.Num() && InFlight[NumArrived].ArrivalTime <= Now; ++NumArrived)
+			{
+				FNetBitReader Reader(nullptr, InFlight[NumArrived].Data.GetData(), InFlight[NumArrived].NumBits);
+				bool bSuccess = false;
+				Target.NetSerialize(Reader, nullptr, bSuccess);
+				OnReceived();
+			}
+			InFlight.RemoveAt(0, NumArrived);
+		}
+	};
+
+	/** The replicated ServerState of an aircraft, reached through reflection the way replication reaches it */
+	static FServerState& GetServerState(UFPVMovementComponent* MoveComp)
+	{
+		const FStructProperty* Property = FindFProperty<FStructProperty>(UFPVMovementComponent::StaticClass(), TEXT("ServerState"));
+		check(Property);
+		return *Property->ContainerPtrToValuePtr<FServerState>(MoveComp);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightNetLossyLinkTest, "MyProject.Net.Prediction.LossyLink",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FFlightNetLossyLinkTest::RunTest(const FString& Parameters)
+{
+	using namespace FlightNetTests;
+	static constexpr double Latencies[] = { 0.05, 0.15, 0.3 };
+	static constexpr float LossRate = 0.02f;
+	static constexpr int32 NumSeconds = 60;
+
+	// Both copies are stepped by the test and their input frames, not by the batched subsystem
+	FScopedTestCVar Batched(TEXT("ac.Flight.Batched"), TEXT("0"));
+	const float StepSeconds = UFPVMovementComponent::GetNetStepSeconds();
+	const int32 NumFrames = FMath::RoundToInt(NumSeconds / StepSeconds);
+
+	for (const double Latency : Latencies)
+	{
+		FFlightTestWorld TestWorld;
+		UWorld* World = TestWorld.World;
+		const FTransform Spawn(FVector(0.0, 0.0, 100000.0));
+
+		// Server copy: a player's aircraft with no controller on this machine, so it only moves when input frames arrive
+		AAAircraftBase* Server = World->SpawnActor<AAAircraftBase>(AAAircraftBase::StaticClass(), Spawn);
+		Server->SetPlayerState(World->SpawnActor<APlayerState>());
+
+		// Owning client copy: possessed locally, then demoted to an autonomous proxy so it predicts and reconciles
+		AAAircraftBase* Client = World->SpawnActor<AAAircraftBase>(AAAircraftBase::StaticClass(), Spawn);
+		World->SpawnActor<APlayerController>()->Possess(Client);
+		Client->SetRole(ROLE_AutonomousProxy);
+		Client->SetActorTickEnabled(false);
+
+		UFPVMovementComponent* ServerMove = Server->FindComponentByClass<UFPVMovementComponent>();
+		UFPVMovementComponent* ClientMove = Client->FindComponentByClass<UFPVMovementComponent>();
+		if (!TestTrue(TEXT("Server copy is driven by input frames"), ServerMove->IsDrivenByRemoteInputs())
+			|| !TestTrue(TEXT("Client copy is a locally controlled proxy"), Client->IsLocallyControlled() && !Client->HasAuthority()))
+		{
+			return false;
+		}
+
+		UFunction* SendInputs = Server->FindFunctionChecked(TEXT("Server_SendInputs"));
+		UFunction* OnRepServerState = ClientMove->FindFunctionChecked(TEXT("OnRep_ServerState"));
+		FServerState& ServerSide = GetServerState(ServerMove);
+		FServerState& ClientSide = GetServerState(ClientMove);
+
+		FLossyLink Uplink(Latency, LossRate, 1234);
+		FLossyLink Downlink(Latency, LossRate, 5678);
+		FRandomStream Stick(4321);
+		FFlightInputPacket Received;
+		double LastSentStateTime = -1.0;
+		double TimeSinceStateSent = 0.0;
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const double Now = TestWorld.GetTime();
+
+			// The pilot moves the stick twice a second and holds it in between
+			if (Frame % 30 == 0)
+			{
+				Client->SetAerialInputs(Stick.FRand(), FVector2D(Stick.FRandRange(-1.f, 1.f), Stick.FRandRange(-1.f, 1.f)), Stick.FRandRange(-1.f, 1.f));
+			}
+
+			// One predicted step, as AAAircraftBase::Tick runs it on an owning client
+			const FFlightInputFrame Input = Client->MakeInputFrame(ClientMove->ConsumeInputSequence());
+			Client->ApplyInputFrame(Input);
+			Client->SimulateFlightStep(StepSeconds);
+			ClientMove->RecordPredictedMove(Input);
+			ClientMove->CommitMove();
+
+			FFlightInputPacket Packet;
+			if (ClientMove->BuildInputPacket(StepSeconds, Packet))
+			{
+				Uplink.Send(Now, Packet);
+			}
+			Uplink.Deliver(Now, Received, [&]() { Server->ProcessEvent(SendInputs, &Received); });
+
+			// Replication sends a changed state at most at the aircraft's update rate. A lost one is superseded by
+			// the next, which is what resending the property would carry too
+			TimeSinceStateSent += StepSeconds;
+			if (ServerSide.ServerTime != LastSentStateTime && TimeSinceStateSent >= 1.0 / FMath::Max(Server->GetNetUpdateFrequency(), 1.f))
+			{
+				Downlink.Send(Now, ServerSide);
+				LastSentStateTime = ServerSide.ServerTime;
+				TimeSinceStateSent = 0.0;
+			}
+			Downlink.Deliver(Now, ClientSide, [&]() { ClientMove->ProcessEvent(OnRepServerState, nullptr); });
+
+			TestWorld.Tick(StepSeconds);
+		}
+
+		// The server can only be a round trip (plus the idle send interval) behind the client
+		const uint32 MaxBehind = static_cast<uint32>(FMath::CeilToInt((2.0 * Latency + 0.25) / StepSeconds));
+		TestTrue(FString::Printf(TEXT("%.0f ms: server acked frame %u of %d"), Latency * 1000.0, ServerMove->GetLastProcessedInput(), NumFrames),
+			ServerMove->GetLastProcessedInput() + MaxBehind >= static_cast<uint32>(NumFrames));
+
+		AddInfo(FString::Printf(TEXT("%.0f ms one-way, %.0f%% loss, %d s: %d corrections (%.1f per minute), uplink %.0f B/s (%d lost), downlink %.0f B/s (%d lost)"),
+			Latency * 1000.0, LossRate * 100.f, NumSeconds, ClientMove->GetNumCorrections(), ClientMove->GetNumCorrections() * 60.0 / NumSeconds,
+			double(Uplink.NumBytesSent) / NumSeconds, Uplink.NumLost, double(Downlink.NumBytesSent) / NumSeconds, Downlink.NumLost));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightNetStateBandwidthTest, "MyProject.Net.ServerState.Bandwidth",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FFlightNetStateBandwidthTest::RunTest(const FString& Parameters)
+{
+	using namespace FlightNetTests;
+	static constexpr int32 NumAircraft = 32;
+	static constexpr int32 NumSeconds = 20;
+	static constexpr float StepSeconds = 1.f / 60.f;
+
+	FScopedTestCVar Batched(TEXT("ac.Flight.Batched"), TEXT("1"));
+	// 1 sends every state whole, as before fields were left out
+	FScopedTestCVar FullInterval(TEXT("ac.Net.StateFullInterval"), TEXT("1"));
+	double FullBytesPerAircraftSecond = 0.0;
+
+	for (const TCHAR* Interval : { TEXT("1"), TEXT("8") })
+	{
+		FullInterval.Set(Interval);
+
+		FFlightTestWorld TestWorld;
+		FRandomStream Random(2468);
+		TArray<UFPVMovementComponent*> Moves;
+		for (int32 i = 0; i < NumAircraft; ++i)
+		{
+			const FTransform Spawn(FRotator(0.0, Random.FRandRange(-180.f, 180.f), 0.0), FVector(i % 8 * 50000.0, i / 8 * 50000.0, 100000.0));
+			AAAircraftBase* Plane = TestWorld.World->SpawnActor<AAAircraftBase>(AAAircraftBase::StaticClass(), Spawn);
+			// Half the fleet manoeuvres, the other half holds a straight line, where rotation stays put on the wire
+			Plane->SetAerialInputs(0.7f, i % 2 ? FVector2D(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f)) : FVector2D::ZeroVector, 0.f);
+			Moves.Add(Plane->FindComponentByClass<UFPVMovementComponent>());
+		}
+
+		// What each client holds, to check that a state with fields left out still reads back whole
+		TArray<FServerState> Received;
+		Received.SetNum(NumAircraft);
+		TArray<double> LastSentTimes;
+		LastSentTimes.Init(-1.0, NumAircraft);
+		TArray<double> NextSendTimes;
+		NextSendTimes.Init(0.0, NumAircraft);
+		int64 NumBytes = 0;
+		int32 NumStates = 0;
+		int32 NumMismatched = 0;
+		double MeanUpdateHz = 0.0;
+
+		for (int32 Frame = 0; Frame < NumSeconds * 60; ++Frame)
+		{
+			TestWorld.Tick(StepSeconds);
+			const double Now = TestWorld.GetTime();
+
+			for (int32 i = 0; i < NumAircraft; ++i)
+			{
+				// Replication sends a changed state at most at the aircraft's update rate
+				FServerState& State = GetServerState(Moves[i]);
+				const float UpdateHz = FMath::Max(Moves[i]->GetOwner()->GetNetUpdateFrequency(), 1.f);
+				if (State.ServerTime == LastSentTimes[i] || Now < NextSendTimes[i]) continue;
+				LastSentTimes[i] = State.ServerTime;
+				NextSendTimes[i] = Now + 1.0 / UpdateHz;
+				MeanUpdateHz += UpdateHz;
+
+				FNetBitWriter Writer(nullptr, 512);
+				bool bSuccess = false;
+				State.NetSerialize(Writer, nullptr, bSuccess);
+				NumBytes += Writer.GetNumBytes();
+				++NumStates;
+
+				FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+				Received[i].NetSerialize(Reader, nullptr, bSuccess);
+				NumMismatched += !bSuccess || !Received[i].Location.Equals(State.Location, 1.0)
+					|| !Received[i].LinearVelocity.Equals(State.LinearVelocity, 1.0)
+					|| !Received[i].AngularVelocity.Equals(State.AngularVelocity, 0.01)
+					|| Received[i].Rotation.Quaternion().AngularDistance(State.Rotation.Quaternion()) > FMath::DegreesToRadians(0.2);
+			}
+		}
+
+		const double BytesPerAircraftSecond = double(NumBytes) / (NumAircraft * NumSeconds);
+		FullBytesPerAircraftSecond = FullBytesPerAircraftSecond > 0.0 ? FullBytesPerAircraftSecond : BytesPerAircraftSecond;
+		TestEqual(FString::Printf(TEXT("States read back differently (full every %s)"), Interval), NumMismatched, 0);
+		AddInfo(FString::Printf(TEXT("%d aircraft, full state every %s: %.1f bytes per state, %.0f bytes per aircraft per second at %.1f Hz (%.0f%% of always full)"),
+			NumAircraft, Interval, double(NumBytes) / FMath::Max(NumStates, 1), BytesPerAircraftSecond, MeanUpdateHz / FMath::Max(NumStates, 1),
+			100.0 * BytesPerAircraftSecond / FullBytesPerAircraftSecond));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightNetRelevancyRateTest, "MyProject.Net.Relevancy.UpdateRates",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FFlightNetRelevancyRateTest::RunTest(const FString& Parameters)
+{
+	static constexpr float StepSeconds = 1.f / 60.f;
+
+	FScopedTestCVar NearHz(TEXT("ac.Net.NearUpdateHz"), TEXT("60"));
+	FScopedTestCVar FarHz(TEXT("ac.Net.FarUpdateHz"), TEXT("4"));
+	FScopedTestCVar WeaponsRange(TEXT("ac.Net.WeaponsRange"), TEXT("150000"));
+	FScopedTestCVar FarDistance(TEXT("ac.Net.FarDistance"), TEXT("500000"));
+	FScopedTestCVar ViewCone(TEXT("ac.Net.ViewConeDegrees"), TEXT("45"));
+
+	FFlightTestWorld TestWorld;
+	UWorld* World = TestWorld.World;
+
+	// A pilot at the origin looking down +X. Without a local player its camera never updates, so the controller
+	// itself is the view point
+	const FVector ViewPos(0.0, 0.0, 100000.0);
+	APlayerController* Viewer = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), FTransform(ViewPos));
+
+	auto Spawn = [World, &ViewPos](const FVector& Offset)
+	{
+		return World->SpawnActor<AAAircraftBase>(AAAircraftBase::StaticClass(), FTransform(ViewPos + Offset));
+	};
+	AAAircraftBase* InRange = Spawn(FVector(5000.0, 0.0, 0.0));
+	AAAircraftBase* Midway = Spawn(FVector(0.0, 300000.0, 0.0));
+	AAAircraftBase* FarSide = Spawn(FVector(0.0, 2000000.0, 0.0));
+	AAAircraftBase* FarAhead = Spawn(FVector(2000000.0, 0.0, 0.0));
+
+	// Past one relevancy interval
+	for (int32 Frame = 0; Frame < 60; ++Frame)
+	{
+		TestWorld.Tick(StepSeconds);
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	Viewer->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	if (!TestTrue(TEXT("The pilot views from where it was spawned"), ViewLocation.Equals(ViewPos, 1.0))) return false;
+
+	TestEqual(TEXT("Update rate within weapons range"), InRange->GetNetUpdateFrequency(), 60.f);
+	TestEqual(TEXT("Update rate in the view cone beyond the far distance"), FarAhead->GetNetUpdateFrequency(), 60.f);
+	TestEqual(TEXT("Update rate beyond the far distance outside the view cone"), FarSide->GetNetUpdateFrequency(), 4.f);
+	TestTrue(FString::Printf(TEXT("Update rate between weapons range and the far distance (%.1f Hz) is between the two"), Midway->GetNetUpdateFrequency()),
+		Midway->GetNetUpdateFrequency() > 4.f && Midway->GetNetUpdateFrequency() < 60.f);
+
+	// Per-connection priority, as the net driver asks for it
+	auto PriorityOf = [&](AActor* Plane)
+	{
+		return Plane->GetNetPriority(ViewLocation, ViewRotation.Vector(), Viewer, Viewer, nullptr, 1.f, false);
+	};
+	TestTrue(TEXT("Priority within weapons range is above a distant aircraft off to the side"), PriorityOf(InRange) > PriorityOf(FarSide));
+	TestTrue(TEXT("Priority in the view cone is above a distant aircraft off to the side"), PriorityOf(FarAhead) > PriorityOf(FarSide));
+	return true;
+}
+
+#endif
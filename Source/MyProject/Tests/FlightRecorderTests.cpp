@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "HAL/IConsoleManager.h"
+#include "MyProject/Aircraft/FlightDynamics.h"
+#include "MyProject/Aircraft/FlightRecorder.h"
+#include "MyProject/Aircraft/FPVMovementComponent.h"
+#include "MyProject/GCore/Config/AirframeAsset.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlightRecorderOverheadTest, "MyProject.Flight.Recorder.Overhead",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FFlightRecorderOverheadTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumSteps = 100000;
+	// Largest fleet MyProject.Flight.Sim.FrameTime runs, every aircraft recording
+	static constexpr int32 NumAircraft = 1024;
+	static constexpr double MaxFrameShare = 0.01;
+
+	const FFlightModel Model(UAirframeAsset::GetFallback());
+	const FFlightControls Controls{ 0.8f, FVector2D(0.3f, -0.2f), 0.1f };
+	const FFlightEnvironment Environment;
+	const float StepSeconds = UFPVMovementComponent::GetNetStepSeconds();
+
+	const IConsoleVariable* RecorderSeconds = IConsoleManager::Get().FindConsoleVariable(TEXT("ac.Recorder.Seconds"));
+	if (!TestNotNull(TEXT("ac.Recorder.Seconds"), RecorderSeconds)) return false;
+	FFlightRecorder Recorder(FMath::CeilToInt32(RecorderSeconds->GetFloat() / StepSeconds));
+	FFlightBodyState Body;
+	Body.LinearVelocity = FVector(5000.0, 0.0, 0.0);
+
+	// Same work the flight paths add per step while recording: the forces come out of the step itself, only the ring write is extra
+	bool bStalled = false;
+	const FFlightForces Forces = FFlightDynamics::CalculateForces(Model, Body, Controls, Environment, bStalled);
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumSteps; ++i)
+	{
+		Recorder.RecordStep(i * StepSeconds, i, Controls, Forces, bStalled, Body);
+	}
+	const double RecordNs = (FPlatformTime::Seconds() - StartTime) * 1e9 / NumSteps;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumSteps; ++i)
+	{
+		FFlightDynamics::Step(Model, Controls, Environment, EFlightIntegrator::SemiImplicitEuler, StepSeconds, Body);
+	}
+	const double StepNs = (FPlatformTime::Seconds() - StartTime) * 1e9 / NumSteps;
+
+	// Share of every second (and so of every frame) spent recording at the fixed step rate
+	const double StepShare = RecordNs / FMath::Max(StepNs, UE_DOUBLE_SMALL_NUMBER);
+	const double FrameShare = NumAircraft * (1.0 / StepSeconds) * RecordNs * 1e-9;
+	AddInfo(FString::Printf(TEXT("%d steps: record %.1f ns, simulate %.1f ns per step (%.0f%% on top of the step). %d aircraft at %.0f Hz: %.3f%% of frame time, %.1f KB of rings each (checksum %g)"),
+		NumSteps, RecordNs, StepNs, StepShare * 100.0, NumAircraft, 1.0 / StepSeconds, FrameShare * 100.0, Recorder.GetAllocatedSize() / 1024.0, Body.Location.Z));
+	TestTrue(FString::Printf(TEXT("Recording %.3f%% of frame time within %.0f%%"), FrameShare * 100.0, MaxFrameShare * 100.0), FrameShare <= MaxFrameShare);
+	return true;
+}
+
+#endif
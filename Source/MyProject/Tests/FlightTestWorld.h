@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+
+/**
+ * Empty standalone game world for automation tests. World subsystems are created with it, spawned actors begin
+ * play, and time only advances when the test calls Tick.
+ */
+struct FFlightTestWorld
+{
+	UWorld* World = nullptr;
+
+	FFlightTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("FlightTestWorld"));
+		GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+		// There is no game mode to start play, so actors are told directly
+		if (!World->HasBegunPlay())
+		{
+			World->GetWorldSettings()->NotifyBeginPlay();
+		}
+	}
+
+	~FFlightTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	FFlightTestWorld(const FFlightTestWorld&) = delete;
+	FFlightTestWorld& operator=(const FFlightTestWorld&) = delete;
+
+	void Tick(float DeltaSeconds) { World->Tick(LEVELTICK_All, DeltaSeconds); }
+	double GetTime() const { return World->GetTimeSeconds(); }
+};
+
+/** Overrides a console variable for the lifetime of a test and restores the previous value afterwards */
+struct FScopedTestCVar
+{
+	IConsoleVariable* Variable = nullptr;
+	FString PreviousValue;
+
+	FScopedTestCVar(const TCHAR* Name, const TCHAR* Value)
+		: Variable(IConsoleManager::Get().FindConsoleVariable(Name))
+	{
+		check(Variable);
+		PreviousValue = Variable->GetString();
+		Variable->Set(Value, ECVF_SetByCode);
+	}
+
+	~FScopedTestCVar()
+	{
+		Variable->Set(*PreviousValue, ECVF_SetByCode);
+	}
+
+	FScopedTestCVar(const FScopedTestCVar&) = delete;
+	FScopedTestCVar& operator=(const FScopedTestCVar&) = delete;
+
+	void Set(const TCHAR* Value) { Variable->Set(Value, ECVF_SetByCode); }
+};
+
+#endif
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightTestWorld.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/CollisionProfile.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/AAircraftBase.h"
+#include "MyProject/Aircraft/FlightSimSubsystem.h"
+#include "MyProject/Arsenal/AWeaponBase.h"
+#include "MyProject/Arsenal/ProjectileSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLagCompensationFireTest, "MyProject.Weapons.LagCompensation.RewoundHits",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::ProductFilter)
+
+bool FLagCompensationFireTest::RunTest(const FString& Parameters)
+{
+	static constexpr float StepSeconds = 1.f / 60.f;
+	// 100 cm target crossing the line of fire at 20 m/s: 50 ms of latency already moves it a full width
+	static constexpr double TargetSpeed = 2000.0;
+	static constexpr double ShotRange = 1000.0;
+	static constexpr double Latencies[] = { 0.05, 0.15, 0.25 };
+
+	FFlightTestWorld TestWorld;
+	UWorld* World = TestWorld.World;
+	UProjectileSubsystem* Projectiles = World->GetSubsystem<UProjectileSubsystem>();
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("Projectile subsystem"), Projectiles) || !TestNotNull(TEXT("Cube mesh"), Cube)) return false;
+
+	// The target is moved by the test alone, so its pose at any time is known exactly
+	auto TargetLocationAt = [](double Time) { return FVector(0.0, TargetSpeed * Time, 0.0); };
+	AAAircraftBase* Target = World->SpawnActorDeferred<AAAircraftBase>(AAAircraftBase::StaticClass(), FTransform(TargetLocationAt(TestWorld.GetTime())));
+	Target->PlaneMeshAsset = Cube;
+	Target->FinishSpawning(FTransform(TargetLocationAt(TestWorld.GetTime())));
+	if (UFlightSimSubsystem* FlightSim = World->GetSubsystem<UFlightSimSubsystem>())
+	{
+		FlightSim->UnregisterAircraft(Target);
+	}
+	Target->SetActorTickEnabled(false);
+
+	AAWeaponBase* Weapon = World->SpawnActor<AAWeaponBase>(AAWeaponBase::StaticClass(), FTransform::Identity);
+
+	AActor* HitActor = nullptr;
+	Projectiles->OnRoundHit.AddLambda([&HitActor](const FHitResult& Hit, bool bAuthoritative)
+	{
+		HitActor = Hit.GetActor();
+	});
+
+	auto Advance = [&](int32 NumFrames)
+	{
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			Target->SetActorLocation(TargetLocationAt(TestWorld.GetTime() + StepSeconds));
+			TestWorld.Tick(StepSeconds);
+		}
+	};
+	// A client aiming at what it saw at ViewTime: the round crosses the target's track during the next frame,
+	// which the server resolves against the target as of one frame after ViewTime
+	auto AimAt = [&](double ViewTime)
+	{
+		const FVector Aim = TargetLocationAt(ViewTime + StepSeconds);
+		Weapon->SetActorLocationAndRotation(Aim - FVector(ShotRange, 0.0, 0.0), FRotator::ZeroRotator);
+	};
+
+	// Fill the rewind history
+	Advance(30);
+
+	for (const double Latency : Latencies)
+	{
+		const double ViewTime = TestWorld.GetTime() - Latency;
+
+		HitActor = nullptr;
+		AimAt(ViewTime);
+		Weapon->Server_Fire(ViewTime);
+		Advance(10);
+		TestTrue(FString::Printf(TEXT("Shot seen %.0f ms late hits through Server_Fire"), Latency * 1000.0), HitActor == Target);
+
+		// Same aim without compensation: the target has moved on
+		HitActor = nullptr;
+		AimAt(TestWorld.GetTime() - Latency);
+		Weapon->FireAuthoritative(0.f);
+		Advance(10);
+		TestTrue(FString::Printf(TEXT("Shot seen %.0f ms late misses without rewind"), Latency * 1000.0), HitActor != Target);
+	}
+
+	// A wall between the shooter and where the target was seen stops a rewound round
+	const double ViewTime = TestWorld.GetTime() - Latencies[1];
+	HitActor = nullptr;
+	AimAt(ViewTime);
+
+	AStaticMeshActor* Wall = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(),
+		FTransform(Weapon->GetActorLocation() + FVector(ShotRange * 0.5, 0.0, 0.0)));
+	Wall->SetMobility(EComponentMobility::Movable);
+	Wall->GetStaticMeshComponent()->SetStaticMesh(Cube);
+	Wall->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+
+	Weapon->Server_Fire(ViewTime);
+	Advance(10);
+	TestTrue(TEXT("Rewound round stops at the wall in front of the target"), HitActor == Wall);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Arsenal/ProjectileSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FProjectileBudgetTest, "MyProject.Weapons.Projectiles.Budget",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FProjectileBudgetTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumRounds = 10000;
+	static constexpr double BudgetMilliseconds = 2.0;
+	static constexpr float StepSeconds = 1.f / 60.f;
+	static constexpr int32 NumWarmupFrames = 10;
+	static constexpr int32 NumFrames = 120;
+
+	FFlightTestWorld TestWorld;
+	UProjectileSubsystem* Projectiles = TestWorld.World->GetSubsystem<UProjectileSubsystem>();
+	if (!TestNotNull(TEXT("Projectile subsystem"), Projectiles)) return false;
+
+	// Invisible rounds that outlive the measurement, in every direction so none leave early
+	FProjectileConfig Config;
+	Config.Lifetime = 60.f;
+	FRandomStream Random(1234);
+	for (int32 i = 0; i < NumRounds; ++i)
+	{
+		Projectiles->FireRound(Config, FVector::ZeroVector, Random.GetUnitVector() * Config.MuzzleSpeed, nullptr, true);
+	}
+
+	double TotalMilliseconds = 0.0;
+	double WorstMilliseconds = 0.0;
+	for (int32 Frame = 0; Frame < NumWarmupFrames + NumFrames; ++Frame)
+	{
+		TestWorld.Tick(StepSeconds);
+		if (Frame < NumWarmupFrames) continue;
+
+		TotalMilliseconds += Projectiles->GetLastTickMilliseconds();
+		WorstMilliseconds = FMath::Max(WorstMilliseconds, Projectiles->GetLastTickMilliseconds());
+	}
+
+	const double MeanMilliseconds = TotalMilliseconds / NumFrames;
+	AddInfo(FString::Printf(TEXT("%d rounds: %.3f ms mean, %.3f ms worst game-thread time per frame (budget %.1f ms)"),
+		Projectiles->GetNumLiveRounds(), MeanMilliseconds, WorstMilliseconds, BudgetMilliseconds));
+	TestEqual(TEXT("Live rounds"), Projectiles->GetNumLiveRounds(), NumRounds);
+	TestTrue(FString::Printf(TEXT("Mean frame %.3f ms within %.1f ms"), MeanMilliseconds, BudgetMilliseconds), MeanMilliseconds <= BudgetMilliseconds);
+	return true;
+}
+
+#endif
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlightTestWorld.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/CollisionProfile.h"
+#include "Misc/AutomationTest.h"
+#include "MyProject/Aircraft/TerrainHeightfieldSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTerrainHeightfieldBenchmark, "MyProject.Terrain.Heightfield.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FTerrainHeightfieldBenchmark::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumQueries = 10000;
+	static constexpr int32 GridSize = 3;
+	// Engine cube is 100 cm, so each block is 100 m wide
+	static constexpr double BlockScale = 100.0;
+	static constexpr double BlockSize = BlockScale * 100.0;
+	static constexpr int32 MaxBakeFrames = 100;
+
+	// The whole bake in one frame, the test only cares about the result
+	FScopedTestCVar BakeBudget(TEXT("ac.Terrain.BakeBudgetMs"), TEXT("10000"));
+
+	FFlightTestWorld TestWorld;
+	UWorld* World = TestWorld.World;
+	UTerrainHeightfieldSubsystem* Terrain = World->GetSubsystem<UTerrainHeightfieldSubsystem>();
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (!TestNotNull(TEXT("Terrain subsystem"), Terrain) || !TestNotNull(TEXT("Cube mesh"), Cube)) return false;
+
+	// Static ground with steps and slopes, the trace-baked fallback used on maps without a landscape
+	FRandomStream Random(1234);
+	for (int32 X = 0; X < GridSize; ++X)
+	{
+		for (int32 Y = 0; Y < GridSize; ++Y)
+		{
+			const FVector Location((X - GridSize / 2) * BlockSize, (Y - GridSize / 2) * BlockSize, Random.FRandRange(-2000.0, 2000.0));
+			const FRotator Slope(Random.FRandRange(-10.0, 10.0), 0.0, Random.FRandRange(-10.0, 10.0));
+			// Slightly oversized so tilted neighbours overlap instead of leaving gaps a trace could fall through
+			const FVector Scale(BlockScale * 1.05, BlockScale * 1.05, 10.0);
+			AStaticMeshActor* Block = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform(Slope, Location, Scale));
+			Block->SetMobility(EComponentMobility::Movable);
+			Block->GetStaticMeshComponent()->SetStaticMesh(Cube);
+			Block->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		}
+	}
+
+	Terrain->Bake();
+	for (int32 Frame = 0; Frame < MaxBakeFrames && Terrain->IsBaking(); ++Frame)
+	{
+		TestWorld.Tick(1.f / 60.f);
+	}
+	const FTerrainHeightfield& Heightfield = Terrain->GetHeightfield();
+	if (!TestFalse(TEXT("Heightfield baked"), Heightfield.IsEmpty())) return false;
+
+	// Inside the ground, clear of the slanted outer edges
+	const double Extent = (GridSize * 0.5 - 0.25) * BlockSize;
+	TArray<FVector> Points;
+	for (int32 i = 0; i < NumQueries; ++i)
+	{
+		Points.Add(FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), 0.0));
+	}
+
+	TArray<FTerrainSample> Samples;
+	Samples.SetNum(NumQueries);
+	double StartTime = FPlatformTime::Seconds();
+	Heightfield.SampleBatch(Points, Samples);
+	const double HeightfieldSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FCollisionQueryParams Params(SCENE_QUERY_STAT(TerrainBenchmark), false);
+	double TotalError = 0.0;
+	int32 NumHits = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < NumQueries; ++i)
+	{
+		FHitResult Hit;
+		if (World->LineTraceSingleByChannel(Hit, Points[i] + FVector(0.0, 0.0, 1000000.0), Points[i] - FVector(0.0, 0.0, 1000000.0), ECC_Visibility, Params))
+		{
+			TotalError += FMath::Abs(Hit.ImpactPoint.Z - Samples[i].Height);
+			++NumHits;
+		}
+	}
+	const double TraceSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const double HeightfieldNs = HeightfieldSeconds * 1e9 / NumQueries;
+	const double TraceNs = TraceSeconds * 1e9 / NumQueries;
+	const FTerrainMemoryStats Stats = Heightfield.GetMemoryStats();
+	AddInfo(FString::Printf(TEXT("%d queries: heightfield %.1f ns, line trace %.1f ns per query (%.0fx), mean error %.1f cm over %d hits"),
+		NumQueries, HeightfieldNs, TraceNs, TraceNs / FMath::Max(HeightfieldNs, UE_DOUBLE_SMALL_NUMBER), TotalError / FMath::Max(NumHits, 1), NumHits));
+	AddInfo(FString::Printf(TEXT("Memory: %d tiles (%d flat, %d half, %d full), %.1f KB, dense float grid would be %.1f KB"),
+		Stats.NumTiles, Stats.NumFlatTiles, Stats.NumHalfTiles, Stats.NumFullTiles, Stats.AllocatedBytes / 1024.0, Stats.DenseFloatBytes / 1024.0));
+	TestEqual(TEXT("Line traces hitting the ground"), NumHits, NumQueries);
+	TestTrue(FString::Printf(TEXT("Heightfield %.1f ns faster than line trace %.1f ns"), HeightfieldNs, TraceNs), HeightfieldNs < TraceNs);
+	return true;
+}
+
+#endif